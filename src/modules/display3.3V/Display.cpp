@@ -245,7 +245,7 @@ void Display::printLine(uint8_t line, const char text[], uint8_t start, uint8_t
 		} else if (align == LCD_ALIGN_RIGHT) {
 			space_start = 0;
 			space_end = (strlen(text) < length) ? length - strlen(text) : 0;
-			strncpy(full_text + space_end, text, length - space_end);
+			memcpy(full_text + space_end, text, length - space_end);
 		} else {
 			Serial.println("ERROR: unsupported alignment");
 		}
@@ -259,7 +259,7 @@ void Display::printLine(uint8_t line, const char text[], uint8_t start, uint8_t
 		if (n_pages > 1 && line == lines && end == cols && length >= 3) {
 			if (debug_display)
 				Serial.printlnf("DEBUG: updating paging info with current page %d", current_page);
-			snprintf(full_text + length - 3, 4, "  %d", current_page);
+			snprintf(full_text + length - 3, 4, "  %u", (uint8_t) current_page % 10);
 			if (current_page == n_pages)
 				full_text[length - 2] = LCD_UP_ARROW;
 			else 
@@ -340,12 +340,10 @@ void Display::resetBuffer() {
 }
 
 void Display::addToBuffer(char* add) {
-  if (buffer[0] == 0) {
-    strncpy(buffer, add, sizeof(buffer));
-  } else {
-    snprintf(buffer, sizeof(buffer),
-        "%s%s", buffer, add);
-  }
+  // appended in place (snprintf from the buffer into itself is undefined)
+  size_t length = strlen(buffer);
+  strncpy(buffer + length, add, sizeof(buffer) - length - 1);
+  buffer[sizeof(buffer) - 1] = 0;
 }
 
 void Display::addToBuffer(byte add) {
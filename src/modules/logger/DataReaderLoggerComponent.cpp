@@ -31,7 +31,7 @@ void DataReaderLoggerComponent::update() {
                 data_read_status = DATA_READ_REQUEST;
                 if (ctrl->debug_data) {
                     Serial.printf("DEBUG: time for data request for component '%s' at %ld / ", id, millis());
-                    Serial.println(Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z"));
+                    Serial.println(ctrl->timestamp.getDateTime());
                 }
             } else {
                 // idle data read but not yet time for a new request
@@ -78,7 +78,7 @@ void DataReaderLoggerComponent::returnToIdle() {
     if (sequential) ctrl->sequential_data_read_in_progress = false;
     if (ctrl->debug_data) {
         Serial.printf("DEBUG: returning to idle for component '%s' at %ld / ", id, millis());
-        Serial.println(Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z"));
+        Serial.println(ctrl->timestamp.getDateTime());
     }
 }
 
@@ -98,7 +98,7 @@ void DataReaderLoggerComponent::initiateDataRead() {
                 Serial.printf("DEBUG: starting data read for parallel component '%s' ", id);
         }
         Serial.printf("at %ld / ", millis());
-        Serial.println(Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z"));
+        Serial.println(ctrl->timestamp.getDateTime());
     }
     // keep track of sequential readers' activity
     if (sequential) {
@@ -120,7 +120,7 @@ void DataReaderLoggerComponent::readData() {
 void DataReaderLoggerComponent::completeDataRead() {
     if (ctrl->debug_data) {
         Serial.printf("DEBUG: finished data read with %d errors for component '%s' at ", error_counter, id);
-        Serial.println(Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z"));
+        Serial.println(ctrl->timestamp.getDateTime());
     }
     returnToIdle();
     finishData();
@@ -131,7 +131,7 @@ void DataReaderLoggerComponent::completeDataRead() {
 void DataReaderLoggerComponent::registerDataReadError() {
     error_counter++;
     Serial.printf("ERROR: component '%s' encountered an error (#%d) trying to read data at ", id, error_counter);
-    Serial.println(Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z"));
+    Serial.println(ctrl->timestamp.getDateTime());
     ctrl->lcd->printLineTemp(1, "ERR: read error");
 }
 
@@ -139,14 +139,14 @@ void DataReaderLoggerComponent::handleDataReadTimeout() {
     (triggered_read_attempts > 0) ?
         Serial.printf("WARNING: triggered data reading period exceeded with %d errors for component '%s' (%d attempts left) at ", error_counter, id, triggered_read_attempts - 1) :
         Serial.printf("WARNING: data reading period exceeded with %d errors for component '%s' at ", error_counter, id);
-    Serial.println(Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z"));
+    Serial.println(ctrl->timestamp.getDateTime());
     ctrl->lcd->printLineTemp(1, "ERR: timeout read");
     returnToIdle();
 }
 
 void DataReaderLoggerComponent::handleFailedTriggeredDataRead() {
     Serial.printf("ERROR: failed triggered data read for component '%s' at ", id);
-    Serial.println(Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z"));
+    Serial.println(ctrl->timestamp.getDateTime());
     ctrl->lcd->printLineTemp(1, "ERR: failed read");
 }
 
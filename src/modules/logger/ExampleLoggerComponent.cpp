@@ -17,27 +17,24 @@ void ExampleLoggerComponent::init() {
 /*** state management ***/
 
 size_t ExampleLoggerComponent::getStateSize() { 
-    return(sizeof(*state));
+    return(persistent_state.getSize());
+}
+
+size_t ExampleLoggerComponent::getLegacyStateSize() { 
+    return(persistent_state.getLegacySize());
 }
 
 void ExampleLoggerComponent::saveState() { 
-    EEPROM.put(eeprom_start, *state);
+    state_changed = true; // state variable & display info out of date
+    persistent_state.save(eeprom_start);
     if (ctrl->debug_state) {
         Serial.printf("DEBUG: component '%s' state saved in memory (if any updates were necessary)\n", id);
     }
 } 
 
 bool ExampleLoggerComponent::restoreState() {
-    ExampleState *saved_state = new ExampleState();
-    EEPROM.get(eeprom_start, *saved_state);
-    bool recoverable = saved_state->version == state->version;
-    if(recoverable) {
-        EEPROM.get(eeprom_start, *state);
-        Serial.printf("INFO: successfully restored component state from memory (state version %d)\n", state->version);
-    } else {
-        Serial.printf("INFO: could not restore state from memory (found state version %d instead of %d), sticking with initial default\n", saved_state->version, state->version);
-        saveState();
-    }
+    bool recoverable = persistent_state.restore(eeprom_start, getLegacyState());
+    if (!recoverable) saveState();
     return(recoverable);
 }
 
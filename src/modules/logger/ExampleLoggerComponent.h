@@ -14,6 +14,12 @@ struct ExampleState {
   ExampleState(bool setting) : setting(setting) {}
 };
 
+// EEPROM record of the state (ids of the fields and bytes reserved in each slot, with room for new fields)
+#define EXAMPLE_STATE_RECORD 8
+static const StateField example_state_fields[] = {
+  STATE_FIELD(1, ExampleState, setting)
+};
+
 /*** state variable formatting ***/
 
 static void getStateSettingText(bool setting, char* target, int size, char* pattern, bool include_key = true) {
@@ -32,11 +38,14 @@ class ExampleLoggerComponent : public DataReaderLoggerComponent
   private:
 
     ExampleState *state;
+    PersistentState<ExampleState> persistent_state; // EEPROM slots of the state
 
   public:
     
     /*** constructors ***/
-    ExampleLoggerComponent (const char *id, LoggerController *ctrl, ExampleState *state) : DataReaderLoggerComponent(id, ctrl, true), state(state) {}
+    ExampleLoggerComponent (const char *id, LoggerController *ctrl, ExampleState *state) : DataReaderLoggerComponent(id, ctrl, true), state(state), persistent_state(state, example_state_fields, EXAMPLE_STATE_RECORD) {
+      persistent_state.setLegacyLayout<ExampleState>(3, example_state_fields); // raw struct before the state slots
+    }
 
     /*** setup ***/
     virtual uint8_t setupDataVector(uint8_t start_idx);
@@ -44,6 +53,7 @@ class ExampleLoggerComponent : public DataReaderLoggerComponent
 
     /*** state management ***/
     virtual size_t getStateSize();
+    virtual size_t getLegacyStateSize();
     virtual void saveState();
     virtual bool restoreState();
     virtual void resetState();
@@ -0,0 +1,117 @@
+#pragma once
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+/**** BOUNDED STRING BUILDER ****/
+
+// appends to a fixed char buffer while tracking the write position
+// (no rescanning of the existing content, no overlapping source/destination like snprintf(buf, size, "%s,%s", buf, info))
+// content that does not fit is cut off at the end of the buffer and the buffer is flagged as truncated
+class LoggerBuffer {
+
+  private:
+
+    char* buffer;
+    size_t size;
+    size_t pos = 0;
+    bool truncated = false;
+
+  public:
+
+    // wrap an existing char array
+    LoggerBuffer (char* buffer, size_t size) : buffer(buffer), size(size) { reset(); }
+    template<size_t N> LoggerBuffer (char (&buffer)[N]) : LoggerBuffer(buffer, N) {}
+
+    // clear the buffer
+    void reset() {
+      pos = 0;
+      truncated = false;
+      if (size > 0) buffer[0] = 0;
+    }
+
+    // go back to an earlier position (drops everything after it)
+    void rewind(size_t to) {
+      if (to < pos) {
+        pos = to;
+        buffer[pos] = 0;
+        truncated = false;
+      }
+    }
+
+    // append text (as much as fits)
+    // @return false if the text did not fully fit
+    bool add(const char* text) {
+      return(add(text, strlen(text)));
+    }
+
+    bool add(const char* text, size_t length) {
+      if (size == 0) {
+        truncated = truncated || length > 0;
+        return(length == 0);
+      }
+      size_t n = length < remaining() ? length : remaining();
+      memcpy(buffer + pos, text, n);
+      pos += n;
+      buffer[pos] = 0;
+      if (n < length) truncated = true;
+      return(n == length);
+    }
+
+    bool add(char c) {
+      return(add(&c, 1));
+    }
+
+    // append text as the next item of a list (separator only if the buffer is not empty)
+    bool addItem(const char* text, char separator = ',') {
+      if (pos > 0 && !add(separator)) return(false);
+      return(add(text));
+    }
+
+    // append text as the next item of a list only if it fits entirely (otherwise the buffer is flagged as truncated)
+    bool addWholeItem(const char* text, char separator = ',') {
+      if (strlen(text) + (pos > 0 ? 1 : 0) > remaining()) {
+        truncated = true;
+        return(false);
+      }
+      return(addItem(text, separator));
+    }
+
+    // append formatted text (as much as fits)
+    bool addf(const char* format, ...) {
+      va_list args;
+      va_start(args, format);
+      bool success = vaddf(format, args);
+      va_end(args);
+      return(success);
+    }
+
+    bool vaddf(const char* format, va_list args) {
+      if (size == 0) {
+        truncated = true;
+        return(false);
+      }
+      int n = vsnprintf(buffer + pos, remaining() + 1, format, args);
+      if (n < 0) {
+        // encoding error, discard this piece
+        buffer[pos] = 0;
+        truncated = true;
+        return(false);
+      } else if ((size_t) n > remaining()) {
+        pos = size - 1;
+        truncated = true;
+        return(false);
+      }
+      pos += n;
+      return(true);
+    }
+
+    // status
+    const char* c_str() const { return(buffer); }
+    size_t length() const { return(pos); }
+    size_t capacity() const { return(size > 0 ? size - 1 : 0); } // max number of characters (excluding the terminating 0)
+    size_t remaining() const { return(capacity() - pos); }
+    bool isEmpty() const { return(pos == 0); }
+    bool isTruncated() const { return(truncated); }
+
+};
@@ -6,12 +6,21 @@
 void LoggerCommand::load(String& command_string) {
   reset();
   command_string.toCharArray(command, sizeof(command));
-  strcpy(buffer, command);
+  tokenize();
+}
+
+void LoggerCommand::load(const char* command_text) {
+  reset();
+  strncpy(command, command_text, sizeof(command) - 1);
+  command[sizeof(command) - 1] = 0;
+  tokenize();
 }
 
 void LoggerCommand::reset() {
-  buffer[0] = 0;
   command[0] = 0;
+  n_tokens = 0;
+  next_token = 0;
+  variable[0] = 0;
   value[0] = 0;
   units[0] = 0;
   notes[0] = 0;
@@ -23,33 +32,37 @@ void LoggerCommand::reset() {
   ret_val = CMD_RET_UNDEFINED;
 }
 
-// capture command excerpt (until space #n_space) in param
-// using char array pointers instead of String to make sure we don't get memory leaks here
+// split the command at every space (once per command, extracting tokens later does not touch the command)
+void LoggerCommand::tokenize() {
+  n_tokens = 0;
+  next_token = 0;
+  if (command[0] == 0) return;
+  uint8_t start = 0;
+  for (uint8_t i = 0; ; i++) {
+    if (command[i] == ' ' || command[i] == 0) {
+      token_starts[n_tokens] = start;
+      token_lengths[n_tokens] = i - start;
+      n_tokens++;
+      if (command[i] == 0 || n_tokens == CMD_MAX_TOKENS) break;
+      start = i + 1;
+    }
+  }
+}
+
+// capture the next n_space tokens (incl. the spaces between them) in param and move on to the token after
 // providing size to be sure to be on the safe side
 void LoggerCommand::extractParam(char* param, uint size, uint n_space) {
-  uint space = strcspn(buffer, " ");
-  // skip to later spaces
-  if (n_space > 1) {
-    for(uint s = 2; s <= n_space; s+=1) {
-      space += strcspn(buffer + space + 1, " ") + 1;
-    }
+  if (next_token >= n_tokens || n_space == 0) {
+    param[0] = 0;
+    return;
   }
+  uint8_t last = (next_token + n_space < n_tokens) ? next_token + n_space - 1 : n_tokens - 1;
+  uint length = token_starts[last] + token_lengths[last] - token_starts[next_token];
   // size safety check
-  if (space < size) {
-    strncpy (param, buffer, space);
-    param[space] = 0;
-  } else {
-    strncpy (param, buffer, size);
-    param[size] = 0;
-  }
-  // clean up buffer
-  if (space == strlen(buffer)) {
-    buffer[0] = 0;
-  } else {
-    for(uint i = space+1; i <= strlen(buffer); i+=1) {
-      buffer[i-space-1] = buffer[i];
-    }
-  }
+  if (length >= size) length = size - 1;
+  memcpy(param, command + token_starts[next_token], length);
+  param[length] = 0;
+  next_token = last + 1;
 }
 
 // assigns the next extractable parameter to variable
@@ -67,9 +80,35 @@ void LoggerCommand::extractUnits(uint n_space) {
   extractParam(units, sizeof(units), n_space);
 }
 
-// takes the remainder of the command buffer and assigns it to the message
+// takes the remainder of the command (from the next token on) and assigns it to the message
 void LoggerCommand::assignNotes() {
-  strncpy(notes, buffer, sizeof(notes));
+  if (next_token >= n_tokens) {
+    notes[0] = 0;
+    return;
+  }
+  strncpy(notes, command + token_starts[next_token], sizeof(notes) - 1);
+  notes[sizeof(notes) - 1] = 0;
+}
+
+uint8_t LoggerCommand::getTokenCount() {
+  return(n_tokens);
+}
+
+// token i (not 0-terminated, length in length)
+const char* LoggerCommand::getToken(uint8_t i, uint8_t* length) {
+  if (i >= n_tokens) {
+    *length = 0;
+    return(command + strlen(command));
+  }
+  *length = token_lengths[i];
+  return(command + token_starts[i]);
+}
+
+// check if token i is the text
+bool LoggerCommand::isToken(uint8_t i, const char* text) {
+  uint8_t length;
+  const char* token = getToken(i, &length);
+  return(strncmp(token, text, length) == 0 && text[length] == 0);
 }
 
 // check if variable has the specific value
@@ -4,12 +4,20 @@
 
 // important constants
 #define CMD_MAX_CHAR          63  // spark.functions are limited to 63 char long call
+#define CMD_MAX_TOKENS        (CMD_MAX_CHAR / 2 + 1) // tokens are separated by single spaces
 
 struct LoggerCommand {
 
     // command message
     char command[CMD_MAX_CHAR];
-    char buffer[CMD_MAX_CHAR];
+
+    // tokens of the command (positions in the command, split once when loading)
+    uint8_t token_starts[CMD_MAX_TOKENS];
+    uint8_t token_lengths[CMD_MAX_TOKENS];
+    uint8_t n_tokens = 0;
+    uint8_t next_token = 0; // next token to extract
+
+    // extracted tokens (copied only when extracted)
     char variable[25];
     char value[20];
     char units[20];
@@ -28,12 +36,19 @@ struct LoggerCommand {
     // command extraction
     void reset();
     void load(String& command_string);
+    void load(const char* command_text);
+    void tokenize();
     void extractParam(char* param, uint size, uint n_space = 1);
     void extractVariable(uint n_space = 1);
     void extractValue(uint n_space = 1);
     void extractUnits(uint n_space = 1);
     void assignNotes();
 
+    // token access (without copying or extracting)
+    uint8_t getTokenCount();
+    const char* getToken(uint8_t i, uint8_t* length);
+    bool isToken(uint8_t i, const char* text);
+
     // command parsing
     bool parseVariable(char* cmd);
     bool parseValue(char* cmd);
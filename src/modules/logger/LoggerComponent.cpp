@@ -29,16 +29,33 @@ void LoggerComponent::completeStartup() {
 void LoggerComponent::update() {
 }
 
+bool LoggerComponent::isPolled() {
+  return(true);
+}
+
+void LoggerComponent::handleTimer(LoggerTimer* timer) {
+}
+
 /*** state management ***/
 
-void LoggerComponent::setEEPROMStart(size_t start) { 
+void LoggerComponent::setEEPROMStart(size_t start, size_t legacy_start) { 
     eeprom_start = start; 
+    legacy_eeprom_start = legacy_start;
 }
 
 size_t LoggerComponent::getStateSize() { 
     return(0); 
 }
 
+size_t LoggerComponent::getLegacyStateSize() { 
+    return(0); 
+}
+
+// state in the layout before the state slots (only while the controller imports the states at boot)
+const uint8_t* LoggerComponent::getLegacyState() {
+    return(ctrl->getLegacyEEPROM(legacy_eeprom_start, getLegacyStateSize()));
+}
+
 void LoggerComponent::loadState(bool reset) {
   if (getStateSize() > 0) {
     if (!reset){
@@ -55,6 +72,10 @@ void LoggerComponent::saveState(){
 
 };
 
+void LoggerComponent::commitState(){ 
+
+};
+
 bool LoggerComponent::restoreState(){ 
     return(false); 
 };
@@ -65,6 +86,10 @@ void LoggerComponent::resetState() {
 
 /*** command parsing ***/
 
+void LoggerComponent::registerCommands() {
+
+};
+
 bool LoggerComponent::parseCommand(LoggerCommand *command) {
     return(false);
 };
@@ -118,7 +143,7 @@ void LoggerComponent::clearData(bool clear_persistent) {
             (clear_persistent) ?
                 Serial.printf("DEBUG: clearing all component '%s' data at ", id):
                 Serial.printf("DEBUG: clearing only non-persistant component '%s' data at ", id);
-            Serial.println(Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z"));
+            Serial.println(ctrl->timestamp.getDateTime());
         }
         for (int i=0; i<data.size(); i++) data[i].clear(clear_persistent);
     }
@@ -140,8 +165,8 @@ void LoggerComponent::logStepData(float new_value, float change_cutoff, uint8_t
     
     if (!data[data_i].newest_value_valid || fabs(new_value - data[data_i].getValue()) > change_cutoff ) {
     
-        // save previous data in data[step_i] for the data log step transition
-        if (data[data_i].newest_value_valid) {
+        // save previous data in data[step_i] for the data log step transition (the one from before an action batch if deferred)
+        if (data[data_i].newest_value_valid && !ctrl->isStepLogDeferred(this)) {
             data[step_i].setNewestDataTime(millis() - 1); // old value logged 1 ms before new value
             data[step_i].setNewestValue(data[data_i].getValue());
             data[step_i].saveNewestValue(false); // no averaging
@@ -152,14 +177,16 @@ void LoggerComponent::logStepData(float new_value, float change_cutoff, uint8_t
         data[data_i].setNewestDataTime(millis());
         data[data_i].saveNewestValue(false);
 
-        // log data
-        logData();
+        // log data (together with the other components at the end of an action batch)
+        if (!ctrl->deferStepLog(this, step_i)) {
+            logData();
 
-        // clear the step transition data[step_i]
-        data[step_i].clear();
+            // clear the step transition data[step_i]
+            data[step_i].clear();
 
-        // update controller data variable
-        ctrl->updateDataVariable();
+            // update controller data variable
+            ctrl->updateDataVariable();
+        }
     }
 }
 
@@ -196,6 +223,7 @@ bool LoggerComponent::assembleDataLog() {
                 // no more space - stop here for this log
                 break;
             }
+            ctrl->addToDataRecord(&data[i], !data_have_same_time_offset);
         }
         last_data_log_index = i;
     }
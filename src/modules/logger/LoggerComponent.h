@@ -2,9 +2,11 @@
 #include <vector>
 #include "LoggerCommand.h"
 #include "LoggerData.h"
+#include "PersistentState.h"
 
-// forward declaration for controller
+// forward declaration for controller and timers
 class LoggerController;
+struct LoggerTimer;
 
 // component class
 class LoggerComponent
@@ -20,6 +22,8 @@ class LoggerComponent
 
     // state
     size_t eeprom_start;
+    size_t legacy_eeprom_start; // start in the layout before the state slots
+    const uint8_t* getLegacyState();
 
     // time offset - whether all data have the same
     bool data_have_same_time_offset;
@@ -40,7 +44,7 @@ class LoggerComponent
     std::vector<LoggerData> data;
 
     /*** constructors ***/
-    LoggerComponent (const char *id, LoggerController *ctrl, bool data_have_same_time_offset, bool auto_clear_data) : id(id), ctrl(ctrl), data_have_same_time_offset(data_have_same_time_offset), auto_clear_data(auto_clear_data) {}
+    LoggerComponent (const char *id, LoggerController *ctrl, bool data_have_same_time_offset, bool auto_clear_data) : ctrl(ctrl), data_have_same_time_offset(data_have_same_time_offset), auto_clear_data(auto_clear_data), id(id) {}
 
     /*** debug ***/
     void debug();
@@ -52,16 +56,21 @@ class LoggerComponent
 
     /*** loop ***/
     virtual void update();
+    virtual bool isPolled(); // whether update() needs to be called on every loop pass (false if the component only acts on its timers)
+    virtual void handleTimer(LoggerTimer* timer); // a timer of the component is due
 
     /*** state management ***/
-    virtual void setEEPROMStart(size_t start);
+    virtual void setEEPROMStart(size_t start, size_t legacy_start);
     virtual size_t getStateSize();
+    virtual size_t getLegacyStateSize();
     virtual void loadState(bool reset = false);
     virtual void saveState();
+    virtual void commitState(); // write the state to EEPROM (at the end of an action batch if saveState() was deferred)
     virtual bool restoreState();
     virtual void resetState();
 
     /*** command parsing ***/
+    virtual void registerCommands(); // register command roots with the controller (components without are asked for every command)
     virtual bool parseCommand(LoggerCommand *command);
 
     /*** state changes ***/
@@ -71,6 +80,7 @@ class LoggerComponent
     virtual void updateDisplayStateInformation();
 
     /*** logger state variable ***/
+    bool state_changed = true; // whether the state variable fragment and display info need to be re-assembled
     virtual void assembleStateVariable();
 
     /*** logger data variable ***/
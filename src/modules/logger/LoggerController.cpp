@@ -2,6 +2,7 @@
 #include "LoggerController.h"
 #include "LoggerComponent.h"
 #include "LoggerDisplay.h"
+#include <algorithm>
 
 // EEPROM variables
 #define STATE_ADDRESS    0 // EEPROM storage location
@@ -52,14 +53,19 @@ void LoggerController::setDataUpdateCallback(void (*cb)()) {
 
 void LoggerController::setDisplay(LoggerDisplay* display) {
   lcd = display;
-  lcd->setEEPROMStart(eeprom_location);
+  lcd->setEEPROMStart(eeprom_location, legacy_eeprom_location);
   eeprom_location = eeprom_location + lcd->getStateSize();
+  legacy_eeprom_location = legacy_eeprom_location + lcd->getLegacyStateSize();
+  size_t n_routes = command_routes.size();
+  lcd->registerCommands();
+  if (command_routes.size() == n_routes) unrouted_components.push_back(lcd);
   Serial.printf("INFO: added display '%s' to the controller.\n", lcd->id);
 }
 
 void LoggerController::addComponent(LoggerComponent* component) {
-    component->setEEPROMStart(eeprom_location);
+    component->setEEPROMStart(eeprom_location, legacy_eeprom_location);
     eeprom_location = eeprom_location + component->getStateSize();
+    legacy_eeprom_location = legacy_eeprom_location + component->getLegacyStateSize();
     data_idx = component->setupDataVector(data_idx);
     if (debug_data) {
       for(int i = 0; i < component->data.size(); i++) {
@@ -71,6 +77,10 @@ void LoggerController::addComponent(LoggerComponent* component) {
     } else {
       Serial.printf("INFO: adding component '%s' to the controller.\n", component->id);
       components.push_back(component);
+      if (component->isPolled()) polled_components.push_back(component);
+      size_t n_routes = command_routes.size();
+      component->registerCommands();
+      if (command_routes.size() == n_routes) unrouted_components.push_back(component);
     }
 }
 
@@ -106,8 +116,12 @@ void LoggerController::init() {
   }
 
   // initatilize sd card if sd enabled
-  if (sd_enabled) sd->init();
-  else Serial.println("INFO: sd card disabled");
+  if (sd_enabled) {
+    sd->init();
+    spool->init();
+  } else {
+    Serial.println("INFO: sd card disabled");
+  }
 
   // create LCD if none set
   if (lcd == 0) {
@@ -116,9 +130,12 @@ void LoggerController::init() {
   }
 
   // load states
+  if (!reset) readLegacyEEPROM();
   loadState(reset);
   loadDisplayState(reset);
   loadComponentsState(reset);
+  clearLegacyEEPROM();
+  macros->init(eeprom_location, EEPROM_MAX, reset);
   original_save_state = state->save_state;
 
   // initialize lcd
@@ -182,11 +199,18 @@ void LoggerController::completeStartup() {
   updateDataVariable();
   updateDebugVariable();
 
+  // binary data log header (needs the name)
+  assembleDataRecordHeader();
+
   // start up complete
   Serial.println("INFO: start-up completed.");
   assembleStartupLog();
   queueStateLog();
 
+  // controller timers
+  scheduleDataLog();
+  timers.add(&sync_timer, last_sync + ONE_DAY_MILLIS + 1);
+
   // complete components' startup
   std::vector<LoggerComponent*>::iterator components_iter = components.begin();
   for(; components_iter != components.end(); components_iter++) 
@@ -199,6 +223,10 @@ bool LoggerController::isStartupComplete() {
   return(startup_complete);
 }
 
+bool LoggerController::isSdEnabled() {
+  return(sd_enabled);
+}
+
 /*** loop ***/
 
 void LoggerController::update() {
@@ -221,6 +249,9 @@ void LoggerController::update() {
             cloud_connected = true;
             lcd->printLine(2, ""); // clear "connect wifi" message
 
+            // time sync that was due while disconnected
+            if (startup_complete) timers.add(&sync_timer, last_sync + ONE_DAY_MILLIS + 1);
+
             // update display
             updateDisplayStateInformation();
             updateDisplayComponentsStateInformation();
@@ -260,65 +291,108 @@ void LoggerController::update() {
     // NOTE: consider making this a constructor property (bool use_rtc) and otherwise wait until particle connected
     if (!startup_complete && state->name[0] != 0 && Time.isValid()) {
       Serial.print("INFO: time & name available -> startup complete starts at ");
-      Serial.println(Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z"));
+      Serial.println(timestamp.getDateTime());
       startup_complete = true;
       completeStartup();
     }
 
-    // time to generate data logs?
-    if (startup_complete && isTimeForDataLogAndClear()) {
-        logData();
-        restartLastDataLog();
-        clearData(false);
-    }
+    // timers that are due (data logs, time sync, restart countdown, components)
+    updateTimers();
 
-    // out of memory?
-    if (missed_data > 0 && !out_of_memory) {
-      Serial.printlnf("INFO: no longer out of memory but missed %d data logs along the way", missed_data);
+    // data log queue full?
+    if (missed_data > 0 && !data_log_queue_full) {
+      Serial.printlnf("INFO: data log queue no longer full but missed %d data logs along the way", missed_data);
       assembleMissedDataLog();
       queueStateLog(true); // always log missed data even if state logging is off
       missed_data = 0;
     }
     
-    // time to process logs?
-    if (startup_complete && Particle.connected() && millis() - last_log_published > publish_interval) {
-      if (!state_log_stack.empty()) {
+    // logs behind spooled ones move to the spool as well (a few per loop pass, none are lost in a power outage)
+    if (!spool->isEmpty()) {
+      if (!state_log_queue.isEmpty()) spoolQueuedLogs(&state_log_queue, SPOOL_TYPE_STATE, SPOOL_MOVE_MAX);
+      else if (!data_log_queue.isEmpty()) spoolQueuedLogs(&data_log_queue, SPOOL_TYPE_DATA, SPOOL_MOVE_MAX);
+    }
+
+    // time to process logs? (one publish at a time, the loop does not wait for its acknowledgement)
+    if (publish_source != PUBLISH_NONE) {
+      checkPublish();
+    } else if (startup_complete && Particle.connected() && millis() - last_log_published > publish_interval + publish_backoff) {
+      if (!spool->isEmpty()) {
+        // spooled logs are older than the ones in the queues (full queues move their oldest logs to the spool)
+        publishSpooledLog();
+      } else if (!state_log_queue.isEmpty()) {
         // process state logs first
         publishStateLog();
-      } else if (!data_log_stack.empty()) {
+      } else if (!data_log_queue.isEmpty()) {
         publishDataLog();
       }
-      last_log_published = millis();
     }
 
-    // time for time sync?
-    if (startup_complete && Particle.connected() && millis() - last_sync > ONE_DAY_MILLIS) {
-      // request time synchronization from the Particle Cloud
-      Particle.syncTime();
-      last_sync = millis();
-    }
+    // sd card lines that have been buffered for too long
+    if (sd_enabled) sd->update();
 
-    // restart
-    if (trigger_reset != RESET_UNDEF) {
-      if (millis() - reset_timer_start > reset_delay) {
-        System.reset(trigger_reset, RESET_NO_WAIT);
-      }
-      float countdown = ((float) (reset_delay - (millis() - reset_timer_start))) / 1000;
-      snprintf(lcd_buffer, sizeof(lcd_buffer), "%.0fs to restart...", countdown);
-      lcd->printLineTemp(1, lcd_buffer);
-    }
+    // local console
+    readConsole();
 
     // components update
-    std::vector<LoggerComponent*>::iterator components_iter = components.begin();
-    for(; components_iter != components.end(); components_iter++) {
-        (*components_iter)->update();
-    }
+    updateComponents();
 
     // lcd update
     lcd->update();
 
 }
 
+void LoggerController::updateTimers() {
+  LoggerTimer* timer;
+  while ((timer = timers.next(millis())) != 0) {
+    (timer->component != 0) ? timer->component->handleTimer(timer) : handleTimer(timer);
+  }
+}
+
+void LoggerController::updateComponents() {
+  // components that only act on their timers are skipped
+  for (LoggerComponent* component : polled_components) component->update();
+}
+
+void LoggerController::handleTimer(LoggerTimer* timer) {
+  if (timer == &data_log_timer && startup_complete) {
+    // time to generate data logs?
+    if (isTimeForDataLogAndClear()) {
+      logData();
+      restartLastDataLog();
+      clearData(false);
+    } else {
+      // not logging by time: check again in a period
+      timers.addIn(&data_log_timer, state->data_logging_period * 1000UL);
+    }
+  } else if (timer == &sync_timer && startup_complete && Particle.connected()) {
+    // request time synchronization from the Particle Cloud (if disconnected: once the connection is back)
+    Particle.syncTime();
+    last_sync = millis();
+    timers.add(&sync_timer, last_sync + ONE_DAY_MILLIS + 1);
+  } else if (timer == &reset_timer && trigger_reset != RESET_UNDEF) {
+    // restart
+    if (millis() - reset_timer_start > reset_delay) {
+      spoolQueuedLogs();
+      if (sd_enabled) sd->flush(); // buffered sd card lines
+      System.reset(trigger_reset, RESET_NO_WAIT);
+      return;
+    }
+    float countdown = ((float) (reset_delay - (millis() - reset_timer_start))) / 1000;
+    snprintf(lcd_buffer, sizeof(lcd_buffer), "%.0fs to restart...", countdown);
+    lcd->printLineTemp(1, lcd_buffer);
+    // countdown every half second until the restart is due
+    uint32_t restart_at = reset_timer_start + reset_delay + 1;
+    timers.add(&reset_timer, ((int32_t) (restart_at - millis()) > 500) ? millis() + 500 : restart_at);
+  }
+}
+
+void LoggerController::triggerReset(uint32_t type) {
+  trigger_reset = type;
+  reset_timer_start = millis();
+  timers.add(&reset_timer, reset_timer_start);
+}
+
 /*** logger name capture ***/
 
 void LoggerController::captureName(const char *topic, const char *data) {
@@ -330,6 +404,7 @@ void LoggerController::captureName(const char *topic, const char *data) {
     saveState();
     Serial.printlnf("INFO: logger name changed to '%s'", state->name);
     lcd->printLine(1, state->name);
+    if (startup_complete) assembleDataRecordHeader();
     if (name_callback) name_callback();
   } else {
     Serial.printlnf("INFO: logger name already saved: '%s'", state->name);
@@ -348,7 +423,8 @@ void LoggerController::loadState(bool reset)
     saveState();
   }
   // show newly loaded state (just the controller)
-  state_variable_buffer[0] = 0; 
+  state_variable_starts.clear(); // cached fragments are gone
+  state_variable_builder.reset();
   assembleStateVariable();
   Serial.printlnf("INFO: controller '%s' state: %s", version, state_variable_buffer);
 };
@@ -358,7 +434,8 @@ void LoggerController::loadDisplayState(bool reset)
   // load lcd state
   lcd->loadState(reset);
   // show newly loaded state (just the lcd)
-  state_variable_buffer[0] = 0; 
+  state_variable_starts.clear(); // cached fragments are gone
+  state_variable_builder.reset();
   lcd->assembleStateVariable();
   Serial.printlnf("INFO: controller '%s' state: %s", version, state_variable_buffer);
 }
@@ -370,7 +447,8 @@ void LoggerController::loadComponentsState(bool reset)
   {
     (*components_iter)->loadState(reset);
     // show newly loaded state (just the componet)
-    state_variable_buffer[0] = 0; 
+    state_variable_starts.clear(); // cached fragments are gone
+    state_variable_builder.reset();
     (*components_iter)->assembleStateVariable();
     Serial.printlnf("INFO: component '%s' state: %s", (*components_iter)->id, state_variable_buffer);
   }
@@ -378,8 +456,9 @@ void LoggerController::loadComponentsState(bool reset)
 
 void LoggerController::saveState(bool always)
 {
+  state_changed = true; // state variable & display info out of date
   if (state->save_state || always) {
-    EEPROM.put(eeprom_start, *state);
+    persistent_state.save(eeprom_start);
     if (debug_state) {
       Serial.printf("DEBUG: controller '%s' state saved in memory (if any updates were necessary)\n", version);
     }
@@ -390,22 +469,32 @@ void LoggerController::saveState(bool always)
 
 bool LoggerController::restoreState()
 {
-  LoggerControllerState *saved_state = new LoggerControllerState();
-  EEPROM.get(eeprom_start, *saved_state);
-  bool recoverable = saved_state->version == state->version;
-  if (recoverable)
-  {
-    EEPROM.get(eeprom_start, *state);
-    Serial.printf("INFO: successfully restored controller state from memory (state version %d)\n", state->version);
-  }
-  else
-  {
-    Serial.printf("INFO: could not restore state from memory (found state version %d instead of %d), sticking with initial default\n", saved_state->version, state->version);
-    saveState(true);
-  }
+  bool recoverable = persistent_state.restore(eeprom_start, getLegacyEEPROM(eeprom_start, persistent_state.getLegacySize()));
+  if (!recoverable) saveState(true);
   return (recoverable);
 };
 
+void LoggerController::readLegacyEEPROM()
+{
+  // no saves of the controller state yet: the EEPROM might still have the layout before the state slots,
+  // copy it so all states can be imported (saving the imported states overwrites it)
+  if (persistent_state.hasSave(eeprom_start) || legacy_eeprom_location > EEPROM_MAX) return;
+  legacy_eeprom = new uint8_t[legacy_eeprom_location];
+  for (size_t i = 0; i < legacy_eeprom_location; i++) legacy_eeprom[i] = EEPROM.read(i);
+}
+
+void LoggerController::clearLegacyEEPROM()
+{
+  if (legacy_eeprom) delete[] legacy_eeprom;
+  legacy_eeprom = 0;
+}
+
+const uint8_t* LoggerController::getLegacyEEPROM(size_t start, size_t size)
+{
+  if (legacy_eeprom == 0 || size == 0 || start + size > legacy_eeprom_location) return(0);
+  return(legacy_eeprom + start);
+}
+
 void LoggerController::resetState() {
   state->version = 0; // force reset of state on restart
   saveState(true);
@@ -415,15 +504,33 @@ void LoggerController::resetState() {
   {
     (*components_iter)->resetState();
   }
+  macros->resetState();
 }
 
 /*** command parsing ***/
 
 int LoggerController::receiveCommand(String command_string) {
 
-  // load, parse and finalize command
+  // load command
   command->load(command_string);
   command->extractVariable();
+
+  // several commands (except for a macro definition)
+  if (!command->parseVariable(CMD_MACRO) && strchr(command_string.c_str(), CMD_BATCH_SEPARATOR)) return(receiveBatch(command_string.c_str()));
+
+  // macro (run as a batch)
+  if (command->parseVariable(CMD_RUN)) {
+    command->extractValue();
+    const char* macro_commands = macros->getCommands(command->value);
+    if (macro_commands != 0) {
+      Serial.printlnf("INFO: running macro '%s': %s", command->value, macro_commands);
+      return(receiveBatch(macro_commands));
+    }
+    command->load(command_string);
+    command->extractVariable();
+  }
+
+  // parse and finalize command
   Serial.printlnf("COMMAND parsing: %s ...", command->command);
   parseCommand();
 
@@ -452,54 +559,374 @@ int LoggerController::receiveCommand(String command_string) {
   return(command->ret_val);
 }
 
+// split a batch into its commands (surrounding spaces and empty commands dropped)
+uint8_t LoggerController::splitBatch(char* batch, char** commands, bool* too_many) {
+  uint8_t n_commands = 0;
+  *too_many = false;
+  char* start = batch;
+  while (start != 0) {
+    char* end = strchr(start, CMD_BATCH_SEPARATOR);
+    if (end != 0) *end = 0;
+    while (*start == ' ') start++;
+    for (char* c = start + strlen(start); c > start && *(c - 1) == ' '; c--) *(c - 1) = 0;
+    if (*start != 0) {
+      if (n_commands < CMD_BATCH_MAX) commands[n_commands++] = start;
+      else *too_many = true;
+    }
+    start = (end != 0) ? end + 1 : 0;
+  }
+  return(n_commands);
+}
+
+int LoggerController::receiveBatch(const char* batch_text) {
+
+  // split into commands
+  char batch[CMD_MAX_CHAR];
+  strncpy(batch, batch_text, sizeof(batch) - 1);
+  batch[sizeof(batch) - 1] = 0;
+  char* commands[CMD_BATCH_MAX];
+  bool too_many;
+  uint8_t n_commands = splitBatch(batch, commands, &too_many);
+  Serial.printlnf("COMMAND parsing batch: %s (%d commands) ...", batch_text, n_commands);
+
+  // lock is checked once: a locked logger runs none of the commands, a 'lock on' in the batch applies after it
+  bool locked = state->locked;
+  char batch_data[STATE_LOG_MAX_CHAR];
+  char batch_msg[STATE_LOG_MAX_CHAR];
+  char batch_notes[STATE_LOG_MAX_CHAR];
+  LoggerBuffer data_builder{batch_data};
+  LoggerBuffer msg_builder{batch_msg};
+  LoggerBuffer notes_builder{batch_notes};
+  int packed = 0;
+  bool failed = too_many, changed = false;
+  if (too_many) {
+    Serial.printlnf("ERROR: too many commands in batch (max %d), none of them run", CMD_BATCH_MAX);
+    msg_builder.addf("too many commands (max %d)", CMD_BATCH_MAX);
+  }
+  command_batch = true;
+  for (uint8_t i = 0; i < n_commands && !too_many; i++) {
+    command->load(commands[i]);
+    command->extractVariable();
+    if (locked) command->errorLocked();
+    else parseCommand();
+    if (!command->isTypeDefined()) command->errorCommand();
+    (command->ret_val != 0) ?
+      Serial.printlnf("COMMAND %d of batch %s: %s (return code %d = %s).", i + 1, command->type_short, command->command, command->ret_val, command->msg) :
+      Serial.printlnf("COMMAND %d of batch %s: %s (return code %d).", i + 1, command->type_short, command->command, command->ret_val);
+    // per command return code
+    int status = CMD_BATCH_RET_SUCCESS;
+    if (command->ret_val < 0) {
+      status = CMD_BATCH_RET_ERROR;
+      failed = true;
+    } else if (command->ret_val > 0) {
+      status = CMD_BATCH_RET_WARNING;
+    }
+    if (command->hasStateChanged()) changed = true;
+    packed |= status << (i * CMD_BATCH_RET_BITS);
+    // combined state log
+    if (command->data[0] != 0) data_builder.addItem(command->data);
+    if (command->msg[0] != 0) msg_builder.addItem(command->msg, CMD_BATCH_SEPARATOR);
+    if (command->notes[0] != 0) notes_builder.addItem(command->notes, CMD_BATCH_SEPARATOR);
+  }
+  command_batch = false;
+  if (too_many) {
+    for (uint8_t i = 0; i < CMD_BATCH_MAX; i++) packed |= CMD_BATCH_RET_NOT_RUN << (i * CMD_BATCH_RET_BITS);
+  }
+
+  // batch outcome (shown as a whole on the lcd)
+  command->load(batch_text);
+  if (failed) {
+    strcpy(command->type, CMD_LOG_TYPE_ERROR);
+    strcpy(command->type_short, CMD_LOG_TYPE_ERROR_SHORT);
+  } else if (changed) {
+    strcpy(command->type, CMD_LOG_TYPE_STATE_CHANGED);
+    strcpy(command->type_short, CMD_LOG_TYPE_STATE_CHANGED_SHORT);
+  } else {
+    strcpy(command->type, CMD_LOG_TYPE_STATE_UNCHANGED);
+    strcpy(command->type_short, CMD_LOG_TYPE_STATE_UNCHANGED_SHORT);
+  }
+  command->ret_val = failed ? -packed : packed;
+  updateDisplayCommandInformation();
+  Serial.printlnf("COMMAND %s (batch return code %d).", lcd_buffer, command->ret_val);
+
+  // one state log and state variable update for the whole batch
+  if (debug_cloud) {
+    Serial.printlnf("DEBUG: cloud debugging is on --> always assemble state log and publish to variable '%s'", STATE_LOG_WEBHOOK);
+    override_state_log = true;
+  }
+  assembleStateLog(command->type, batch_data, batch_msg, batch_notes);
+  queueStateLog(override_state_log);
+  override_state_log = false;
+
+  // command reporting callback
+  if (command_callback) command_callback();
+
+  // return value
+  return(command->ret_val);
+}
+
+int LoggerController::runActions(const char* label, const char* actions) {
+
+  // split into commands
+  char batch[CMD_ACTIONS_MAX_CHAR];
+  strncpy(batch, actions, sizeof(batch) - 1);
+  batch[sizeof(batch) - 1] = 0;
+  char* commands[CMD_BATCH_MAX];
+  bool too_many;
+  uint8_t n_commands = splitBatch(batch, commands, &too_many);
+  if (too_many || strlen(actions) >= sizeof(batch)) {
+    Serial.printlnf("ERROR: actions of %s are too long (max %d commands, %d characters), none of them run", label, CMD_BATCH_MAX, CMD_ACTIONS_MAX_CHAR - 1);
+    if (tracing_actions) action_trace->addFailed();
+    return(-CMD_BATCH_RET_NOT_RUN);
+  }
+
+  // dry run: only record the commands and whether their root is routed (the command being parsed stays untouched,
+  // components without command roots are not asked since they would run the command)
+  if (tracing_actions) {
+    int packed = 0;
+    for (uint8_t i = 0; i < n_commands; i++) {
+      char root[sizeof(command->variable)];
+      size_t root_length = strcspn(commands[i], " ");
+      if (root_length >= sizeof(root)) root_length = sizeof(root) - 1;
+      strncpy(root, commands[i], root_length);
+      root[root_length] = 0;
+      uint8_t check = TRACE_CMD_KNOWN;
+      if (findCommand(root) == 0) check = unrouted_components.empty() ? TRACE_CMD_UNKNOWN : TRACE_CMD_UNCHECKED;
+      if (check == TRACE_CMD_UNKNOWN) packed |= CMD_BATCH_RET_ERROR << (i * CMD_BATCH_RET_BITS);
+      action_trace->add(commands[i], strlen(commands[i]), check);
+    }
+    return(-packed);
+  }
+  Serial.printlnf("INFO: running actions of %s: %s", label, actions);
+
+  // not locked (the logger's own actions), component state saves and step data logs wait for the end
+  int packed = 0;
+  bool failed = false;
+  command_batch = true;
+  action_batch = true;
+  for (uint8_t i = 0; i < n_commands; i++) {
+    command->load(commands[i]);
+    command->extractVariable();
+    parseCommand();
+    if (!command->isTypeDefined()) command->errorCommand();
+    int status = CMD_BATCH_RET_SUCCESS;
+    if (command->ret_val < 0) {
+      Serial.printlnf("ERROR: action %d of %s failed: %s (return code %d = %s)", i + 1, label, command->command, command->ret_val, command->msg);
+      status = CMD_BATCH_RET_ERROR;
+      failed = true;
+    } else if (command->ret_val > 0) {
+      status = CMD_BATCH_RET_WARNING;
+    }
+    packed |= status << (i * CMD_BATCH_RET_BITS);
+  }
+  command_batch = false;
+  action_batch = false;
+
+  // each changed state saved once, all step data in one data log
+  commitDeferredStates();
+  logDeferredSteps();
+  return(failed ? -packed : packed);
+}
+
+bool LoggerController::deferStateSave(LoggerComponent* component) {
+  if (!action_batch) return(false);
+  for (size_t i = 0; i < deferred_saves.size(); i++) {
+    if (deferred_saves[i] == component) return(true);
+  }
+  deferred_saves.push_back(component);
+  return(true);
+}
+
+bool LoggerController::deferStepLog(LoggerComponent* component, uint8_t step_i) {
+  if (!action_batch) return(false);
+  if (!isStepLogDeferred(component)) deferred_steps.push_back({component, step_i});
+  return(true);
+}
+
+LoggerTrace* LoggerController::startActionTrace() {
+  if (action_trace == 0) action_trace = new LoggerTrace();
+  action_trace->clear();
+  tracing_actions = true;
+  return(action_trace);
+}
+
+void LoggerController::stopActionTrace() {
+  tracing_actions = false;
+}
+
+bool LoggerController::isStepLogDeferred(LoggerComponent* component) {
+  for (size_t i = 0; i < deferred_steps.size(); i++) {
+    if (deferred_steps[i].component == component) return(true);
+  }
+  return(false);
+}
+
+void LoggerController::commitDeferredStates() {
+  for (size_t i = 0; i < deferred_saves.size(); i++) deferred_saves[i]->commitState();
+  deferred_saves.clear();
+}
+
+void LoggerController::logDeferredSteps() {
+  if (deferred_steps.empty()) return;
+
+  // step data of all components (with their own time offsets), continued in another log if it does not fit
+  resetDataLog();
+  bool empty = true;
+  for (size_t s = 0; s < deferred_steps.size(); s++) {
+    LoggerComponent* component = deferred_steps[s].component;
+    for (size_t i = 0; i < component->data.size(); i++) {
+      LoggerData* data = &component->data[i];
+      if (!data->isEnabled() || (data->isDebugOnly() && !state->debug_mode) || !data->assembleLog(true)) continue;
+      if (!addToDataLogBuffer(data->json)) {
+        if (!empty && finalizeDataLog(false)) queueDataLog();
+        resetDataLog();
+        addToDataLogBuffer(data->json);
+      }
+      addToDataRecord(data, true);
+      empty = false;
+    }
+  }
+  if (!empty && finalizeDataLog(false)) queueDataLog();
+
+  // clear the step transitions
+  for (size_t s = 0; s < deferred_steps.size(); s++) {
+    deferred_steps[s].component->data[deferred_steps[s].step_i].clear();
+  }
+  deferred_steps.clear();
+  updateDataVariable();
+}
+
+void LoggerController::readConsole() {
+  // at most one line per loop pass
+  while (Serial.available() > 0) {
+    char c = Serial.read();
+    if (c == '\n' || c == '\r') {
+      if (console_overflow) {
+        Serial.printlnf("ERROR: console command too long (max %d characters), ignored", CMD_MAX_CHAR - 1);
+      } else if (console_length > 0) {
+        console_line[console_length] = 0;
+        console_length = 0;
+        runConsoleLine(console_line);
+        return;
+      }
+      console_length = 0;
+      console_overflow = false;
+    } else if (console_length < sizeof(console_line) - 1) {
+      console_line[console_length++] = c;
+    } else {
+      console_overflow = true;
+    }
+  }
+}
+
+void LoggerController::runConsoleLine(const char* line) {
+  // queries (read-only, not commands), variables can be longer than a formatted print
+  if (strncmp(line, CONSOLE_GET " ", strlen(CONSOLE_GET) + 1) == 0) {
+    const char* what = line + strlen(CONSOLE_GET) + 1;
+    if (strcmp(what, STATE_INFO_VARIABLE) == 0) {
+      Serial.printf("CONSOLE %s: ", STATE_INFO_VARIABLE);
+      Serial.println(state_variable);
+    } else if (strcmp(what, DATA_INFO_VARIABLE) == 0) {
+      Serial.printf("CONSOLE %s: ", DATA_INFO_VARIABLE);
+      Serial.println(data_variable);
+    } else if (strcmp(what, DEBUG_INFO_VARIABLE) == 0) {
+      Serial.printf("CONSOLE %s: ", DEBUG_INFO_VARIABLE);
+      Serial.println(debug_variable);
+    } else {
+      Serial.printlnf("CONSOLE ERROR: unknown variable '%s' (%s, %s or %s)", what, STATE_INFO_VARIABLE, DATA_INFO_VARIABLE, DEBUG_INFO_VARIABLE);
+    }
+    return;
+  }
+  // commands (same as the cloud function)
+  int ret_val = receiveCommand(line);
+  (command->msg[0] != 0) ?
+    Serial.printlnf("CONSOLE %s: return code %d (%s)", line, ret_val, command->msg) :
+    Serial.printlnf("CONSOLE %s: return code %d", line, ret_val);
+}
+
 void LoggerController::parseCommand() {
 
-  // decision tree
-  if (parseLocked()) {
-    // locked is getting parsed
-  } else if (parseDebug()) {
-    // debug state getting parsed
-  } else if (parseTimezone()) {
-    // timezone getting parsed
-  } else if (parseStateSaving()) {
-    // save-state parsed
-  } else if (parseSdLogging()) {
-    // SD logging getting parsed
-  } else if (parseStateLogging()) {
-    // state logging getting parsed
-  } else if (parseDataLogging()) {
-    // data logging getting parsed
-  } else if (parseDataLoggingPeriod()) {
-    // parsing logging period
-  } else if (parseDataReadingPeriod()) {
-    // parsing reading period
-  } else if (parseReset()) {
-    // reset getting parsed
-  } else if (parseRestart()) {
-    // restart getting parsed
-  } else if (parsePage()) {
-    // lcd paging
-  } else if (parseSdTest()) {
-    // sd teesting
-  } else if (lcd->parseCommand(command)) {
-    // lcd commands
-  } else {
-    // component commands
-    parseComponentsCommand();
+  // locked is always parsed first (a locked logger only takes the lock command)
+  if (parseLocked()) return;
+
+  // registered command root
+  const CommandRoute* route = findCommand(command->variable);
+  if (route != 0) {
+    if (route->parser != 0) (this->*(route->parser))();
+    else route->component->parseCommand(command);
+    return;
   }
 
+  // components without command roots
+  parseComponentsCommand();
 }
 
 void LoggerController::parseComponentsCommand() {
   bool success = false;
-  std::vector<LoggerComponent*>::iterator components_iter = components.begin();
-  for(; components_iter != components.end(); components_iter++)
+  std::vector<LoggerComponent*>::iterator components_iter = unrouted_components.begin();
+  for(; components_iter != unrouted_components.end(); components_iter++)
   {
      success = (*components_iter)->parseCommand(command);
      if (success) break;
   }
 }
 
+/*** command dispatch ***/
+
+void LoggerController::registerControllerCommands() {
+  registerCommand(CMD_LOCK, &LoggerController::parseLocked);
+  registerCommand(CMD_DEBUG, &LoggerController::parseDebug);
+  registerCommand(CMD_TIMEZONE, &LoggerController::parseTimezone);
+  registerCommand(CMD_SAVE_STATE, &LoggerController::parseStateSaving);
+  registerCommand(CMD_SD_LOG, &LoggerController::parseSdLogging);
+  registerCommand(CMD_STATE_LOG, &LoggerController::parseStateLogging);
+  registerCommand(CMD_DATA_LOG, &LoggerController::parseDataLogging);
+  registerCommand(CMD_LOG_BATCH, &LoggerController::parseLogBatching);
+  registerCommand(CMD_DATA_LOG_PERIOD, &LoggerController::parseDataLoggingPeriod);
+  registerCommand(CMD_DATA_READ_PERIOD, &LoggerController::parseDataReadingPeriod);
+  registerCommand(CMD_RESET, &LoggerController::parseReset);
+  registerCommand(CMD_RESTART, &LoggerController::parseRestart);
+  registerCommand(CMD_PAGE, &LoggerController::parsePage);
+  registerCommand(CMD_SD_TEST, &LoggerController::parseSdTest);
+  registerCommand(CMD_SD_FLUSH, &LoggerController::parseSdFlush);
+  registerCommand(CMD_SD_FORMAT, &LoggerController::parseSdFormat);
+  registerCommand(CMD_MACRO, &LoggerController::parseMacro);
+  registerCommand(CMD_RUN, &LoggerController::parseRun);
+}
+
+void LoggerController::registerCommand(const char* root, bool (LoggerController::*parser)()) {
+  registerCommand(CommandRoute{root, parser, 0});
+}
+
+void LoggerController::registerCommand(const char* root, LoggerComponent* component) {
+  registerCommand(CommandRoute{root, 0, component});
+}
+
+void LoggerController::registerCommand(CommandRoute route) {
+  // keep sorted by root
+  std::vector<CommandRoute>::iterator routes_iter = command_routes.begin();
+  while (routes_iter != command_routes.end() && strcmp(routes_iter->root, route.root) < 0) routes_iter++;
+  if (routes_iter != command_routes.end() && strcmp(routes_iter->root, route.root) == 0) {
+    // first registration wins (same as the order of the parsers before)
+    Serial.printlnf("WARNING: command '%s' is already registered, ignoring the new registration", route.root);
+    return;
+  }
+  command_routes.insert(routes_iter, route);
+}
+
+const LoggerController::CommandRoute* LoggerController::findCommand(const char* root) {
+  // binary search
+  size_t low = 0, high = command_routes.size();
+  while (low < high) {
+    size_t mid = (low + high) / 2;
+    int cmp = strcmp(command_routes[mid].root, root);
+    if (cmp == 0) return(&command_routes[mid]);
+    if (cmp < 0) low = mid + 1;
+    else high = mid;
+  }
+  return(0);
+}
+
 bool LoggerController::parseLocked() {
   // decision tree
   if (command->parseVariable(CMD_LOCK)) {
@@ -511,7 +938,7 @@ bool LoggerController::parseLocked() {
       command->success(changeLocked(false));
     }
     getStateLockedText(state->locked, command->data, sizeof(command->data));
-  } else if (state->locked) {
+  } else if (state->locked && !command_batch) {
     // Logger is locked --> no other commands allowed
     command->errorLocked();
   }
@@ -558,6 +985,14 @@ bool LoggerController::parseStateSaving() {
       command->success(changeStateSaving(true));
     } else if (command->parseValue(CMD_SAVE_STATE_OFF)) {
       command->success(changeStateSaving(false));
+    } else if (command->parseValue(CMD_SAVE_STATE_PAUSE)) {
+      bool saving = state->save_state;
+      pauseStateSaving();
+      command->success(saving);
+    } else if (command->parseValue(CMD_SAVE_STATE_RESUME)) {
+      bool saving = state->save_state;
+      resumeStateSaving();
+      command->success(saving != state->save_state);
     }
     getStateSaveStateText(state->save_state, command->data, sizeof(command->data));
   }
@@ -607,6 +1042,20 @@ bool LoggerController::parseDataLogging() {
   return(command->isTypeDefined());
 }
 
+bool LoggerController::parseLogBatching() {
+  if (command->parseVariable(CMD_LOG_BATCH)) {
+    // log batching
+    command->extractValue();
+    if (command->parseValue(CMD_LOG_BATCH_ON)) {
+      command->success(changeLogBatching(true));
+    } else if (command->parseValue(CMD_LOG_BATCH_OFF)) {
+      command->success(changeLogBatching(false));
+    }
+    getStateLogBatchingText(state->log_batching, command->data, sizeof(command->data));
+  }
+  return(command->isTypeDefined());
+}
+
 bool LoggerController::parseReset() {
   if (command->parseVariable(CMD_RESET)) {
     command->extractValue();
@@ -621,8 +1070,7 @@ bool LoggerController::parseReset() {
       command->success(true);
       getStateStringText(CMD_RESET, CMD_RESET_STATE, command->data, sizeof(command->data), PATTERN_KV_JSON_QUOTED, false);
       command->setLogMsg("restarting system...");
-      trigger_reset = RESET_STATE;
-      reset_timer_start = millis();
+      triggerReset(RESET_STATE);
     }
   }
   return(command->isTypeDefined());
@@ -633,9 +1081,7 @@ bool LoggerController::parseRestart() {
     command->success(true);
     getInfoValue(command->data, sizeof(command->data), CMD_RESTART);
     command->setLogMsg("restarting system...");
-    trigger_reset = RESET_RESTART;
-    reset_timer_start = millis();
-    
+    triggerReset(RESET_RESTART);
   }
   return(command->isTypeDefined());
 }
@@ -826,6 +1272,74 @@ bool LoggerController::parseSdTest() {
   return(command->isTypeDefined());
 }
 
+bool LoggerController::parseSdFlush() {
+  if (command->parseVariable(CMD_SD_FLUSH)) {
+    if (!sd_enabled) {
+      command->error(CMD_RET_ERR_SD_DISABLED, CMD_RET_ERR_SD_DISABLED_TEXT);
+    } else {
+      Serial.printlnf("INFO: writing %d buffered bytes to SD card", sd->getBuffered());
+      if (!sd->flush())
+        command->error(CMD_RET_ERR_SD_UNAVAILABLE, CMD_RET_ERR_SD_UNAVAILABLE_TEXT);
+      else
+        command->success(true);
+    }
+  }
+  return(command->isTypeDefined());
+}
+
+bool LoggerController::parseSdFormat() {
+  if (command->parseVariable(CMD_SD_FORMAT)) {
+    // sd data log format
+    command->extractValue();
+    if (command->parseValue(CMD_SD_FORMAT_JSON)) {
+      command->success(changeSdFormat(false));
+    } else if (command->parseValue(CMD_SD_FORMAT_BINARY)) {
+      command->success(changeSdFormat(true));
+    }
+    getStateSdFormatText(state->sd_binary, command->data, sizeof(command->data));
+  }
+  return(command->isTypeDefined());
+}
+
+bool LoggerController::parseMacro() {
+  if (command->parseVariable(CMD_MACRO)) {
+    command->extractValue();
+    char key[sizeof(CMD_MACRO) + sizeof(CMD_MACRO_DEFINE)];
+    if (command->parseValue(CMD_MACRO_DEFINE)) {
+      snprintf(key, sizeof(key), "%s-%s", CMD_MACRO, CMD_MACRO_DEFINE);
+      // name and commands (the rest of the command)
+      command->extractUnits();
+      command->assignNotes();
+      if (command->units[0] == 0 || strlen(command->units) > MACRO_NAME_MAX || command->notes[0] == 0) {
+        command->errorValue();
+      } else if (!macros->define(command->units, command->notes)) {
+        command->error(CMD_RET_ERR_MACROS_FULL, CMD_RET_ERR_MACROS_FULL_TEXT);
+      } else {
+        command->success(true);
+      }
+      getStateStringText(key, command->units, command->data, sizeof(command->data), PATTERN_KV_JSON_QUOTED);
+    } else if (command->parseValue(CMD_MACRO_DELETE)) {
+      snprintf(key, sizeof(key), "%s-%s", CMD_MACRO, CMD_MACRO_DELETE);
+      command->extractUnits();
+      if (macros->remove(command->units)) command->success(true);
+      else command->error(CMD_RET_ERR_MACRO_UNKNOWN, CMD_RET_ERR_MACRO_UNKNOWN_TEXT);
+      getStateStringText(key, command->units, command->data, sizeof(command->data), PATTERN_KV_JSON_QUOTED);
+    }
+  }
+  return(command->isTypeDefined());
+}
+
+bool LoggerController::parseRun() {
+  // macros are run by receiveCommand, a macro ends up here only if it is unknown or run from a batch
+  if (command->parseVariable(CMD_RUN)) {
+    command->extractValue();
+    if (command_batch) command->error(CMD_RET_ERR_MACRO_IN_BATCH, CMD_RET_ERR_MACRO_IN_BATCH_TEXT);
+    else command->error(CMD_RET_ERR_MACRO_UNKNOWN, CMD_RET_ERR_MACRO_UNKNOWN_TEXT);
+    getStateStringText(CMD_RUN, command->value, command->data, sizeof(command->data), PATTERN_KV_JSON_QUOTED);
+  }
+  return(command->isTypeDefined());
+}
+
 
 /*** state changes ***/
 
@@ -906,16 +1420,26 @@ bool LoggerController::changeStateSaving (bool on) {
   return(changed);
 }
 
-// pause state saving
+// pause state saving (a pause while already paused does not change what resume goes back to)
 void LoggerController::pauseStateSaving() {
+  if (save_state_paused) return;
+  save_state_paused = true;
   original_save_state = state->save_state;
-  if (original_save_state) Serial.println("INFO: pausing state saving");
+  if (original_save_state) {
+    Serial.println("INFO: pausing state saving");
+    state_changed = true; // state variable & display info out of date
+  }
   state->save_state = false;
 }
 
 // resume state saving
 void LoggerController::resumeStateSaving() {
-  if (original_save_state) Serial.println("INFO: resuming state saving");
+  if (!save_state_paused) return;
+  save_state_paused = false;
+  if (original_save_state) {
+    Serial.println("INFO: resuming state saving");
+    state_changed = true; // state variable & display info out of date
+  }
   state->save_state = original_save_state;
 }
 
@@ -988,13 +1512,50 @@ bool LoggerController::changeDataLogging (bool on) {
   return(changed);
 }
 
+// log batching
+bool LoggerController::changeLogBatching (bool on) {
+  bool changed = on != state->log_batching;
+
+  if (changed) state->log_batching = on;
+
+  if (debug_state) {
+    if (changed)
+      on ? Serial.println("DEBUG: log batching turned on") : Serial.println("DEBUG: log batching turned off");
+    else
+      on ? Serial.println("DEBUG: log batching already on") : Serial.println("DEBUG: log batching already off");
+  }
+
+  if (changed) saveState();
+
+  return(changed);
+}
+
+// sd data log format
+bool LoggerController::changeSdFormat (bool binary) {
+  bool changed = binary != state->sd_binary;
+
+  if (changed) state->sd_binary = binary;
+
+  if (debug_state) {
+    if (changed)
+      binary ? Serial.println("DEBUG: sd data log format changed to binary") : Serial.println("DEBUG: sd data log format changed to json");
+    else
+      binary ? Serial.println("DEBUG: sd data log format already binary") : Serial.println("DEBUG: sd data log format already json");
+  }
+
+  if (changed) saveState();
+
+  return(changed);
+}
+
 // logging period
 bool LoggerController::changeDataLoggingPeriod(int period, int type) {
-  bool changed = period != state->data_logging_period | type != state->data_logging_type;
+  bool changed = period != state->data_logging_period || type != state->data_logging_type;
 
   if (changed) {
     state->data_logging_period = period;
     state->data_logging_type = type;
+    scheduleDataLog();
   }
 
   if (debug_state) {
@@ -1135,16 +1696,60 @@ void LoggerController::updateDisplayComponentsStateInformation() {
 /*** logger state variable ***/
 
 void LoggerController::updateStateVariable() {
-  updateDisplayStateInformation();
-  updateDisplayComponentsStateInformation();
-  if (state_update_callback) state_update_callback();
-  state_variable_buffer[0] = 0; // reset buffer
-  assembleStateVariable();
-  lcd->assembleStateVariable();
-  assembleComponentsStateVariable();
+  // display info only for what changed
+  bool changed = state_changed || lcd->state_changed;
+  if (state_changed) updateDisplayStateInformation();
+  std::vector<LoggerComponent*>::iterator components_iter = components.begin();
+  for(; components_iter != components.end(); components_iter++)
+  {
+    if ((*components_iter)->state_changed) {
+      (*components_iter)->updateDisplayStateInformation();
+      changed = true;
+    }
+  }
+  if (changed && state_update_callback) state_update_callback();
+  // state fragments only if anything changed, the rest (time, queues) always
+  if (changed) assembleChangedStateVariable();
   postStateVariable();
 }
 
+void LoggerController::assembleChangedStateVariable() {
+  // fragments in order: controller, lcd, components
+  size_t n = components.size() + 2;
+  if (state_variable_starts.size() != n) {
+    // nothing cached yet --> assemble all
+    state_variable_starts.assign(n, 0);
+    state_changed = true;
+  }
+
+  // keep the fragments before the first changed one
+  size_t first = 0;
+  if (!state_changed) {
+    first = lcd->state_changed ? 1 : 2;
+    while (first >= 2 && first < n && !components[first - 2]->state_changed) first++;
+  }
+  if (first == n) return;
+  if (debug_state) {
+    Serial.printlnf("DEBUG: re-assembling state variable from fragment %d of %d", first + 1, n);
+  }
+
+  // re-assemble from there
+  state_variable_builder.rewind(state_variable_starts[first]);
+  for (size_t i = first; i < n; i++) {
+    state_variable_starts[i] = state_variable_builder.length();
+    if (i == 0) {
+      assembleStateVariable();
+      state_changed = false;
+    } else if (i == 1) {
+      lcd->assembleStateVariable();
+      lcd->state_changed = false;
+    } else {
+      components[i - 2]->assembleStateVariable();
+      components[i - 2]->state_changed = false;
+    }
+  }
+}
+
 void LoggerController::assembleStateVariable() {
   char pair[60];
   getStateLockedText(state->locked, pair, sizeof(pair)); addToStateVariableBuffer(pair);
@@ -1154,38 +1759,40 @@ void LoggerController::assembleStateVariable() {
   getStateSdLoggingText(state->sd_logging, pair, sizeof(pair)); addToStateVariableBuffer(pair);
   getStateStateLoggingText(state->state_logging, pair, sizeof(pair)); addToStateVariableBuffer(pair);
   getStateDataLoggingText(state->data_logging, pair, sizeof(pair)); addToStateVariableBuffer(pair);
+  getStateLogBatchingText(state->log_batching, pair, sizeof(pair)); addToStateVariableBuffer(pair);
+  if (state->sd_logging) {
+    getStateSdFormatText(state->sd_binary, pair, sizeof(pair)); addToStateVariableBuffer(pair);
+  }
   getStateDataLoggingPeriodText(state->data_logging_period, state->data_logging_type, pair, sizeof(pair)); addToStateVariableBuffer(pair);
   if (state->data_reader) {
     getStateDataReadingPeriodText(state->data_reading_period, pair, sizeof(pair)); addToStateVariableBuffer(pair);
   }
 }
 
-void LoggerController::assembleComponentsStateVariable() {
-  std::vector<LoggerComponent*>::iterator components_iter = components.begin();
-  for(; components_iter != components.end(); components_iter++)
-  {
-     (*components_iter)->assembleStateVariable();
-  }
-}
-
 void LoggerController::addToStateVariableBuffer(char* info) {
-  if (state_variable_buffer[0] == 0) {
-    strncpy(state_variable_buffer, info, sizeof(state_variable_buffer));
-  } else {
-    snprintf(state_variable_buffer, sizeof(state_variable_buffer),
-        "%s,%s", state_variable_buffer, info);
+  // whole items only (the state variable stays valid JSON)
+  if (!state_variable_builder.isTruncated() && !state_variable_builder.addWholeItem(info)) {
+    Serial.printlnf("WARNING: state variable too long, truncated at '%s'", info);
   }
 }
 
 void LoggerController::postStateVariable() {
-  Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z").toCharArray(date_time_buffer, sizeof(date_time_buffer));
   // dt = datetime, s = state information
-  snprintf(state_variable, sizeof(state_variable), 
-    "{\"dt\":\"%s\",\"version\":\"%s\",\"mac\":\"%02x:%02x:%02x:%02x:%02x:%02x\",\"mem\":%lu,\"sls\":%d,\"dls\":%d,\"s\":[%s]}",
-    date_time_buffer, version, 
+  // sls/dls = state/data logs queued, sla/dla = age of the oldest queued log (in s), sld/dld = logs lost because they neither fit into the queue nor could be spooled
+  // sps = logs spooled to the SD card (instead of the full queues)
+  int length = snprintf(state_variable, sizeof(state_variable), 
+    "{\"dt\":\"%s\",\"version\":\"%s\",\"mac\":\"%02x:%02x:%02x:%02x:%02x:%02x\",\"mem\":%lu,"
+    "\"sls\":%d,\"sla\":%lu,\"sld\":%lu,\"dls\":%d,\"dla\":%lu,\"dld\":%lu,\"sps\":%lu,\"s\":[%s]}",
+    timestamp.getDateTime(), version, 
     mac_address[0], mac_address[1], mac_address[2], mac_address[3], mac_address[4], mac_address[5],
-    System.freeMemory(), state_log_stack.size(), data_log_stack.size(),
-    state_variable_buffer);
+    (unsigned long) System.freeMemory(), 
+    (int) state_log_queue.getCount(), state_log_queue.getOldestAge() / 1000, state_log_queue.getDropped(),
+    (int) data_log_queue.getCount(), data_log_queue.getOldestAge() / 1000, data_log_queue.getDropped(),
+    spool->getCount(), state_variable_buffer);
+  if (length >= (int) sizeof(state_variable)) {
+    // header longer than STATE_INFO_HEADER_MAX_CHAR (e.g. a long version)
+    Serial.printlnf("ERROR: state variable too long (%d characters), cut off at %d", length, (int) sizeof(state_variable) - 1);
+  }
   if (debug_cloud) {
     Serial.printf("DEBUG: updated state variable: %s\n", state_variable);
     if (!Particle.connected()) {
@@ -1217,18 +1824,22 @@ void LoggerController::assembleMissedDataLog() {
   char data[40];
   snprintf(data, sizeof(data), "{\"k\":\"missed_data_logs\",\"v\":\"%d\"}", missed_data);
   strcpy(command->data, data);
-  strcpy(command->msg, "lack of cloud connection and low memory lead to missing data logs");
+  strcpy(command->msg, "lack of cloud connection and full data log queue lead to missing data logs");
   assembleStateLog();
 }
 
 void LoggerController::assembleStateLog() {
-  state_log[0] = 0;
   if (command->data[0] == 0) strcpy(command->data, "{}"); // empty data entry
+  assembleStateLog(command->type, command->data, command->msg, command->notes);
+}
+
+void LoggerController::assembleStateLog(const char* type, const char* data, const char* msg, const char* notes) {
+  state_log[0] = 0;
+  if (data[0] == 0) data = "{}"; // empty data entry
   // id = Logger name, dt = log datetime, t = state log type, s = state change, m = message, n = notes
-  Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z").toCharArray(date_time_buffer, sizeof(date_time_buffer));
   int buffer_size = snprintf(state_log, sizeof(state_log),
      "{\"id\":\"%s\",\"dt\":\"%s\",\"t\":\"%s\",\"s\":[%s],\"m\":\"%s\",\"n\":\"%s\"}",
-     state->name, date_time_buffer, command->type, command->data, command->msg, command->notes);
+     state->name, timestamp.getDateTime(), type, data, msg, notes);
   if (buffer_size < 0 || buffer_size >= sizeof(state_log)) {
     Serial.println("ERROR: state log buffer not large enough for state log");
     lcd->printLineTemp(1, "ERR: statelog too big");
@@ -1246,41 +1857,36 @@ void LoggerController::queueStateLog(bool log_always) {
   } else if (!state->state_logging && !log_always) {
     Serial.println("WARNING: no state log queued because state_logging is OFF.");
     saveStateLogToSD(); // check for SD save even if web logging is off
-  } else if (System.freeMemory() < memory_reserve) {
-    out_of_memory = true;
-    Serial.printlnf("WARNING: state log '%s' NOT queued because free memory < memory reserve (%d bytes).",  state_log, memory_reserve);
-    saveStateLogToSD(); // check for SD save even if we're out of RAM
+  } else if (!queueLog(&state_log_queue, SPOOL_TYPE_STATE, state_log)) {
+    state_log_queue.addDropped();
+    Serial.printlnf("WARNING: state log '%s' NOT queued because the state log queue is full (%d bytes) and it could not be spooled.",  state_log, state_log_queue.getSize());
+    saveStateLogToSD(); // check for SD save even if the queue is full
   } else {
-    state_log_stack.push_back(state_log);
     if (debug_cloud) {
-      Serial.printlnf("DEBUG: added log #%d to state log stack: '%s'", state_log_stack.size(), state_log_stack.back().c_str());
+      Serial.printlnf("DEBUG: added log #%d to state log queue: '%s'", state_log_queue.getCount(), state_log);
     }
     saveStateLogToSD();
   }
-  updateStateVariable(); // update state variable stack info
+  updateStateVariable(); // update state variable queue info
 }
 
 void LoggerController::publishStateLog() {
   
-  if (!state_log_stack.empty()) {
+  if (!state_log_queue.isEmpty()) {
 
-    // process from back to front (i.e. always latest log first) for speed and to avoid memory fragmentation
+    // process from front to back (i.e. oldest log first)
+    size_t batch_n = state->log_batching ? assembleBatchLog(&state_log_queue) : 1;
+    const char* log = (batch_n > 1) ? batch_log : state_log_queue.front();
     if (debug_cloud) {
-      Serial.printf("DEBUG: publishing last state log (#%d) to event '%s': '%s'... ", 
-        state_log_stack.size(), STATE_LOG_WEBHOOK, state_log_stack.back().c_str());
+      Serial.printlnf("DEBUG: publishing oldest %d state log(s) (of %d) to event '%s': '%s'", 
+        batch_n, state_log_queue.getCount(), STATE_LOG_WEBHOOK, log);
+    } else if (batch_n > 1) {
+      Serial.printlnf("INFO: publishing %d state logs (queue #%d)", batch_n, state_log_queue.getCount());
     } else {
-      Serial.printf("INFO: publishing state log (stack #%d)... ", state_log_stack.size());
+      Serial.printlnf("INFO: publishing state log (queue #%d)", state_log_queue.getCount());
     }
     
-    bool success = Particle.publish(STATE_LOG_WEBHOOK, state_log_stack.back().c_str(), WITH_ACK);
-    if (success) Serial.println("successful.");
-    else Serial.println("failed!");
-
-    if (success) {
-      state_log_stack.pop_back();
-      updateStateVariable(); // update state variable stack info
-    }
-
+    startPublish(PUBLISH_STATE_LOG, batch_n, STATE_LOG_WEBHOOK, log);
   }
   
 }
@@ -1288,11 +1894,7 @@ void LoggerController::publishStateLog() {
 void LoggerController::saveStateLogToSD() {
   if (sd_enabled && state->sd_logging) {
     Serial.println("INFO: writing state log to SD card.");
-    if (sd->available()) {
-      sd->append("state.log");
-      sd->println(state_log);
-      sd->syncFile();
-    } else {
+    if (!sd->available() || !sd->appendLine(SD_STATE_LOG, state_log)) {
       Serial.println("ERROR: SD card unavailable.");
     }
   }
@@ -1302,7 +1904,7 @@ void LoggerController::saveStateLogToSD() {
 
 void LoggerController::updateDataVariable() {
   if (data_update_callback) data_update_callback();
-  data_variable_buffer[0] = 0; // reset buffer
+  data_variable_builder.reset();
   assembleComponentsDataVariable();
   postDataVariable();
 }
@@ -1316,19 +1918,15 @@ void LoggerController::assembleComponentsDataVariable() {
 }
 
 void LoggerController::addToDataVariableBuffer(char* info) {
-  if (data_variable_buffer[0] == 0) {
-    strncpy(data_variable_buffer, info, sizeof(data_variable_buffer));
-  } else {
-    snprintf(data_variable_buffer, sizeof(data_variable_buffer),
-        "%s,%s", data_variable_buffer, info);
+  if (!data_variable_builder.isTruncated() && !data_variable_builder.addItem(info)) {
+    Serial.printlnf("WARNING: data variable too long, truncated at '%s'", info);
   }
 }
 
 void LoggerController::postDataVariable() {
-  Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z").toCharArray(date_time_buffer, sizeof(date_time_buffer));
   // dt = datetime, d = structured data
   snprintf(data_variable, sizeof(data_variable), "{\"dt\":\"%s\",\"d\":[%s]}",
-    date_time_buffer, data_variable_buffer);
+    timestamp.getDateTime(), data_variable_buffer);
   if (debug_cloud) {
     Serial.printf("DEBUG: updated data variable: %s\n", data_variable);
     if (!Particle.connected()) {
@@ -1346,8 +1944,7 @@ bool LoggerController::isTimeForDataLogAndClear() {
     unsigned long log_period = state->data_logging_period * 1000;
     if ((millis() - last_data_log) > log_period) {
       if (debug_data) {
-        Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z").toCharArray(date_time_buffer, sizeof(date_time_buffer));
-        Serial.printf("DEBUG: triggering data log at %s (after %d seconds)\n", date_time_buffer, state->data_logging_period);
+        Serial.printf("DEBUG: triggering data log at %s (after %d seconds)\n", timestamp.getDateTime(), state->data_logging_period);
       }
       return(true);
     }
@@ -1357,8 +1954,7 @@ bool LoggerController::isTimeForDataLogAndClear() {
     // go by read number
     if (data[0].getN() >= state->data_logging_period) {
       if (debug_data) {
-      Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z").toCharArray(date_time_buffer, sizeof(date_time_buffer));
-      Serial.printf("INFO: triggering data log at %s (after %d reads)\n", date_time_buffer, state->data_logging_period);
+      Serial.printf("INFO: triggering data log at %s (after %d reads)\n", timestamp.getDateTime(), state->data_logging_period);
       }
       return(true);
     }
@@ -1372,6 +1968,12 @@ bool LoggerController::isTimeForDataLogAndClear() {
 
 void LoggerController::restartLastDataLog() {
   last_data_log = millis();
+  scheduleDataLog();
+}
+
+void LoggerController::scheduleDataLog() {
+  // due just after one period
+  timers.add(&data_log_timer, last_data_log + state->data_logging_period * 1000UL + 1);
 }
 
 void LoggerController::clearData(bool clear_persistent) {
@@ -1404,7 +2006,9 @@ void LoggerController::logData() {
 
 void LoggerController::resetDataLog() {
   data_log[0] = 0;
-  data_log_buffer[0] = 0;
+  data_log_builder.reset();
+  data_record.reset();
+  data_record_frame[0] = 0;
 }
 
 bool LoggerController::addToDataLogBuffer(char* info) {
@@ -1414,47 +2018,84 @@ bool LoggerController::addToDataLogBuffer(char* info) {
 
   // characters reserved for rest of data log
   const uid_t reserve = 50;
-  if (strlen(data_log_buffer) + strlen(info) + reserve >= sizeof(data_log)) {
+  if (data_log_builder.length() + strlen(info) + reserve >= sizeof(data_log)) {
     // not enough space in the data log to add more to the buffer
     if (debug_data) Serial.println("but log is at the size limit.");
     return(false);
   }
 
   // still enough space
-  if (data_log_buffer[0] == 0) {
-    // buffer empty, start from scratch
-    if (debug_data) Serial.println("success (first data).");
-    strncpy(data_log_buffer, info, sizeof(data_log_buffer));
-  } else {
-    // concatenate existing buffer with new info
-    if (debug_data) Serial.println("success.");
-    snprintf(data_log_buffer, sizeof(data_log_buffer),
-        "%s,%s", data_log_buffer, info);
-  }
-  return(true);
+  if (debug_data) Serial.println(data_log_builder.isEmpty() ? "success (first data)." : "success.");
+  return(data_log_builder.addItem(info));
 }
 
 bool LoggerController::finalizeDataLog(bool use_common_time, unsigned long common_time) {
   // data
-  Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z").toCharArray(date_time_buffer, sizeof(date_time_buffer));
   int buffer_size;
   if (use_common_time) {
     // id = Logger name, dt = log datetime, to = time offset from log datetime (global), d = structured data
-    buffer_size = snprintf(data_log, sizeof(data_log), "{\"id\":\"%s\",\"dt\":\"%s\",\"to\":%lu,\"d\":[%s]}", 
-      state->name, date_time_buffer, common_time, data_log_buffer);
+    buffer_size = snprintf(data_log, sizeof(data_log), PATTERN_DATA_LOG_TO_JSON, 
+      state->name, timestamp.getDateTime(), common_time, data_log_buffer);
   } else {
     // indivudal time
-    buffer_size = snprintf(data_log, sizeof(data_log), "{\"id\":\"%s\",\"dt\":\"%s\",\"d\":[%s]}", 
-      state->name, date_time_buffer, data_log_buffer);
+    buffer_size = snprintf(data_log, sizeof(data_log), PATTERN_DATA_LOG_JSON, 
+      state->name, timestamp.getDateTime(), data_log_buffer);
   }
   if (buffer_size < 0 || buffer_size >= sizeof(data_log)) {
     Serial.println("ERROR: data log buffer not large enough for data log - this should NOT be possible to happen");
     lcd->printLineTemp(1, "ERR: datalog too big");
     return(false);
   }
+  if (isSdBinary()) {
+    // epoch and time offset + the data as one frame
+    uint8_t fields_buffer[24];
+    LoggerRecord fields{fields_buffer};
+    fields.add(RECORD_DATA_LOG);
+    fields.addVarint(timestamp.getEpoch());
+    fields.addVarint(use_common_time ? common_time + 1ULL : 0);
+    if (data_record.isTruncated() || LoggerRecord::encodeFrame(data_record_frame, sizeof(data_record_frame), fields, data_record) == 0) {
+      Serial.println("ERROR: binary data log record too big for its buffer");
+      data_record_frame[0] = 0;
+    }
+  }
   return(true);
 }
 
+bool LoggerController::isSdBinary() {
+  return(sd_enabled && state->sd_logging && state->sd_binary);
+}
+
+bool LoggerController::addToDataRecord(LoggerData* data, bool include_time_offset) {
+  if (!isSdBinary()) return(true);
+  // same values as the data's log (LoggerData::assembleLog)
+  return(data_record.addData(data->idx, data->getN(), data->getDecimals(), data->getValue(), data->getStdDev(), 
+    include_time_offset, millis() - data->getDataTime()));
+}
+
+void LoggerController::assembleDataRecordHeader() {
+  // the keys and units are fixed once the components are set up (first data of each idx)
+  data_record.reset();
+  data_record.add(RECORD_HEADER);
+  data_record.addVarint(RECORD_VERSION);
+  data_record.addString(state->name);
+  std::vector<int> idxs;
+  for (LoggerComponent* component : components) {
+    for (LoggerData& data : component->data) {
+      if (std::find(idxs.begin(), idxs.end(), data.idx) != idxs.end()) continue;
+      idxs.push_back(data.idx);
+      data_record.addSigned(data.idx);
+      data_record.addString(data.variable);
+      data_record.addString(data.units);
+    }
+  }
+  if (data_record.isTruncated() || LoggerRecord::encodeFrame(data_header_frame, sizeof(data_header_frame), data_record) == 0) {
+    Serial.println("ERROR: binary data log header too big for its buffer");
+    data_header_frame[0] = 0;
+  }
+  data_record.reset();
+  if (sd_enabled) sd->setFileHeader(SD_BINARY_LOG, data_header_frame);
+}
+
 void LoggerController::queueDataLog() {
   if (strlen(data_log) == 0) {
     Serial.println("WARNING: no data log queued because there is none.");
@@ -1465,76 +2106,220 @@ void LoggerController::queueDataLog() {
   } else if (!state->data_logging) {
     Serial.println("WARNING: no data log queued because data_logging is OFF.");
     saveDataLogToSD(); // check for SD save even if web logging is off
-  } else if (System.freeMemory() < memory_reserve) {
-    out_of_memory = true;
+  } else if (!queueLog(&data_log_queue, SPOOL_TYPE_DATA, data_log)) {
+    data_log_queue.addDropped();
+    data_log_queue_full = true;
     missed_data++;
-    Serial.printlnf("WARNING: data log '%s' NOT queued because free memory < memory reserve (%d bytes), total %d data logs missed.", 
-      data_log, memory_reserve, missed_data);
-    saveDataLogToSD(); // check for SD save even if we're out of RAM
+    Serial.printlnf("WARNING: data log '%s' NOT queued because the data log queue is full (%d bytes) and it could not be spooled, total %d data logs missed.", 
+      data_log, data_log_queue.getSize(), missed_data);
+    saveDataLogToSD(); // check for SD save even if the queue is full
   } else {
-    out_of_memory = false;
-    data_log_stack.push_back(data_log);
+    data_log_queue_full = false;
     if (debug_cloud) {
-      Serial.printlnf("DEBUG: added log #%d to data log stack: '%s'", data_log_stack.size(), data_log_stack.back().c_str());
+      Serial.printlnf("DEBUG: added log #%d to data log queue: '%s'", data_log_queue.getCount(), data_log);
     }
     saveDataLogToSD();
   }
-  updateStateVariable(); // update state variable stack info
+  updateStateVariable(); // update state variable queue info
 }
 
 void LoggerController::publishDataLog() {
   
-  if (!data_log_stack.empty()) {
+  if (!data_log_queue.isEmpty()) {
 
-    size_t log_n = data_log_stack.size();
+    size_t log_n = data_log_queue.getCount();
 
-    // process from back to front (i.e. always latest log first) for speed and to avoid memory fragmentation
+    // process from front to back (i.e. oldest log first)
+    size_t batch_n = state->log_batching ? assembleBatchLog(&data_log_queue) : 1;
+    const char* log = (batch_n > 1) ? batch_log : data_log_queue.front();
     if (debug_cloud) {
-      Serial.printf("DEBUG: publishing last data log (#%d) to event '%s': '%s'... ", 
-        log_n, DATA_LOG_WEBHOOK, data_log_stack.back().c_str());
+      Serial.printlnf("DEBUG: publishing oldest %d data log(s) (of %d) to event '%s': '%s'", 
+        batch_n, log_n, DATA_LOG_WEBHOOK, log);
+    } else if (batch_n > 1) {
+      Serial.printlnf("INFO: publishing %d data logs (queue #%d)", batch_n, log_n);
     } else {
-      Serial.printf("INFO: publishing data log (stack #%d)... ", data_log_stack.size());
-    }
-
-    // particle is connected, try to publish the latest log
-    bool success = Particle.publish(DATA_LOG_WEBHOOK, data_log_stack.back().c_str(), WITH_ACK);
-    
-    if (success) Serial.println("successful.");
-    else Serial.println("failed!");
-
-    if (success) {
-      (log_n > 1) ?
-        snprintf(lcd_buffer, sizeof(lcd_buffer), "INFO: data log %d sent", log_n) :
-        snprintf(lcd_buffer, sizeof(lcd_buffer), "INFO: data log sent");
-      lcd->printLineTemp(1, lcd_buffer);
-      data_log_stack.pop_back();
-      updateStateVariable(); // update state variable stack info
-    } else {
-      snprintf(lcd_buffer, sizeof(lcd_buffer), "ERR: data log %d error", log_n);
-      lcd->printLineTemp(1, lcd_buffer);
+      Serial.printlnf("INFO: publishing data log (queue #%d)", log_n);
     }
 
+    startPublish(PUBLISH_DATA_LOG, batch_n, DATA_LOG_WEBHOOK, log);
   }
   
 }
 
 void LoggerController::saveDataLogToSD() {
-  if (sd_enabled && state->sd_logging) {
+  if (isSdBinary()) {
+    Serial.println("INFO: writing binary data log to SD card.");
+    if (data_record_frame[0] == 0) {
+      Serial.println("ERROR: no binary data log record to write.");
+    } else if (!sd->available() || !sd->appendRecord(SD_BINARY_LOG, data_record_frame)) {
+      Serial.println("ERROR: SD card unavailable.");
+    }
+  } else if (sd_enabled && state->sd_logging) {
     Serial.println("INFO: writing data log to SD card.");
-    if (sd->available()) {
-      sd->append("data.log");
-      sd->println(data_log);
-      sd->syncFile();
-    } else {
+    if (!sd->available() || !sd->appendLine(SD_DATA_LOG, data_log)) {
       Serial.println("ERROR: SD card unavailable.");
     }
   }
 }
 
+/*** batch publishing ***/
+
+bool LoggerController::addToBatchLog(const char* log) {
+  // room for the separator and the closing bracket
+  if (batch_log_builder.length() + strlen(log) + 2 >= sizeof(batch_log)) return(false);
+  if (batch_log_builder.length() > 1) batch_log_builder.add(',');
+  return(batch_log_builder.add(log));
+}
+
+size_t LoggerController::assembleBatchLog(LoggerQueue* queue) {
+  // batch = JSON array of logs
+  batch_log_builder.reset();
+  batch_log_builder.add('[');
+  size_t n = 0;
+  while (n < queue->getCount() && addToBatchLog(queue->peek(n))) n++;
+  batch_log_builder.add(']');
+  return(n > 0 ? n : 1); // a single log too long for the array is published by itself
+}
+
+size_t LoggerController::assembleBatchLog(LoggerSpool* spool, char type) {
+  batch_log_builder.reset();
+  batch_log_builder.add('[');
+  size_t n = 0;
+  char log_type = 0;
+  const char* log;
+  while ((log = spool->peek(n, &log_type)) != 0 && log_type == type && addToBatchLog(log)) n++;
+  batch_log_builder.add(']');
+  return(n > 0 ? n : 1); // a single log too long for the array is published by itself
+}
+
+/*** sd card log spool ***/
+
+bool LoggerController::spoolLog(char type, const char* log) {
+  if (!sd_enabled) return(false);
+  if (debug_cloud) Serial.printlnf("DEBUG: spooling %s log to SD card: '%s'", (type == SPOOL_TYPE_STATE) ? "state" : "data", log);
+  return(spool->push(type, log));
+}
+
+bool LoggerController::queueLog(LoggerQueue* queue, char type, const char* log) {
+  // the spool holds the oldest logs, the queue the newer ones: spooled directly only once the queue is empty
+  if (queue->isEmpty() && !spool->isEmpty()) return(spoolLog(type, log));
+  while (!queue->push(log)) {
+    // queue full --> its oldest logs move to the spool to make room (a few at a time, the loop pass stays short)
+    if (queue->isEmpty()) return(spoolLog(type, log));
+    if (spoolQueuedLogs(queue, type, SPOOL_MOVE_MAX) == 0) return(false);
+  }
+  return(true);
+}
+
+size_t LoggerController::spoolQueuedLogs(LoggerQueue* queue, char type, size_t max) {
+  if (!sd_enabled) return(0);
+  // a publish in flight from this queue moves along as a whole (acknowledged from the spool if it is at its front)
+  bool in_flight = (publish_source == PUBLISH_STATE_LOG && queue == &state_log_queue) || (publish_source == PUBLISH_DATA_LOG && queue == &data_log_queue);
+  bool at_front = spool->isEmpty();
+  if (in_flight && max < publish_n) max = publish_n;
+  size_t spooled = 0;
+  while (spooled < max && !queue->isEmpty() && spoolLog(type, queue->front())) {
+    queue->pop();
+    spooled++;
+  }
+  if (spooled > 0) Serial.printlnf("INFO: spooled the %d oldest %s logs to SD card", (int) spooled, (type == SPOOL_TYPE_STATE) ? "state" : "data");
+  if (in_flight && spooled > 0) {
+    if (at_front && spooled >= publish_n) publish_source = PUBLISH_SPOOLED_LOG;
+    else cancelPublish(); // only part of it moved (or behind other logs): published again from the spool
+  }
+  return(spooled);
+}
+
+bool LoggerController::spoolQueuedLogs() {
+  if (state_log_queue.isEmpty() && data_log_queue.isEmpty()) return(true);
+  Serial.printlnf("INFO: spooling %d state and %d data logs to SD card", (int) state_log_queue.getCount(), (int) data_log_queue.getCount());
+  spoolQueuedLogs(&state_log_queue, SPOOL_TYPE_STATE, state_log_queue.getCount());
+  spoolQueuedLogs(&data_log_queue, SPOOL_TYPE_DATA, data_log_queue.getCount());
+  return(state_log_queue.isEmpty() && data_log_queue.isEmpty());
+}
+
+void LoggerController::publishSpooledLog() {
+
+  char type = 0;
+  const char* log = spool->front(&type);
+  if (log == 0) return;
+  size_t batch_n = state->log_batching ? assembleBatchLog(spool, type) : 1;
+  if (batch_n > 1) log = batch_log;
+
+  const char* webhook = (type == SPOOL_TYPE_STATE) ? STATE_LOG_WEBHOOK : DATA_LOG_WEBHOOK;
+  if (debug_cloud) {
+    Serial.printlnf("DEBUG: publishing oldest %d spooled log(s) (of %lu) to event '%s': '%s'", batch_n, spool->getCount(), webhook, log);
+  } else {
+    Serial.printlnf("INFO: publishing %d spooled %s log(s) (spool #%lu)", batch_n, (type == SPOOL_TYPE_STATE) ? "state" : "data", spool->getCount());
+  }
+
+  startPublish(PUBLISH_SPOOLED_LOG, batch_n, webhook, log);
+}
+
+/*** publishing ***/
+
+void LoggerController::startPublish(uint8_t source, size_t n, const char* webhook, const char* log) {
+  // the logs stay in their queue/spool until the publish is acknowledged
+  publish_future = Particle.publish(webhook, log, WITH_ACK);
+  publish_source = source;
+  publish_n = n;
+  publish_start = millis();
+}
+
+void LoggerController::checkPublish() {
+
+  // still waiting?
+  bool timeout = millis() - publish_start > publish_timeout;
+  if (!publish_future.isDone() && !timeout) return;
+
+  bool success = !timeout && publish_future.isSucceeded();
+  if (timeout) publish_future.cancel();
+  const char* what = (publish_source == PUBLISH_STATE_LOG) ? "state" : (publish_source == PUBLISH_DATA_LOG) ? "data" : "spooled";
+
+  if (success) {
+    // remove the published logs
+    if (publish_source == PUBLISH_STATE_LOG) {
+      for (size_t i = 0; i < publish_n; i++) state_log_queue.pop();
+    } else if (publish_source == PUBLISH_DATA_LOG) {
+      // queue counts fit 16 bits (the text fits lcd_buffer)
+      size_t log_n = data_log_queue.getCount();
+      (log_n > 1) ?
+        snprintf(lcd_buffer, sizeof(lcd_buffer), "data log %u sent", (uint16_t) log_n) :
+        snprintf(lcd_buffer, sizeof(lcd_buffer), "data log sent");
+      lcd->printLineTemp(1, lcd_buffer);
+      for (size_t i = 0; i < publish_n; i++) data_log_queue.pop();
+    } else if (publish_source == PUBLISH_SPOOLED_LOG) {
+      spool->pop(publish_n);
+    }
+    Serial.printlnf("INFO: publishing %d %s log(s) successful after %lu ms.", publish_n, what, millis() - publish_start);
+    publish_backoff = 0;
+    updateStateVariable(); // update state variable queue info
+  } else {
+    // try again later (exponential backoff)
+    publish_backoff = (publish_backoff == 0) ? publish_interval : min(2 * publish_backoff, publish_backoff_max);
+    Serial.printlnf("WARNING: publishing %d %s log(s) %s, trying again in %lu s.", publish_n, what, 
+      timeout ? "timed out" : "failed", publish_backoff / 1000);
+    if (publish_source == PUBLISH_DATA_LOG) {
+      snprintf(lcd_buffer, sizeof(lcd_buffer), "data log %u error", (uint16_t) data_log_queue.getCount());
+      lcd->printLineTemp(1, lcd_buffer);
+    }
+  }
+
+  // slot free again
+  publish_source = PUBLISH_NONE;
+  last_log_published = millis();
+}
+
+void LoggerController::cancelPublish() {
+  Serial.printlnf("INFO: publish of %d log(s) cancelled, its logs are published again", publish_n);
+  publish_future.cancel();
+  publish_source = PUBLISH_NONE;
+}
+
 /*** logger debug variable ***/
 
 void LoggerController::updateDebugVariable() {
-  debug_variable_buffer[0] = 0; // reset buffer
+  debug_variable_builder.reset();
   assembleComponentsDebugVariable();
   postDebugVariable();
 }
@@ -1543,24 +2328,20 @@ void LoggerController::assembleComponentsDebugVariable() {
   std::vector<LoggerComponent*>::iterator components_iter = components.begin();
   for(; components_iter != components.end(); components_iter++)
   {
-    if (debug_variable_buffer[0] == 0) {
-      snprintf(debug_variable_buffer, sizeof(debug_variable_buffer), "\"id\":\"%s\"", (*components_iter)->id);
-    } else {
-      snprintf(debug_variable_buffer, sizeof(debug_variable_buffer), "%s},{\"id\":\"%s\"", debug_variable_buffer, (*components_iter)->id);
-    }
+    if (!debug_variable_builder.isEmpty()) debug_variable_builder.add("},{");
+    debug_variable_builder.addf("\"id\":\"%s\"", (*components_iter)->id);
     (*components_iter)->assembleDebugVariable();
   }
 }
 
 void LoggerController::addToDebugVariableBuffer(char* var, char* info) { 
-  snprintf(debug_variable_buffer, sizeof(debug_variable_buffer), "%s,\"%s\":\"%s\"", debug_variable_buffer, var, info);
+  debug_variable_builder.addf(",\"%s\":\"%s\"", var, info);
 }
 
 void LoggerController::postDebugVariable() {
-  Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z").toCharArray(date_time_buffer, sizeof(date_time_buffer));
   // dt = datetime, d = structured debug info
   snprintf(debug_variable, sizeof(debug_variable), "{\"dt\":\"%s\",\"cs\":[{%s}]}",
-    date_time_buffer, debug_variable_buffer);
+    timestamp.getDateTime(), debug_variable_buffer);
   if (debug_cloud) {
     Serial.printf("DEBUG: updated debug variable: %s\n", debug_variable);
   }
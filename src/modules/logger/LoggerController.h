@@ -3,6 +3,16 @@
 #include "LoggerUtils.h"
 #include "LoggerCommand.h"
 #include "LoggerSD.h"
+#include "LoggerSpool.h"
+#include "LoggerMacros.h"
+#include "LoggerBuffer.h"
+#include "LoggerQueue.h"
+#include "LoggerTimers.h"
+#include "LoggerTrace.h"
+#include "LoggerTime.h"
+#include "LoggerData.h"
+#include "LoggerRecord.h"
+#include "PersistentState.h"
 
 /*** time sync ***/
 #define ONE_DAY_MILLIS (24 * 60 * 60 * 1000)
@@ -10,7 +20,8 @@
 /*** spark cloud constants ***/
 #define CMD_ROOT               "device" // command root (i.e. registered particle call function)
 #define STATE_INFO_VARIABLE    "state" // name of the particle exposed state variable
-#define STATE_INFO_MAX_CHAR    621 // how long is the state information maximally
+#define STATE_INFO_MAX_CHAR    864 // how long is the state information maximally (particle variables are limited to 864 bytes as of device OS 1.5.0)
+#define STATE_INFO_HEADER_MAX_CHAR 240 // state information before the component states (date time, version up to 30 chars, mac, memory, log queues and spool)
 #define STATE_LOG_WEBHOOK      "state_log"  // name of the webhook to Logger state log
 #define STATE_LOG_MAX_CHAR     621  // spark.publish is limited to 622 bytes of device OS 0.8.0 (previously just 255)
 #define DATA_INFO_VARIABLE     "data" // name of the particle exposed data variable
@@ -20,6 +31,15 @@
 #define DEBUG_INFO_VARIABLE    "debug" // name of the particle exposed debug variable
 #define DEBUG_INFO_MAX_CHAR    621 // how long is the debug information maximally
 
+/*** log queues ***/
+// memory set aside for logs waiting to be published (in bytes)
+#ifndef STATE_LOG_QUEUE_SIZE
+#define STATE_LOG_QUEUE_SIZE   4096
+#endif
+#ifndef DATA_LOG_QUEUE_SIZE
+#define DATA_LOG_QUEUE_SIZE    32768
+#endif
+
 /*** commands ***/
 // return codes:
 //  -  0 : success without warning
@@ -53,6 +73,18 @@
 #define CMD_RET_ERR_SD_UNAVAILABLE_TEXT     "SD card is not available"
 #define CMD_RET_ERR_SD_TEST_FAILED          -17 // SD card test failed
 #define CMD_RET_ERR_SD_TEST_FAILED_TEXT     "SD card test failed"
+#define CMD_RET_ERR_MACRO_UNKNOWN           -18 // no macro with this name
+#define CMD_RET_ERR_MACRO_UNKNOWN_TEXT      "unknown macro"
+#define CMD_RET_ERR_MACROS_FULL             -19 // no room for another macro
+#define CMD_RET_ERR_MACROS_FULL_TEXT        "no room for another macro (delete one first)"
+#define CMD_RET_ERR_MACRO_IN_BATCH          -20 // macros cannot run from a batch or macro
+#define CMD_RET_ERR_MACRO_IN_BATCH_TEXT     "macros cannot be run from a batch"
+#define CMD_RET_ERR_SCHEDULE_INVALID        -21 // schedule line or file invalid
+#define CMD_RET_ERR_SCHEDULE_INVALID_TEXT   "invalid schedule"
+#define CMD_RET_ERR_SCHEDULE_PENDING        -22 // a schedule switch is already waiting for the current run
+#define CMD_RET_ERR_SCHEDULE_PENDING_TEXT   "schedule switch pending (finish or reset the current run first)"
+#define CMD_RET_ERR_SCHEDULE_NO_ACTIONS     -23 // events are not run from an action table (cannot be dry run)
+#define CMD_RET_ERR_SCHEDULE_NO_ACTIONS_TEXT "schedule has no action table"
 #define CMD_RET_WARN_NO_CHANGE              1 // state unchaged because it was already the same
 #define CMD_RET_WARN_NO_CHANGE_TEXT         "state already as requested"
 
@@ -67,6 +99,22 @@
 #define CMD_LOG_TYPE_STATE_UNCHANGED_SHORT  "SAME"
 #define CMD_LOG_TYPE_STARTUP                "startup"
 
+// command batches: device "power on;valco pos 3;log-period 5 m" runs the commands as one batch
+// (lock checked once for the whole batch, one state log with all state changes)
+#define CMD_BATCH_SEPARATOR   ';'
+#define CMD_BATCH_MAX         15 // max commands per batch (2 bits each in the return code)
+// return code of a batch: 2 bits per command (bits 0-1 for the 1st command, 2-3 for the 2nd, ...),
+// negative if any of the commands failed (i.e. the bits are those of the absolute value)
+#define CMD_BATCH_RET_SUCCESS 0 // success without warning
+#define CMD_BATCH_RET_WARNING 1 // success with warnings
+#define CMD_BATCH_RET_ERROR   2 // failed with errors
+#define CMD_BATCH_RET_NOT_RUN 3 // not run (all commands, if the batch has too many)
+#define CMD_BATCH_RET_BITS    2
+
+// action batches: commands run by the logger itself (e.g. the actions of a scheduler event), not locked and without a
+// state log, each changed component state is saved once and the step data of all components go into one data log
+#define CMD_ACTIONS_MAX_CHAR  200 // max length of the commands of an action batch
+
 // locking
 #define CMD_LOCK            "lock" // device "lock on/off [notes]" : locks/unlocks the Logger
   #define CMD_LOCK_ON         "on"
@@ -81,6 +129,8 @@
 #define CMD_SAVE_STATE      "save-state" // device "save-state on/off [notes]" : turns state saving (=persistance) on/off
   #define CMD_SAVE_STATE_ON   "on"
   #define CMD_SAVE_STATE_OFF  "off"
+  #define CMD_SAVE_STATE_PAUSE  "pause" // not saved (e.g. during a schedule's sampling steps)
+  #define CMD_SAVE_STATE_RESUME "resume" // back to on/off as before the pause
 
 // logging
 #define CMD_STATE_LOG       "state-log" // device "state-log on/off [notes]" : turns state logging on/off
@@ -93,6 +143,13 @@
   #define CMD_SD_LOG_ON       "on"
   #define CMD_SD_LOG_OFF      "off"
 #define CMD_SD_TEST        "sd-test" // device "sd-test"
+#define CMD_SD_FLUSH       "sd-flush" // device "sd-flush" : writes the log lines buffered for the sd card right away
+#define CMD_SD_FORMAT      "sd-format" // device "sd-format json/binary [notes]" : writes data logs to the sd card as JSON lines or compact binary records (decode with sd-decode)
+  #define CMD_SD_FORMAT_JSON   "json"
+  #define CMD_SD_FORMAT_BINARY "binary"
+#define CMD_LOG_BATCH      "log-batch" // device "log-batch on/off [notes]" : turns publishing of multiple queued logs in one event (as JSON array) on/off
+  #define CMD_LOG_BATCH_ON    "on"
+  #define CMD_LOG_BATCH_OFF   "off"
 
 // timezone
 #define CMD_TIMEZONE        "tz" // device "tz number [notes]" : sets a timezone for internal day/time display (logs to are always in UTC no matter the tz setting)
@@ -130,6 +187,24 @@
 // paging
 #define CMD_PAGE       "page" // device "page [#]" : switch to the next page (or a specific page number if provided)
 
+// local console (USB serial): one command per line, same commands as the cloud function plus queries
+#define CONSOLE_GET         "get" // console "get state/data/debug" : prints the state, data or debug variable
+
+// macros
+#define CMD_MACRO      "macro"
+  #define CMD_MACRO_DEFINE "define" // device "macro define name cmd;cmd;..." : stores the commands on the device under the name
+  #define CMD_MACRO_DELETE "delete" // device "macro delete name" : deletes the macro
+#define CMD_RUN        "run" // device "run name" : runs the commands of the macro as one batch
+
+
+/*** publish sources ***/
+#define PUBLISH_NONE        0 // no publish in flight
+#define PUBLISH_STATE_LOG   1 // state log queue
+#define PUBLISH_DATA_LOG    2 // data log queue
+#define PUBLISH_SPOOLED_LOG 3 // sd card log spool
+
+/*** sd card log spool ***/
+#define SPOOL_MOVE_MAX      8 // oldest logs moved from a full RAM queue to the spool at a time (keeps the loop pass short)
 
 /*** reset codes ***/
 #define RESET_UNDEF    1
@@ -161,8 +236,10 @@ struct LoggerControllerState {
   uint data_reading_period_min; // minimum time between reads (in ms) [only relevant if it is a data_reader]
   uint data_reading_period; // period between reads (stored in ms!!!) [only relevant if it is a data_reader]
   bool debug_mode = false; // whether controller is in debug mode for user purposes
+  bool log_batching = false; // whether queued logs are published in batches
+  bool sd_binary = false; // whether data logs are written to the sd card as binary records
   char name[DEVICE_NAME_MAX + 1];
-  uint8_t version = 5;
+  uint8_t version = 7;
 
   LoggerControllerState() {};
 
@@ -184,6 +261,59 @@ struct LoggerControllerState {
 
 };
 
+// EEPROM record of the state (ids of the fields and bytes reserved in each slot, with room for new fields)
+#define CONTROLLER_STATE_RECORD 96
+static const StateField controller_state_fields[] = {
+  STATE_FIELD(1, LoggerControllerState, locked),
+  STATE_FIELD(2, LoggerControllerState, tz),
+  STATE_FIELD(3, LoggerControllerState, save_state),
+  STATE_FIELD(4, LoggerControllerState, sd_logging),
+  STATE_FIELD(5, LoggerControllerState, state_logging),
+  STATE_FIELD(6, LoggerControllerState, data_logging),
+  STATE_FIELD(7, LoggerControllerState, data_logging_period),
+  STATE_FIELD(8, LoggerControllerState, data_logging_type),
+  STATE_FIELD(9, LoggerControllerState, data_reader),
+  STATE_FIELD(10, LoggerControllerState, data_reading_period_min),
+  STATE_FIELD(11, LoggerControllerState, data_reading_period),
+  STATE_FIELD(12, LoggerControllerState, debug_mode),
+  STATE_FIELD(13, LoggerControllerState, name),
+  STATE_FIELD(14, LoggerControllerState, log_batching),
+  STATE_FIELD(15, LoggerControllerState, sd_binary)
+};
+
+// state as saved before the state slots (raw struct of version 5, swiss 0.3)
+struct LoggerControllerStateV5 {
+  bool locked;
+  int8_t tz;
+  bool save_state;
+  bool sd_logging;
+  bool state_logging;
+  bool data_logging;
+  uint data_logging_period;
+  uint8_t data_logging_type;
+  bool data_reader;
+  uint data_reading_period_min;
+  uint data_reading_period;
+  bool debug_mode;
+  char name[DEVICE_NAME_MAX + 1];
+  uint8_t version;
+};
+static const StateField controller_state_v5_fields[] = {
+  STATE_FIELD(1, LoggerControllerStateV5, locked),
+  STATE_FIELD(2, LoggerControllerStateV5, tz),
+  STATE_FIELD(3, LoggerControllerStateV5, save_state),
+  STATE_FIELD(4, LoggerControllerStateV5, sd_logging),
+  STATE_FIELD(5, LoggerControllerStateV5, state_logging),
+  STATE_FIELD(6, LoggerControllerStateV5, data_logging),
+  STATE_FIELD(7, LoggerControllerStateV5, data_logging_period),
+  STATE_FIELD(8, LoggerControllerStateV5, data_logging_type),
+  STATE_FIELD(9, LoggerControllerStateV5, data_reader),
+  STATE_FIELD(10, LoggerControllerStateV5, data_reading_period_min),
+  STATE_FIELD(11, LoggerControllerStateV5, data_reading_period),
+  STATE_FIELD(12, LoggerControllerStateV5, debug_mode),
+  STATE_FIELD(13, LoggerControllerStateV5, name)
+};
+
 /*** state variable formatting ***/
 
 // locked text
@@ -256,6 +386,26 @@ static void getStateDataLoggingText(bool data_logging, char* target, int size, i
   else getStateDataLoggingText(data_logging, target, size, PATTERN_KV_JSON_QUOTED, true);
 }
 
+// log batching
+static void getStateLogBatchingText(bool log_batching, char* target, int size, char* pattern, int include_key = true) {
+  getStateBooleanText(CMD_LOG_BATCH, log_batching, CMD_LOG_BATCH_ON, CMD_LOG_BATCH_OFF, target, size, pattern, include_key);
+}
+
+static void getStateLogBatchingText(bool log_batching, char* target, int size, int value_only = false) {
+  if (value_only) getStateLogBatchingText(log_batching, target, size, PATTERN_V_SIMPLE, false);
+  else getStateLogBatchingText(log_batching, target, size, PATTERN_KV_JSON_QUOTED, true);
+}
+
+// sd data log format
+static void getStateSdFormatText(bool sd_binary, char* target, int size, char* pattern, int include_key = true) {
+  getStateBooleanText(CMD_SD_FORMAT, sd_binary, CMD_SD_FORMAT_BINARY, CMD_SD_FORMAT_JSON, target, size, pattern, include_key);
+}
+
+static void getStateSdFormatText(bool sd_binary, char* target, int size, int value_only = false) {
+  if (value_only) getStateSdFormatText(sd_binary, target, size, PATTERN_V_SIMPLE, false);
+  else getStateSdFormatText(sd_binary, target, size, PATTERN_KV_JSON_QUOTED, true);
+}
+
 // data logging period (any pattern)
 static void getStateDataLoggingPeriodText(int logging_period, uint8_t logging_type, char* target, int size, char* pattern, int include_key = true) {
   // specific logging period
@@ -354,6 +504,12 @@ class LoggerComponent;
 // forward declaration for display
 class LoggerDisplay;
 
+// step data of a component waiting for the end of an action batch
+struct LoggerDeferredStep {
+  LoggerComponent* component;
+  uint8_t step_i; // step transition data index (cleared once logged)
+};
+
 // controller class
 class LoggerController {
 
@@ -362,6 +518,7 @@ class LoggerController {
     // system reset & application watchdog
     const int reset_delay = 5000; // in ms - how long to delay the reset
     unsigned long reset_timer_start = 0; // start of the reset timer
+    LoggerTimer reset_timer; // restart countdown
     uint32_t trigger_reset = RESET_UNDEF; // what kind of reset to trigger
     uint32_t past_reset = RESET_UNDEF; // what kind of reset was triggered
     ApplicationWatchdog *wd;
@@ -376,10 +533,34 @@ class LoggerController {
 
     // time sync
     unsigned long last_sync = 0;
+    LoggerTimer sync_timer;
+
+    // data log
+    LoggerTimer data_log_timer;
 
     // state log exceptions
     bool override_state_log = false;
 
+    // command batch in progress (lock was checked for the whole batch)
+    bool command_batch = false;
+    uint8_t splitBatch(char* batch, char** commands, bool* too_many);
+
+    // action batch in progress (state saves and step data logs of the components wait for its end)
+    bool action_batch = false;
+    std::vector<LoggerComponent*> deferred_saves;
+    std::vector<LoggerDeferredStep> deferred_steps;
+    void commitDeferredStates();
+    void logDeferredSteps();
+
+    // dry run: commands of action batches recorded instead of run (one trace for all dry runs, allocated when first needed)
+    LoggerTrace* action_trace = 0;
+    bool tracing_actions = false;
+
+    // local console line (collected over loop passes, never waits for the rest of the line)
+    char console_line[CMD_MAX_CHAR];
+    uint8_t console_length = 0;
+    bool console_overflow = false; // line too long, skipped until its end
+
     // logger info
     bool name_handler_registered = false;
     bool name_handler_succeeded = false;
@@ -394,6 +575,8 @@ class LoggerController {
     // state info
     const size_t eeprom_start = 0;
     size_t eeprom_location = 0;
+    size_t legacy_eeprom_location = 0; // same in the layout before the state slots
+    uint8_t* legacy_eeprom = 0; // copy of the layout before the state slots (only while importing the states at boot)
 
     // startup
     bool startup_complete = false;
@@ -402,12 +585,28 @@ class LoggerController {
     uint8_t data_idx = 0;
 
     // state saving pause
+    bool save_state_paused = false;
     bool original_save_state = false;
 
+    // command dispatch: command roots (first word of a command) sorted by name, each with the parser of the
+    // controller or the component that handles it (binary search instead of asking every parser in turn)
+    struct CommandRoute {
+      const char* root;
+      bool (LoggerController::*parser)(); // controller command
+      LoggerComponent* component; // component command
+    };
+    std::vector<CommandRoute> command_routes;
+    std::vector<LoggerComponent*> unrouted_components; // components that did not register command roots (asked in turn)
+    std::vector<LoggerComponent*> polled_components; // components that check something on every loop pass (all others only run on their timers)
+    void registerCommand(const char* root, bool (LoggerController::*parser)());
+    void registerCommand(CommandRoute route);
+    void registerControllerCommands();
+    const CommandRoute* findCommand(const char* root);
+
   protected:
 
     // lcd buffer (for cross-method msg assembly that might not be safe to do with lcd->buffer)
-    char lcd_buffer[21];
+    char lcd_buffer[CMD_MAX_CHAR + 15]; // longest: locked command with its type (the display cuts the line)
 
     // call backs
     void (*name_callback)() = 0;
@@ -415,12 +614,9 @@ class LoggerController {
     void (*state_update_callback)() = 0;
     void (*data_update_callback)() = 0;
 
-    // buffer for date time
-    char date_time_buffer[25];
-
     // buffer and information variables
     char state_variable[STATE_INFO_MAX_CHAR];
-    char state_variable_buffer[STATE_INFO_MAX_CHAR-50];
+    char state_variable_buffer[STATE_INFO_MAX_CHAR - STATE_INFO_HEADER_MAX_CHAR];
     char data_variable[DATA_INFO_MAX_CHAR];
     char data_variable_buffer[DATA_INFO_MAX_CHAR-50];
     char debug_variable[DEBUG_INFO_MAX_CHAR];
@@ -430,22 +626,50 @@ class LoggerController {
     char state_log[STATE_LOG_MAX_CHAR];
     char data_log[DATA_LOG_MAX_CHAR];
     char data_log_buffer[DATA_LOG_MAX_CHAR-10];
+    char batch_log[DATA_LOG_MAX_CHAR];
 
-    // data logging tracker
-    unsigned long last_data_log = 0;
+    // binary data log records for the sd card (record of the data, frames ready to write)
+    uint8_t data_record_buffer[RECORD_MAX_SIZE];
+    LoggerRecord data_record{data_record_buffer};
+    char data_record_frame[RECORD_FRAME_SIZE];
+    char data_header_frame[RECORD_FRAME_SIZE]; // logger name, keys and units (at the start of every binary log file)
 
-    // log stacks
-    std::vector<std::string> state_log_stack;
-    std::vector<std::string> data_log_stack;
+    // builders that append to the buffers
+    LoggerBuffer state_variable_builder{state_variable_buffer};
+    LoggerBuffer data_variable_builder{data_variable_buffer};
+    LoggerBuffer debug_variable_builder{debug_variable_buffer};
+    LoggerBuffer data_log_builder{data_log_buffer};
+    LoggerBuffer batch_log_builder{batch_log};
 
-    // log stack processing
-    unsigned long last_log_published = 0;
-    const int publish_interval = 1000; // 1/s is the max frequency for particle cloud publishing
+    // state variable fragments (only re-assembled when the state changed)
+    bool state_changed = true; // controller state changed since the last state variable update
+    std::vector<size_t> state_variable_starts; // where the fragments (controller, lcd, components) start in the state variable buffer
 
-    // memory reserve
-    uint memory_reserve = 6000; // memory reserve in bytes (should be enough for wifi which takes 3619 normally)
-    bool out_of_memory = false; // whether out of memory
-    uint missed_data = 0; // how many data points missed b/c no internet and out of memory
+    // data logging tracker
+    unsigned long last_data_log = 0;
+
+    // log queues (preallocated so logs piling up during a cloud outage do not fragment the heap)
+    uint8_t state_log_queue_buffer[STATE_LOG_QUEUE_SIZE];
+    uint8_t data_log_queue_buffer[DATA_LOG_QUEUE_SIZE];
+    LoggerQueue state_log_queue{state_log_queue_buffer};
+    LoggerQueue data_log_queue{data_log_queue_buffer};
+
+    // log queue processing
+    unsigned long last_log_published = 0; // when the last publish completed
+    const unsigned long publish_interval = 1000; // 1/s is the max frequency for particle cloud publishing
+    const unsigned long publish_timeout = 30000; // how long to wait for a publish acknowledgement (in ms)
+    const unsigned long publish_backoff_max = 300000; // max wait after repeated publish failures (in ms)
+    unsigned long publish_backoff = 0; // current wait after failed publishes (in ms)
+
+    // publish in flight
+    particle::Future<bool> publish_future;
+    uint8_t publish_source = PUBLISH_NONE; // where the logs being published are from
+    size_t publish_n = 0; // how many logs are being published
+    unsigned long publish_start = 0; // when the publish started
+
+    // full data log queue
+    bool data_log_queue_full = false; // whether the data log queue is full
+    uint missed_data = 0; // how many data logs missed b/c no internet and the data log queue is full
 
   public:
 
@@ -460,9 +684,14 @@ class LoggerController {
     // public variables
     LoggerDisplay* lcd = 0;
     LoggerSD* sd = new LoggerSD();
+    LoggerSpool* spool = new LoggerSpool(sd);
+    LoggerMacros* macros = new LoggerMacros();
     LoggerControllerState* state;
+    PersistentState<LoggerControllerState> persistent_state; // EEPROM slots of the state
     LoggerCommand* command = new LoggerCommand();
     std::vector<LoggerComponent*> components;
+    LoggerTimers timers; // timers of the controller and components (run from update() when they are due)
+    LoggerTime timestamp; // date time (formatted at most once per second)
 
     // global tracker of sequential data reader
     bool sequential_data_read_in_progress = false;
@@ -472,8 +701,11 @@ class LoggerController {
     LoggerController (const char *version, int reset_pin) : LoggerController(version, reset_pin, new LoggerControllerState(), false) {}
     LoggerController (const char *version, int reset_pin, bool enable_sd) : LoggerController(version, reset_pin, new LoggerControllerState(), enable_sd) {}
     LoggerController (const char *version, int reset_pin, LoggerControllerState *state) : LoggerController(version, reset_pin, state, false) {}
-    LoggerController (const char *version, int reset_pin, LoggerControllerState *state, bool enable_sd) : version(version), reset_pin(reset_pin), state(state), sd_enabled(enable_sd) {
-      eeprom_location = eeprom_start + sizeof(*state);
+    LoggerController (const char *version, int reset_pin, LoggerControllerState *state, bool enable_sd) : reset_pin(reset_pin), sd_enabled(enable_sd), version(version), state(state), persistent_state(state, controller_state_fields, CONTROLLER_STATE_RECORD) {
+      persistent_state.setLegacyLayout<LoggerControllerStateV5>(5, controller_state_v5_fields);
+      eeprom_location = eeprom_start + persistent_state.getSize();
+      legacy_eeprom_location = eeprom_start + persistent_state.getLegacySize();
+      registerControllerCommands();
     }
 
     /*** debugs ***/
@@ -497,26 +729,45 @@ class LoggerController {
     virtual void initComponents();
     virtual void completeStartup();
     bool isStartupComplete();
+    bool isSdEnabled(); // whether the controller uses an sd card
 
     /*** loop ***/
     void update();
+    void updateTimers(); // run the timers that are due
+    void updateComponents(); // update the components that check something on every loop pass
+    virtual void handleTimer(LoggerTimer* timer); // controller timers (data log, time sync, restart)
+    void triggerReset(uint32_t type); // restart after the reset delay
 
     /*** logger name capture ***/
     void captureName(const char *topic, const char *data);
 
     /*** state management ***/
-    virtual size_t getStateSize() { return(sizeof(*state)); }
+    virtual size_t getStateSize() { return(persistent_state.getSize()); }
     virtual void loadState(bool reset);
     virtual void loadDisplayState(bool reset);
     virtual void loadComponentsState(bool reset);
     virtual void saveState(bool always = false);
     virtual bool restoreState();
     virtual void resetState();
+    void readLegacyEEPROM();
+    void clearLegacyEEPROM();
+    const uint8_t* getLegacyEEPROM(size_t start, size_t size);
 
     /*** command parsing ***/
     int receiveCommand (String command); // receive cloud command
+    int receiveBatch (const char* batch); // receive several commands separated by CMD_BATCH_SEPARATOR
+    int runActions (const char* label, const char* actions); // run the logger's own commands as one action batch
+    bool deferStateSave(LoggerComponent* component); // in an action batch: save the state at its end (false = save now)
+    bool deferStepLog(LoggerComponent* component, uint8_t step_i); // in an action batch: log the step data at its end (false = log now)
+    bool isStepLogDeferred(LoggerComponent* component);
+    LoggerTrace* startActionTrace(); // dry run: record the commands of action batches instead of running them (in the cleared trace returned)
+    void stopActionTrace(); // run the commands of action batches again
+    const LoggerTrace* getActionTrace() { return(action_trace); } // trace of the last dry run (0 if there was none)
+    void readConsole(); // read commands from the USB serial console (non-blocking)
+    void runConsoleLine(const char* line); // command or query from the console
     virtual void parseCommand (); // parse a cloud command
     virtual void parseComponentsCommand(); // parse a cloud command in the components    
+    void registerCommand(const char* root, LoggerComponent* component); // route a command root to a component
     bool parseLocked();
     bool parseDebug();
     bool parseTimezone();
@@ -524,12 +775,17 @@ class LoggerController {
     bool parseSdLogging();
     bool parseStateLogging();
     bool parseDataLogging();
+    bool parseLogBatching();
     bool parseDataLoggingPeriod();
     bool parseDataReadingPeriod();
     bool parseReset();
     bool parseRestart();
     bool parsePage();
     bool parseSdTest();
+    bool parseSdFlush();
+    bool parseSdFormat();
+    bool parseMacro();
+    bool parseRun();
 
     /*** state changes ***/
     bool changeLocked(bool on);
@@ -541,6 +797,8 @@ class LoggerController {
     bool changeSdLogging(bool on);
     bool changeStateLogging(bool on);
     bool changeDataLogging(bool on);
+    bool changeLogBatching(bool on);
+    bool changeSdFormat(bool binary);
     bool changeDataLoggingPeriod(int period, int type);
     bool changeDataReadingPeriod(int period);
 
@@ -558,7 +816,7 @@ class LoggerController {
     /*** logger state variable ***/
     virtual void updateStateVariable();
     virtual void assembleStateVariable();
-    virtual void assembleComponentsStateVariable();
+    virtual void assembleChangedStateVariable(); // re-assemble the state fragments from the first changed one
     void addToStateVariableBuffer(char* info);
     virtual void postStateVariable();
 
@@ -566,6 +824,7 @@ class LoggerController {
     virtual void assembleStartupLog(); 
     virtual void assembleMissedDataLog();
     virtual void assembleStateLog(); 
+    virtual void assembleStateLog(const char* type, const char* data, const char* msg, const char* notes); 
     virtual void queueStateLog(bool log_always = false); 
     virtual void publishStateLog();
     virtual void saveStateLogToSD();
@@ -579,15 +838,36 @@ class LoggerController {
     /*** particle webhook data log ***/
     virtual bool isTimeForDataLogAndClear(); // whether it's time for data clear and log (if logging is on)
     virtual void restartLastDataLog(); // reset last data log
+    void scheduleDataLog(); // data log timer (due one period after the last data log)
     virtual void clearData(bool clear_persistent = false); // clear data fields
     virtual void logData(); 
     virtual void resetDataLog();
     virtual bool addToDataLogBuffer(char* info);
     virtual bool finalizeDataLog(bool use_common_time, unsigned long common_time = 0);
+    virtual bool isSdBinary(); // whether data logs go to the sd card as binary records
+    virtual bool addToDataRecord(LoggerData* data, bool include_time_offset); // binary record of the data added to the data log
+    virtual void assembleDataRecordHeader(); // names, keys and units for the binary records
     virtual void queueDataLog();
     virtual void publishDataLog();
     virtual void saveDataLogToSD();
 
+    /*** publishing ***/
+    virtual void startPublish(uint8_t source, size_t n, const char* webhook, const char* log); // start publishing without waiting for the acknowledgement
+    virtual void checkPublish(); // check on the publish in flight
+    virtual void cancelPublish(); // give up on the publish in flight (its logs are published again)
+
+    /*** batch publishing ***/
+    virtual bool addToBatchLog(const char* log); // add a log to the batch if it still fits
+    virtual size_t assembleBatchLog(LoggerQueue* queue); // batch of the oldest logs in the queue, returns the number of logs (only in batch_log if > 1)
+    virtual size_t assembleBatchLog(LoggerSpool* spool, char type); // batch of the oldest spooled logs of the same type
+
+    /*** sd card log spool ***/
+    virtual bool spoolLog(char type, const char* log);
+    virtual bool queueLog(LoggerQueue* queue, char type, const char* log); // queue (or spool) a log behind the older ones, returns false if it is lost
+    virtual size_t spoolQueuedLogs(LoggerQueue* queue, char type, size_t max); // move the oldest logs of a queue to the spool, returns how many
+    virtual bool spoolQueuedLogs(); // move all logs from the RAM queues to the spool (before a restart), returns whether the queues are empty
+    virtual void publishSpooledLog();
+
     /*** logger debug variable ***/
     virtual void updateDebugVariable();
     virtual void assembleComponentsDebugVariable();
@@ -5,7 +5,8 @@
 /*** constructors ***/
 
 // empty LCD = no display
-LoggerDisplay::LoggerDisplay (LoggerController *ctrl) : LoggerComponent("lcd", ctrl, false, false), Display(), state(new DisplayState()) {
+LoggerDisplay::LoggerDisplay (LoggerController *ctrl) : LoggerComponent("lcd", ctrl, false, false), Display(), state(new DisplayState()), persistent_state(state, display_state_fields, DISPLAY_STATE_RECORD) {
+    persistent_state.setLegacyLayout<DisplayState>(1, display_state_fields); // raw struct before the state slots
 }
 
 LoggerDisplay::LoggerDisplay (LoggerController *ctrl, uint8_t lcd_cols, uint8_t lcd_lines) : LoggerDisplay(ctrl, new DisplayState(), lcd_cols, lcd_lines, 1) {
@@ -17,7 +18,8 @@ LoggerDisplay::LoggerDisplay (LoggerController *ctrl, DisplayState *state, uint8
 LoggerDisplay::LoggerDisplay (LoggerController *ctrl, uint8_t lcd_cols, uint8_t lcd_lines, uint8_t n_pages) : LoggerDisplay(ctrl, new DisplayState(), lcd_cols, lcd_lines, n_pages) {
 }
 
-LoggerDisplay::LoggerDisplay (LoggerController *ctrl, DisplayState *state, uint8_t lcd_cols, uint8_t lcd_lines, uint8_t n_pages) : LoggerComponent("lcd", ctrl, false, false), Display(lcd_cols, lcd_lines, n_pages), state(state) {
+LoggerDisplay::LoggerDisplay (LoggerController *ctrl, DisplayState *state, uint8_t lcd_cols, uint8_t lcd_lines, uint8_t n_pages) : LoggerComponent("lcd", ctrl, false, false), Display(lcd_cols, lcd_lines, n_pages), state(state), persistent_state(state, display_state_fields, DISPLAY_STATE_RECORD) {
+    persistent_state.setLegacyLayout<DisplayState>(1, display_state_fields); // raw struct before the state slots
 }
 
 
@@ -41,12 +43,17 @@ void LoggerDisplay::update() {
 /*** state management ***/
     
 size_t LoggerDisplay::getStateSize() { 
-    return(sizeof(*state));
+    return(persistent_state.getSize());
+}
+
+size_t LoggerDisplay::getLegacyStateSize() { 
+    return(persistent_state.getLegacySize());
 }
 
 void LoggerDisplay::saveState(bool always) { 
+    state_changed = true; // state variable & display info out of date
     if (ctrl->state->save_state || always) {
-        EEPROM.put(eeprom_start, *state);
+        persistent_state.save(eeprom_start);
         if (ctrl->debug_state) {
             Serial.printf("DEBUG: component '%s' state saved in memory (if any updates were necessary)\n", id);
         }
@@ -56,16 +63,8 @@ void LoggerDisplay::saveState(bool always) {
 } 
 
 bool LoggerDisplay::restoreState() {
-    DisplayState *saved_state = new DisplayState();
-    EEPROM.get(eeprom_start, *saved_state);
-    bool recoverable = saved_state->version == state->version;
-    if(recoverable) {
-        EEPROM.get(eeprom_start, *state);
-        Serial.printf("INFO: successfully restored component state from memory (state version %d)\n", state->version);
-    } else {
-        Serial.printf("INFO: could not restore state from memory (found state version %d instead of %d), sticking with initial default\n", saved_state->version, state->version);
-        saveState(true);
-    }
+    bool recoverable = persistent_state.restore(eeprom_start, getLegacyState());
+    if (!recoverable) saveState(true);
     return(recoverable);
 }
 
@@ -85,6 +84,10 @@ void LoggerDisplay::assembleStateVariable() {
 
 /*** command parsing ***/
 
+void LoggerDisplay::registerCommands() {
+  ctrl->registerCommand(CMD_DISPLAY_ROOT, this);
+}
+
 bool LoggerDisplay::parseCommand(LoggerCommand *command) {
   if (command->parseVariable(CMD_DISPLAY_ROOT)) {    
     command->extractValue();
@@ -169,7 +172,7 @@ bool LoggerDisplay::parseColor(LoggerCommand *command) {
                 uint r = atoi(command->units);
                 uint g = atoi(command->units + r_end + 1);
                 uint b = atoi(command->units + g_end + 1);
-                if (r >= 0 && r < 256 && g >= 0 && g < 256 & b >= 0 && b < 256) {
+                if (r >= 0 && r < 256 && g >= 0 && g < 256 && b >= 0 && b < 256) {
                     valid = true;
                     command->success(changeColor(r, g, b));
                 }
@@ -67,6 +67,16 @@ struct DisplayState {
 
 };
 
+// EEPROM record of the state (ids of the fields and bytes reserved in each slot, with room for new fields)
+#define DISPLAY_STATE_RECORD 24
+static const StateField display_state_fields[] = {
+  STATE_FIELD(1, DisplayState, on),
+  STATE_FIELD(2, DisplayState, contrast),
+  STATE_FIELD(3, DisplayState, backlight_red),
+  STATE_FIELD(4, DisplayState, backlight_green),
+  STATE_FIELD(5, DisplayState, backlight_blue)
+};
+
 /*** state variable formatting ***/
 
 // power on/off
@@ -111,6 +121,7 @@ class LoggerDisplay : public LoggerComponent, public Display
 
      // state
     DisplayState* state;
+    PersistentState<DisplayState> persistent_state; // EEPROM slots of the state
 
     /*** constructors ***/
     LoggerDisplay (LoggerController *ctrl);
@@ -127,6 +138,7 @@ class LoggerDisplay : public LoggerComponent, public Display
 
     /*** state management ***/
     virtual size_t getStateSize();
+    virtual size_t getLegacyStateSize();
     virtual void saveState(bool always = false);
     virtual bool restoreState();
     virtual void resetState();
@@ -135,6 +147,7 @@ class LoggerDisplay : public LoggerComponent, public Display
     virtual void assembleStateVariable();
 
     /*** command parsing ***/
+    void registerCommands();
     bool parseCommand(LoggerCommand *command);
     bool parsePower(LoggerCommand *command);
     bool parseReset(LoggerCommand *command);
@@ -0,0 +1,73 @@
+#include "application.h"
+#include "LoggerMacros.h"
+#include "LoggerBuffer.h"
+
+bool LoggerMacros::init(size_t start, size_t eeprom_size, bool reset) {
+  eeprom_start = start;
+  enabled = start + getStateSize() <= eeprom_size;
+  if (!enabled) {
+    Serial.printlnf("WARNING: macros would exceed EEPROM size (%d bytes needed from %d), macros disabled", getStateSize(), start);
+    return(false);
+  }
+  if (reset) {
+    Serial.println("INFO: resetting macros");
+    *state = LoggerMacrosState();
+    persistent_state.save(eeprom_start);
+  } else if (persistent_state.restore(eeprom_start)) {
+    char names[MACROS_MAX * (MACRO_NAME_MAX + 1)];
+    getNames(names, sizeof(names));
+    Serial.printlnf("INFO: macros restored: %s", names);
+  }
+  return(true);
+}
+
+void LoggerMacros::resetState() {
+  if (!enabled) return;
+  state->version = 0; // force reset of the macros on restart
+  persistent_state.save(eeprom_start);
+  state->version = LoggerMacrosState().version;
+}
+
+LoggerMacro* LoggerMacros::find(const char* name) {
+  for (uint8_t i = 0; i < MACROS_MAX; i++) {
+    if (state->macros[i].name[0] != 0 && strcmp(state->macros[i].name, name) == 0) return(&state->macros[i]);
+  }
+  return(0);
+}
+
+const char* LoggerMacros::getCommands(const char* name) {
+  LoggerMacro* macro = find(name);
+  return(macro != 0 ? macro->commands : 0);
+}
+
+bool LoggerMacros::define(const char* name, const char* commands) {
+  if (!enabled) return(false);
+  LoggerMacro* macro = find(name);
+  // first unused macro
+  for (uint8_t i = 0; i < MACROS_MAX && macro == 0; i++) {
+    if (state->macros[i].name[0] == 0) macro = &state->macros[i];
+  }
+  if (macro == 0) return(false);
+  strncpy(macro->name, name, sizeof(macro->name) - 1);
+  macro->name[sizeof(macro->name) - 1] = 0;
+  strncpy(macro->commands, commands, sizeof(macro->commands) - 1);
+  macro->commands[sizeof(macro->commands) - 1] = 0;
+  persistent_state.save(eeprom_start);
+  return(true);
+}
+
+bool LoggerMacros::remove(const char* name) {
+  LoggerMacro* macro = find(name);
+  if (macro == 0) return(false);
+  macro->name[0] = 0;
+  macro->commands[0] = 0;
+  persistent_state.save(eeprom_start);
+  return(true);
+}
+
+void LoggerMacros::getNames(char* target, size_t size) {
+  LoggerBuffer names(target, size);
+  for (uint8_t i = 0; i < MACROS_MAX; i++) {
+    if (state->macros[i].name[0] != 0) names.addItem(state->macros[i].name);
+  }
+}
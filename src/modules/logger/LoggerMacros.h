@@ -0,0 +1,80 @@
+#pragma once
+#include "LoggerCommand.h"
+#include "PersistentState.h"
+
+/*** macros ***/
+#define MACROS_MAX          3 // macros stored on the device
+#define MACRO_NAME_MAX      8 // max characters of a macro name
+#define MACROS_SLOTS        2 // slots of the macros state (macros rarely change, 2 slots survive a power loss during a save)
+
+// macro: name and commands (separated by CMD_BATCH_SEPARATOR, run as a command batch)
+struct LoggerMacro {
+  char name[MACRO_NAME_MAX + 1]; // empty = unused
+  char commands[CMD_MAX_CHAR];
+};
+
+struct LoggerMacrosState {
+  LoggerMacro macros[MACROS_MAX];
+  uint8_t version = 1;
+
+  LoggerMacrosState() {
+    for (uint8_t i = 0; i < MACROS_MAX; i++) {
+      macros[i].name[0] = 0;
+      macros[i].commands[0] = 0;
+    }
+  };
+};
+
+// fields of the macros state (ids are never reused)
+static const StateField macros_state_fields[] = {
+  STATE_FIELD(1, LoggerMacrosState, macros[0]),
+  STATE_FIELD(2, LoggerMacrosState, macros[1]),
+  STATE_FIELD(3, LoggerMacrosState, macros[2])
+};
+#define MACROS_STATE_RECORD 224 // bytes reserved for the record (223 with all fields)
+
+// Macros are saved in EEPROM after the states of all components (so adding them does not move any other state)
+// and are always saved (also with state saving off, they are definitions rather than state)
+class LoggerMacros {
+
+  private:
+
+    LoggerMacrosState* state = new LoggerMacrosState();
+    PersistentState<LoggerMacrosState> persistent_state{state, macros_state_fields, MACROS_STATE_RECORD, MACROS_SLOTS};
+    size_t eeprom_start = 0;
+    bool enabled = false; // whether the macros fit into the EEPROM
+
+    LoggerMacro* find(const char* name);
+
+  public:
+
+    LoggerMacros () {}
+
+    // EEPROM bytes taken by the macros
+    size_t getStateSize() { return(persistent_state.getSize()); }
+
+    // restore the macros from the EEPROM at start (or go back to no macros if reset)
+    // @return false if the macros do not fit into the EEPROM
+    bool init(size_t start, size_t eeprom_size, bool reset);
+
+    // save empty macros with version 0 (no macros after the restart)
+    void resetState();
+
+    // commands of a macro
+    // @return 0 if there is no macro with this name
+    const char* getCommands(const char* name);
+
+    // define (or redefine) a macro
+    // @return false if all macros are taken or the macros could not be saved
+    bool define(const char* name, const char* commands);
+
+    // delete a macro
+    // @return false if there is no macro with this name
+    bool remove(const char* name);
+
+    // names of all macros (separated by commas)
+    void getNames(char* target, size_t size);
+
+    bool isEnabled() { return(enabled); }
+
+};
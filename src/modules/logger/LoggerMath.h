@@ -1,5 +1,6 @@
 #pragma once
 #include <math.h>
+#include <string.h>
 
 /**** NUMERIC DATA FUNCTIONS ****/
 
@@ -28,19 +29,78 @@ static double round_to_decimals (double number, int decimals) {
     return(round(number * factor) / factor);
 }
 
-// print a number to the specified decimals
-static void print_to_decimals (char* target, int size, double number, int decimals) {
+// print a number to the specified decimals with snprintf (works for any decimals and numbers)
+static void print_to_decimals_snprintf (char* target, int size, double number, int decimals) {
 
     // round
     double rounded_number = round_to_decimals(number, decimals);
 
     // print
     if (decimals < 0) decimals = 0;
-    char number_pattern[6];
+    char number_pattern[14];
     snprintf(number_pattern, sizeof(number_pattern), "%%.%df", decimals);
     snprintf(target, size, number_pattern, rounded_number);
 }
 
+// decimals range of the fast print_to_decimals (covers find_signif_decimals' default limit)
+#define FAST_DECIMALS_MIN -3
+#define FAST_DECIMALS_MAX 10
+
+// powers of ten for FAST_DECIMALS_MIN to FAST_DECIMALS_MAX (same values as pow(10.0, decimals))
+static const double powers_of_ten[] = {1e-3, 1e-2, 1e-1, 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10};
+
+// round a number to a whole number of steps of its last decimal (e.g. 12.345 with 2 decimals = 1235 steps)
+// @return false if the steps are not exact digits (decimals outside the fast range, nan/inf, numbers too large)
+static bool round_to_decimal_steps (double number, int decimals, double* steps) {
+    if (decimals < FAST_DECIMALS_MIN || decimals > FAST_DECIMALS_MAX || !isfinite(number)) return(false);
+    double factor = powers_of_ten[decimals - FAST_DECIMALS_MIN];
+    *steps = round(number * factor);
+    // digits are only exact well within double precision
+    return(fabs(*steps) < (decimals < 0 ? 1e15 * factor : 1e15));
+}
+
+// print a whole number of last decimal steps with the specified decimals (steps from round_to_decimal_steps)
+static void print_decimal_steps (char* target, int size, double steps, int decimals) {
+
+    if (size <= 0) return;
+
+    // integer digits from the back
+    unsigned long long digits = (unsigned long long) fabs(steps);
+    for (int i = decimals; i < 0; i++) digits *= 10;
+    char text[24];
+    char* pos = text + sizeof(text);
+    *--pos = 0;
+    for (int i = 0; i < decimals; i++) {
+        *--pos = '0' + digits % 10;
+        digits /= 10;
+    }
+    if (decimals > 0) *--pos = '.';
+    do {
+        *--pos = '0' + digits % 10;
+        digits /= 10;
+    } while (digits > 0);
+    if (signbit(steps)) *--pos = '-'; // includes -0 like snprintf
+
+    // copy (cut off like snprintf)
+    int length = text + sizeof(text) - 1 - pos;
+    if (length >= size) length = size - 1;
+    memcpy(target, pos, length);
+    target[length] = 0;
+}
+
+// print a number to the specified decimals
+// rounds to a whole number of the last digit and writes the digits directly instead of going through
+// pow and snprintf - the output is the same as print_to_decimals_snprintf (which it falls back on
+// for decimals outside the fast range, nan/inf and numbers too large for exact digits)
+static void print_to_decimals (char* target, int size, double number, int decimals) {
+    double steps;
+    if (round_to_decimal_steps(number, decimals, &steps)) {
+        print_decimal_steps(target, size, steps, decimals);
+    } else if (size > 0) {
+        print_to_decimals_snprintf(target, size, number, decimals);
+    }
+}
+
 // print a number to the specific significan digits
 static void print_to_signif (char* target, int size, double number, int signif) {
     print_to_decimals(target, size, number, find_signif_decimals(number, signif));
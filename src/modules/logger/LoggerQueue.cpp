@@ -0,0 +1,107 @@
+#include "application.h"
+#include "LoggerQueue.h"
+
+/*** header access (byte-packed, no alignment) ***/
+
+// bytes needed for a header
+#define QUEUE_HEADER_SIZE (sizeof(uint16_t) + sizeof(unsigned long))
+
+LoggerQueue::Header LoggerQueue::readHeader(size_t pos) {
+  Header header;
+  memcpy(&header.length, buffer + pos, sizeof(header.length));
+  memcpy(&header.queued, buffer + pos + sizeof(header.length), sizeof(header.queued));
+  return(header);
+}
+
+void LoggerQueue::writeHeader(size_t pos, uint16_t length, unsigned long queued) {
+  memcpy(buffer + pos, &length, sizeof(length));
+  memcpy(buffer + pos + sizeof(length), &queued, sizeof(queued));
+}
+
+/*** queue ***/
+
+bool LoggerQueue::push(const char* log) {
+
+  size_t length = strlen(log) + 1;
+  size_t n = QUEUE_HEADER_SIZE + length;
+
+  // empty queue: start from the beginning to have the most contiguous space
+  if (count == 0) head = tail = 0;
+
+  // find contiguous space
+  size_t pos;
+  if (length >= WRAP) {
+    return(false);
+  } else if (count > 0 && head == tail) {
+    // completely full
+    return(false);
+  } else if (head >= tail) {
+    // free space at the end and before the tail
+    if (size - head >= n) {
+      pos = head;
+    } else if (tail >= n) {
+      // wrap around (mark the rest of the buffer as unused if there is space for a marker)
+      if (size - head >= QUEUE_HEADER_SIZE) writeHeader(head, WRAP, 0);
+      used += size - head;
+      pos = 0;
+    } else {
+      return(false);
+    }
+  } else {
+    // free space between head and tail
+    if (tail - head >= n) {
+      pos = head;
+    } else {
+      return(false);
+    }
+  }
+
+  // store
+  writeHeader(pos, length, millis());
+  memcpy(buffer + pos + QUEUE_HEADER_SIZE, log, length);
+  head = pos + n;
+  used += n;
+  count++;
+  return(true);
+}
+
+const char* LoggerQueue::front() {
+  if (count == 0) return(0);
+  return((const char*) buffer + tail + QUEUE_HEADER_SIZE);
+}
+
+const char* LoggerQueue::peek(size_t i) {
+  if (i >= count) return(0);
+  size_t pos = tail;
+  for (size_t j = 0; j < i; j++) {
+    pos += QUEUE_HEADER_SIZE + readHeader(pos).length;
+    // skip the unused rest of the buffer
+    if (size - pos < QUEUE_HEADER_SIZE || readHeader(pos).length == WRAP) pos = 0;
+  }
+  return((const char*) buffer + pos + QUEUE_HEADER_SIZE);
+}
+
+void LoggerQueue::pop() {
+  if (count == 0) return;
+  size_t n = QUEUE_HEADER_SIZE + readHeader(tail).length;
+  tail += n;
+  used -= n;
+  count--;
+  if (count == 0) {
+    // empty
+    clear();
+  } else if (size - tail < QUEUE_HEADER_SIZE || readHeader(tail).length == WRAP) {
+    // rest of the buffer was skipped during push
+    used -= size - tail;
+    tail = 0;
+  }
+}
+
+void LoggerQueue::clear() {
+  head = tail = count = used = 0;
+}
+
+unsigned long LoggerQueue::getOldestAge() {
+  if (count == 0) return(0);
+  return(millis() - readHeader(tail).queued);
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Byte-packed ring buffer queue of log messages (first in, first out)
+// - stores variable-length logs contiguously in a preallocated buffer (no heap allocation per log)
+// - each log is stored as a small header (length, time queued) followed by the 0-terminated text
+// - logs that do not fit are rejected (the owner counts them as dropped if they are not kept elsewhere, e.g. spooled)
+class LoggerQueue {
+
+  private:
+
+    struct Header {
+      uint16_t length; // length of the text incl. terminating 0 (WRAP = rest of the buffer is unused)
+      unsigned long queued; // time when the log was queued (in ms)
+    };
+    static const uint16_t WRAP = 0xFFFF;
+
+    uint8_t* buffer;
+    size_t size;
+    size_t head = 0; // where the next log is written
+    size_t tail = 0; // where the oldest log starts
+    size_t count = 0; // number of logs in the queue
+    size_t used = 0; // bytes used by logs (headers included)
+    unsigned long dropped = 0; // number of logs lost because they did not fit
+
+    Header readHeader(size_t pos);
+    void writeHeader(size_t pos, uint16_t length, unsigned long queued);
+
+  public:
+
+    // wrap an existing byte array
+    LoggerQueue (uint8_t* buffer, size_t size) : buffer(buffer), size(size) {}
+    template<size_t N> LoggerQueue (uint8_t (&buffer)[N]) : LoggerQueue(buffer, N) {}
+
+    // add a log at the end of the queue
+    // @return false if there is not enough space
+    bool push(const char* log);
+
+    // oldest log (0 if the queue is empty), stays valid until pop()
+    const char* front();
+
+    // i-th oldest log (0 if there are not that many)
+    const char* peek(size_t i);
+
+    // remove the oldest log
+    void pop();
+
+    // remove all logs
+    void clear();
+
+    // status
+    bool isEmpty() const { return(count == 0); }
+    size_t getCount() const { return(count); }
+    size_t getBytesUsed() const { return(used); }
+    size_t getSize() const { return(size); }
+    void addDropped() { dropped++; } // a rejected log that is lost
+    unsigned long getDropped() const { return(dropped); }
+    unsigned long getOldestAge(); // how long the oldest log has been waiting (in ms, 0 if empty)
+
+};
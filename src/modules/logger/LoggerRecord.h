@@ -0,0 +1,266 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include "LoggerMath.h"
+
+/**** BINARY LOG RECORDS ****/
+
+// compact alternative to the JSON data logs on the SD card (decoded back to JSON/CSV on a computer with sd-decode)
+// records start with their type and continue with fields until the end of the record, numbers are varints
+// (7 bits per byte, low bits first, signed numbers zigzag encoded):
+//  - header 'H': format version, logger name, then for each data: idx, key, units
+//  - data log 'L': epoch, common time offset + 1 (0 = individual time offsets), then for each data:
+//      idx, n, decimals, flags, value, sigma (only if n > 1), time offset (only if individual)
+//    value and sigma are stored as the whole number of their last decimal (i.e. the printed digits) or,
+//    if the digits would not be exact (nan, inf, too many digits, -0), as the raw 8 byte double
+// records are written as frames of 2 length bytes (7 bits each, high bit set) + the COBS encoded record,
+// i.e. frames contain no 0 bytes and can be written as strings
+#define RECORD_VERSION       1
+#define RECORD_HEADER        'H'
+#define RECORD_DATA_LOG      'L'
+#define RECORD_MAX_SIZE      512 // bytes per record
+#define RECORD_FRAME_SIZE    (RECORD_MAX_SIZE + RECORD_MAX_SIZE / 254 + 24) // + length, COBS overhead, a data log's own fields, terminating 0
+
+// data flags
+#define RECORD_VALUE_STEPS   0x01 // value stored as steps of the last decimal (otherwise double)
+#define RECORD_SIGMA_STEPS   0x02 // sigma stored as steps of the last decimal (otherwise double)
+
+// appends record fields to a fixed byte buffer
+// fields that do not fit are dropped and the record is flagged as truncated
+class LoggerRecord {
+
+  private:
+
+    uint8_t* record;
+    size_t size;
+    size_t pos = 0;
+    bool truncated = false;
+
+    // value as steps of the last decimal if they are exact (same digits as print_to_decimals)
+    static bool getSteps(double value, int decimals, long long* steps) {
+      double rounded;
+      if (!round_to_decimal_steps(value, decimals, &rounded) || (rounded == 0 && signbit(rounded))) return(false);
+      *steps = (long long) rounded;
+      return(true);
+    }
+
+    void addStepsOrDouble(bool is_steps, long long steps, double value) {
+      if (is_steps) addSigned(steps);
+      else addDouble(value);
+    }
+
+  public:
+
+    // wrap an existing byte array
+    LoggerRecord (uint8_t* record, size_t size) : record(record), size(size) {}
+    template<size_t N> LoggerRecord (uint8_t (&record)[N]) : LoggerRecord(record, N) {}
+
+    // clear the record
+    void reset() {
+      pos = 0;
+      truncated = false;
+    }
+
+    // fields
+    bool add(uint8_t byte) {
+      if (pos >= size) {
+        truncated = true;
+        return(false);
+      }
+      record[pos++] = byte;
+      return(true);
+    }
+
+    bool addVarint(unsigned long long number) {
+      while (number >= 0x80) {
+        if (!add((uint8_t) (number | 0x80))) return(false);
+        number >>= 7;
+      }
+      return(add((uint8_t) number));
+    }
+
+    bool addSigned(long long number) {
+      // zigzag: 0, -1, 1, -2, ... --> 0, 1, 2, 3, ...
+      return(addVarint(((unsigned long long) number << 1) ^ (unsigned long long) (number >> 63)));
+    }
+
+    bool addDouble(double number) {
+      // little endian IEEE 754
+      uint64_t bits;
+      memcpy(&bits, &number, sizeof(bits));
+      for (uint8_t i = 0; i < 8; i++) {
+        if (!add((uint8_t) (bits >> (8 * i)))) return(false);
+      }
+      return(true);
+    }
+
+    bool addString(const char* text) {
+      size_t length = strlen(text);
+      if (!addVarint(length)) return(false);
+      for (size_t i = 0; i < length; i++) {
+        if (!add((uint8_t) text[i])) return(false);
+      }
+      return(true);
+    }
+
+    // one data of a data log (fields in the order of the JSON data log)
+    bool addData(int idx, int n, int decimals, double value, double sigma, bool include_time_offset, unsigned long time_offset) {
+      long long value_steps = 0, sigma_steps = 0;
+      uint8_t flags = 0;
+      if (getSteps(value, decimals, &value_steps)) flags |= RECORD_VALUE_STEPS;
+      if (n > 1 && getSteps(sigma, decimals, &sigma_steps)) flags |= RECORD_SIGMA_STEPS;
+      addSigned(idx);
+      addVarint(n);
+      addSigned(decimals);
+      add(flags);
+      addStepsOrDouble(flags & RECORD_VALUE_STEPS, value_steps, value);
+      if (n > 1) addStepsOrDouble(flags & RECORD_SIGMA_STEPS, sigma_steps, sigma);
+      if (include_time_offset) addVarint(time_offset);
+      return(!truncated);
+    }
+
+    // status
+    const uint8_t* getRecord() const { return(record); }
+    size_t length() const { return(pos); }
+    bool isEmpty() const { return(pos == 0); }
+    bool isTruncated() const { return(truncated); }
+
+    // frame of one or two records (e.g. a data log's fields + its data) as a 0 terminated string
+    // @return frame length (0 if it does not fit into the target)
+    static size_t encodeFrame(char* target, size_t size, const LoggerRecord& first, const LoggerRecord& second) {
+      if (size < 4) return(0);
+      // COBS: every 0 byte is replaced with the distance to the next one (code bytes), runs are at most 254 bytes
+      uint8_t* frame = (uint8_t*) target;
+      size_t total = first.length() + second.length();
+      size_t code_pos = 2, pos = 3;
+      uint8_t code = 1;
+      for (size_t i = 0; i < total; i++) {
+        uint8_t byte = (i < first.length()) ? first.getRecord()[i] : second.getRecord()[i - first.length()];
+        if (pos + 2 >= size) {
+          target[0] = 0;
+          return(0);
+        }
+        if (byte == 0) {
+          frame[code_pos] = code;
+          code_pos = pos++;
+          code = 1;
+        } else {
+          frame[pos++] = byte;
+          if (++code == 0xFF) {
+            frame[code_pos] = code;
+            code_pos = pos++;
+            code = 1;
+          }
+        }
+      }
+      frame[code_pos] = code;
+      size_t length = pos - 2;
+      if (length >= 0x4000) {
+        target[0] = 0;
+        return(0);
+      }
+      frame[0] = 0x80 | (length & 0x7F);
+      frame[1] = 0x80 | (length >> 7);
+      frame[pos] = 0;
+      return(pos);
+    }
+
+    static size_t encodeFrame(char* target, size_t size, const LoggerRecord& record) {
+      uint8_t none[1] = {0};
+      return(encodeFrame(target, size, record, LoggerRecord(none, 0)));
+    }
+
+};
+
+// reads the fields of a record (from a frame)
+// reading past the end of the record flags the record as invalid (and returns 0s)
+class LoggerRecordReader {
+
+  private:
+
+    const uint8_t* record;
+    size_t length;
+    size_t pos = 0;
+    bool invalid = false;
+
+  public:
+
+    LoggerRecordReader (const uint8_t* record, size_t length) : record(record), length(length) {}
+
+    // record from the start of a frame
+    // @return bytes of the frame (0 if there is no complete frame at the start of the data)
+    static size_t decodeFrame(const uint8_t* data, size_t available, uint8_t* record, size_t size, size_t* record_length) {
+      if (available < 3 || !(data[0] & 0x80) || !(data[1] & 0x80)) return(0);
+      size_t length = (data[0] & 0x7F) | ((size_t) (data[1] & 0x7F) << 7);
+      if (length == 0 || 2 + length > available) return(0);
+      const uint8_t* frame = data + 2;
+      size_t i = 0, n = 0;
+      while (i < length) {
+        uint8_t code = frame[i++];
+        if (code == 0 || i + code - 1 > length) return(0);
+        for (uint8_t j = 1; j < code; j++) {
+          if (n >= size || frame[i] == 0) return(0);
+          record[n++] = frame[i++];
+        }
+        if (code != 0xFF && i < length) {
+          if (n >= size) return(0);
+          record[n++] = 0;
+        }
+      }
+      *record_length = n;
+      return(2 + length);
+    }
+
+    // fields
+    uint8_t read() {
+      if (pos >= length) {
+        invalid = true;
+        return(0);
+      }
+      return(record[pos++]);
+    }
+
+    unsigned long long readVarint() {
+      unsigned long long number = 0;
+      for (uint8_t shift = 0; shift < 64; shift += 7) {
+        uint8_t byte = read();
+        number |= (unsigned long long) (byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return(number);
+      }
+      invalid = true;
+      return(0);
+    }
+
+    long long readSigned() {
+      unsigned long long number = readVarint();
+      return((long long) (number >> 1) ^ -(long long) (number & 1));
+    }
+
+    double readDouble() {
+      uint64_t bits = 0;
+      for (uint8_t i = 0; i < 8; i++) bits |= (uint64_t) read() << (8 * i);
+      double number;
+      memcpy(&number, &bits, sizeof(number));
+      return(number);
+    }
+
+    // string (cut off to the target size)
+    void readString(char* target, size_t size) {
+      size_t text_length = readVarint();
+      if (invalid || text_length > length - pos) {
+        invalid = true;
+        text_length = 0;
+      }
+      size_t n = (size > 0 && text_length >= size) ? size - 1 : text_length;
+      if (size > 0) {
+        memcpy(target, record + pos, n);
+        target[n] = 0;
+      }
+      pos += text_length;
+    }
+
+    // status
+    bool isDone() const { return(pos >= length); }
+    bool isValid() const { return(!invalid); }
+
+};
@@ -25,4 +25,186 @@ bool LoggerSD::syncFile() {
     if (available()) present = OpenLog::syncFile();
     if (!present) Serial.println("ERROR: could not write to SD card.");
     return(present);
-}
\ No newline at end of file
+}
+
+/*** buffered log writing ***/
+
+bool LoggerSD::appendLine(char type, const char* line) {
+    // line + CRLF (same as println)
+    return(addToBuffer(type, line, "\r\n"));
+}
+
+bool LoggerSD::appendRecord(char type, const char* frame) {
+    // frames know their own length
+    return(addToBuffer(type, frame, ""));
+}
+
+void LoggerSD::setFileHeader(char type, const char* frame) {
+    // records buffered so far belong to the previous header
+    for (uint8_t i = 0; i < SD_BUFFER_FILES; i++) {
+        if (buffers[i].type == type) {
+            flushBuffer(&buffers[i]);
+            buffers[i].header_written = false;
+        }
+    }
+    header_type = type;
+    header = frame;
+}
+
+bool LoggerSD::addToBuffer(char type, const char* text, const char* end) {
+
+    // find the type's buffer (or an unused one)
+    LoggerSDBuffer* buffer = 0;
+    for (uint8_t i = 0; i < SD_BUFFER_FILES && buffer == 0; i++) {
+        if (buffers[i].type == type) buffer = &buffers[i];
+    }
+    for (uint8_t i = 0; i < SD_BUFFER_FILES && buffer == 0; i++) {
+        // unused or empty buffer of a type no longer logged (e.g. after switching to binary data logs)
+        if (buffers[i].type == 0 || buffers[i].length == 0) {
+            buffer = &buffers[i];
+            *buffer = LoggerSDBuffer();
+        }
+    }
+    if (buffer == 0) {
+        // all buffers taken by other types --> make room
+        buffer = &buffers[0];
+        flushBuffer(buffer);
+        *buffer = LoggerSDBuffer();
+    }
+    buffer->type = type;
+
+    // lines of a new day go into the new day's file
+    time_t now = Time.now();
+    if (buffer->length > 0 && now / 86400 != buffer->first_line_time / 86400) {
+        if (!flushBuffer(buffer)) return(false);
+    }
+
+    size_t text_length = strlen(text);
+    size_t end_length = strlen(end);
+    if (buffer->length + text_length + end_length >= sizeof(buffer->lines)) {
+        // text does not fit anymore --> write what is buffered
+        if (!flushBuffer(buffer)) return(false);
+    }
+    if (text_length + end_length >= sizeof(buffer->lines)) {
+        // text too long for the buffer --> write directly
+        return(writeToLogFile(buffer, now, text, end));
+    }
+    if (buffer->length == 0) {
+        buffer->first_line_at = millis();
+        buffer->first_line_time = now;
+    }
+    memcpy(buffer->lines + buffer->length, text, text_length);
+    buffer->length += text_length;
+    memcpy(buffer->lines + buffer->length, end, end_length);
+    buffer->length += end_length;
+    buffer->lines[buffer->length] = 0;
+    return(true);
+}
+
+bool LoggerSD::flushBuffer(LoggerSDBuffer* buffer) {
+    if (buffer->length == 0) return(true);
+    // the lines in 31 byte chunks and one sync
+    bool success = writeToLogFile(buffer, buffer->first_line_time, buffer->lines);
+    if (!success) {
+        Serial.printlnf("ERROR: %d bytes for SD card file '%s' lost.", buffer->length, buffer->file_name);
+    }
+    buffer->length = 0;
+    buffer->lines[0] = 0;
+    return(success);
+}
+
+bool LoggerSD::writeToLogFile(LoggerSDBuffer* buffer, time_t time, const char* text, const char* end) {
+    size_t header_length = (header != 0 && header_type == buffer->type) ? strlen(header) : 0;
+    size_t length = strlen(text) + strlen(end);
+    if (!available() || !selectLogFile(buffer, time, header_length + length)) return(false);
+    if (header_length > 0 && !buffer->header_written) {
+        writeString(header);
+        buffer->file_size += header_length;
+        buffer->header_written = true;
+    }
+    writeString(text);
+    if (end[0] != 0) writeString(end);
+    if (!syncFile()) return(false);
+    buffer->file_size += length;
+    return(true);
+}
+
+void LoggerSD::update() {
+    for (uint8_t i = 0; i < SD_BUFFER_FILES; i++) {
+        if (buffers[i].length > 0 && millis() - buffers[i].first_line_at > SD_BUFFER_MAX_AGE) flushBuffer(&buffers[i]);
+    }
+}
+
+bool LoggerSD::flush() {
+    bool success = true;
+    for (uint8_t i = 0; i < SD_BUFFER_FILES; i++) {
+        if (!flushBuffer(&buffers[i])) success = false;
+    }
+    return(success);
+}
+
+size_t LoggerSD::getBuffered() {
+    size_t bytes = 0;
+    for (uint8_t i = 0; i < SD_BUFFER_FILES; i++) bytes += buffers[i].length;
+    return(bytes);
+}
+
+/*** log file rotation ***/
+
+void LoggerSD::getLogFileName(char type, time_t time, uint8_t part, char* target, int size) {
+    // 8.3 file name
+    snprintf(target, size, "%c%s%c.%s", type, Time.format(time, "%y%m%d").c_str(), SD_LOG_FILE_PARTS[part], type == SD_BINARY_LOG ? "BIN" : "LOG");
+}
+
+void LoggerSD::getIndexFileName(time_t time, char* target, int size) {
+    snprintf(target, size, "IX%s.IDX", Time.format(time, "%y%m%d").c_str());
+}
+
+bool LoggerSD::selectLogFile(LoggerSDBuffer* buffer, time_t time, size_t bytes) {
+
+    long day = time / 86400;
+    uint8_t last_part = strlen(SD_LOG_FILE_PARTS) - 1;
+    if (day != buffer->file_day) {
+        // new day (or first write since the restart) --> continue with the day's last part
+        buffer->file_day = day;
+        buffer->file_part = 0;
+        buffer->indexed_size = -1;
+        buffer->header_written = false;
+        getLogFileName(buffer->type, time, 0, buffer->file_name, sizeof(buffer->file_name));
+        buffer->file_size = size(buffer->file_name);
+        while (buffer->file_size >= SD_LOG_FILE_MAX_SIZE && buffer->file_part < last_part) {
+            buffer->file_part++;
+            getLogFileName(buffer->type, time, buffer->file_part, buffer->file_name, sizeof(buffer->file_name));
+            buffer->file_size = size(buffer->file_name);
+        }
+        if (buffer->file_size < 0) buffer->file_size = 0; // new file
+        // existing file was indexed before the restart, next entry once the interval is reached
+        if (buffer->file_size > 0) buffer->indexed_size = buffer->file_size;
+    } else if (buffer->file_size > 0 && buffer->file_size + bytes > SD_LOG_FILE_MAX_SIZE && buffer->file_part < last_part) {
+        // file full --> next part
+        buffer->file_part++;
+        buffer->file_size = 0;
+        buffer->indexed_size = -1;
+        buffer->header_written = false;
+        getLogFileName(buffer->type, time, buffer->file_part, buffer->file_name, sizeof(buffer->file_name));
+    }
+
+    // index entry for the start of a file and then every SD_INDEX_INTERVAL bytes
+    if (buffer->indexed_size < 0 || buffer->file_size - buffer->indexed_size >= SD_INDEX_INTERVAL) {
+        if (!addIndexEntry(buffer, time)) return(false);
+    }
+
+    return(append(buffer->file_name) > 0);
+}
+
+bool LoggerSD::addIndexEntry(LoggerSDBuffer* buffer, time_t time) {
+    char index_file[13];
+    getIndexFileName(time, index_file, sizeof(index_file));
+    char entry[40];
+    snprintf(entry, sizeof(entry), "%s %lu %ld\r\n", buffer->file_name, (unsigned long) time, buffer->file_size);
+    append(index_file);
+    writeString(entry);
+    if (!syncFile()) return(false);
+    buffer->indexed_size = buffer->file_size;
+    return(true);
+}
@@ -2,6 +2,38 @@
 
 #include "SparkFun_Qwiic_OpenLog_Arduino_Library.h"
 
+// write-behind buffer for log lines
+#define SD_BUFFER_FILES    2     // how many log types can have buffered lines at the same time (state and data logs)
+#define SD_BUFFER_SIZE     1024  // bytes buffered per log type, lines are written to the card once the next one does not fit anymore
+#define SD_BUFFER_MAX_AGE  30000 // max time lines wait in the buffer before they are written to the card (in ms)
+
+// log files rotated by UTC day and size (8.3 file names): <type><YYMMDD><part>.LOG, e.g. D2610170.LOG for the first data log file of 2026-10-17
+#define SD_STATE_LOG          'S'
+#define SD_DATA_LOG           'D'
+#define SD_BINARY_LOG         'B' // binary data log records (see LoggerRecord.h), <type><YYMMDD><part>.BIN
+#define SD_LOG_FILE_MAX_SIZE  1048576 // continue with the next part of the day beyond this size (in bytes)
+#define SD_LOG_FILE_PARTS     "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ" // parts of a day, the last one keeps growing
+
+// index of each day's log files: IX<YYMMDD>.IDX with lines "<file> <epoch> <offset>" = logs from <epoch> on start at byte <offset> of <file>
+#define SD_INDEX_INTERVAL     65536 // bytes between index entries within a log file
+
+// lines waiting to be written to a log file
+struct LoggerSDBuffer {
+    char type = 0; // log type (SD_STATE_LOG, SD_DATA_LOG), 0 = unused
+    char lines[SD_BUFFER_SIZE];
+    size_t length = 0;
+    unsigned long first_line_at = 0; // when the oldest line was buffered (millis)
+    time_t first_line_time = 0; // date time of the oldest line
+    // current log file
+    char file_name[13];
+    long file_day = -1; // UTC day of the log file (days since 1970)
+    uint8_t file_part = 0;
+    long file_size = 0;
+    long indexed_size = -1; // file size at the last index entry
+    bool header_written = false; // whether the type's file header is in the current log file
+    LoggerSDBuffer() { lines[0] = 0; file_name[0] = 0; }
+};
+
 // Display class handles displaying information
 class LoggerSD : public OpenLog {
 
@@ -13,6 +45,24 @@ class LoggerSD : public OpenLog {
         // sd card present
         bool present = false;
 
+        // buffered lines
+        LoggerSDBuffer buffers[SD_BUFFER_FILES];
+
+        // header at the start of each log file of a type (e.g. the keys and units of binary data logs)
+        char header_type = 0;
+        const char* header = 0;
+
+        // add text to the type's buffer (or write it directly if it is too long for the buffer)
+        bool addToBuffer(char type, const char* text, const char* end);
+
+        // write the lines of one log type to the card
+        bool flushBuffer(LoggerSDBuffer* buffer);
+        bool writeToLogFile(LoggerSDBuffer* buffer, time_t time, const char* text, const char* end = ""); // text + end (+ the header for a new file)
+
+        // log file rotation
+        bool selectLogFile(LoggerSDBuffer* buffer, time_t time, size_t bytes); // day's log file with room for the bytes
+        bool addIndexEntry(LoggerSDBuffer* buffer, time_t time); // logs from this time on start at the current end of the file
+
     public:
 
         // initialize the sd reader
@@ -24,5 +74,16 @@ class LoggerSD : public OpenLog {
         // sync file
         bool syncFile();
 
-};
+        // buffered log writing (instead of append + println + syncFile for every line)
+        bool appendLine(char type, const char* line); // add a log line to the type's buffer
+        bool appendRecord(char type, const char* frame); // add a binary record frame to the type's buffer (no line end)
+        void setFileHeader(char type, const char* frame); // write this at the start of the type's log files (kept as pointer)
+        void update(); // write lines that have been waiting for too long
+        bool flush(); // write all buffered lines to the card (e.g. before a restart)
+        size_t getBuffered(); // bytes waiting to be written
+
+        // file names
+        void getLogFileName(char type, time_t time, uint8_t part, char* target, int size);
+        void getIndexFileName(time_t time, char* target, int size);
 
+};
@@ -0,0 +1,218 @@
+#include "application.h"
+#include "LoggerSpool.h"
+#include "PersistentState.h"
+
+/*** files ***/
+
+void LoggerSpool::getSegmentFileName(unsigned long i, char* target, int size) {
+  snprintf(target, size, "SP%06lu.LOG", i % 1000000); // 8.3 file name
+}
+
+bool LoggerSpool::loadIndex(uint8_t copy, unsigned long* position) {
+  char file_name[15];
+  snprintf(file_name, sizeof(file_name), SPOOL_INDEX_FILE, copy);
+  long index_size = sd->size(file_name);
+  if (index_size <= 0) return(false);
+  char index[80] = {0};
+  sd->read((uint8_t*) index, min(index_size, (long) sizeof(index) - 1), file_name);
+  // position followed by the CRC of its text
+  unsigned long crc;
+  int crc_start = 0;
+  if (sscanf(index, "%lu %lu %lu %lu %lu %lu %n%lx", &position[0], &position[1], &position[2], &position[3], &position[4], &position[5], &crc_start, &crc) != 7 ||
+      compute_crc32((const uint8_t*) index, crc_start) != crc) {
+    Serial.printlnf("WARNING: log spool index %s is corrupt: '%s'", file_name, index);
+    return(false);
+  }
+  return(true);
+}
+
+bool LoggerSpool::saveIndex() {
+  // sequence, read segment, read offset, write segment, write size, count + CRC (to the older of the two files)
+  char index[80];
+  int n = snprintf(index, sizeof(index), "%lu %lu %lu %lu %lu %lu ", index_sequence + 1, read_segment, read_offset, write_segment, write_size, count);
+  snprintf(index + n, sizeof(index) - n, "%08lx\r\n", (unsigned long) compute_crc32((const uint8_t*) index, n));
+  char file_name[15];
+  snprintf(file_name, sizeof(file_name), SPOOL_INDEX_FILE, (int) ((index_sequence + 1) % 2));
+  sd->removeFile(file_name);
+  sd->append(file_name);
+  sd->writeString(index);
+  if (!sd->syncFile()) return(false);
+  index_sequence++;
+  return(true);
+}
+
+unsigned long LoggerSpool::countAppended() {
+  // lines in the write segment after the saved size and in any segments started after it
+  unsigned long appended = 0;
+  unsigned long from = write_size;
+  char file_name[15];
+  for (unsigned long i = write_segment; ; i++) {
+    getSegmentFileName(i, file_name, sizeof(file_name));
+    long file_size = sd->size(file_name);
+    if (file_size < 0 && i > write_segment) break;
+    if (file_size > SPOOL_SEGMENT_SIZE) file_size = SPOOL_SEGMENT_SIZE;
+    write_segment = i;
+    write_size = (file_size > 0) ? file_size : 0;
+    if (write_size > from) {
+      sd->read((uint8_t*) segment, write_size, file_name);
+      for (unsigned long j = from; j < write_size; j++) if (segment[j] == '\n') appended++;
+      // line cut off by a power loss: continue in a new segment
+      if (segment[write_size - 1] != '\n') {
+        write_segment++;
+        write_size = 0;
+      }
+    }
+    from = 0;
+  }
+  return(appended);
+}
+
+bool LoggerSpool::init() {
+  ready = false;
+  if (!sd->available()) {
+    Serial.println("WARNING: no SD card, log spool not available");
+    return(false);
+  }
+  // newest intact copy of the index
+  unsigned long position[6], newest[6] = {0, 1, 0, 1, 0, 0};
+  for (uint8_t copy = 0; copy < 2; copy++) {
+    if (loadIndex(copy, position) && position[0] > newest[0] && position[1] > 0 && position[3] >= position[1])
+      memcpy(newest, position, sizeof(newest));
+  }
+  index_sequence = newest[0];
+  read_segment = newest[1];
+  read_offset = newest[2];
+  write_segment = newest[3];
+  write_size = newest[4];
+  count = newest[5];
+  unsigned long appended = countAppended();
+  count += appended;
+  segment_loaded = 0;
+  ready = true;
+  if (count > 0) {
+    char file_name[15];
+    getSegmentFileName(read_segment, file_name, sizeof(file_name));
+    Serial.printlnf("INFO: log spool on SD card holds %lu logs (resuming at %s offset %lu, %lu logs spooled after the last index save)", 
+      count, file_name, read_offset, appended);
+  }
+  return(true);
+}
+
+/*** spooling ***/
+
+bool LoggerSpool::push(char type, const char* log) {
+  if (!ready && !init()) return(false);
+  size_t length = strlen(log) + 4; // type, space, \r\n
+  if (length > SPOOL_SEGMENT_SIZE) {
+    Serial.printlnf("ERROR: log too long for the spool (%d bytes)", length);
+    return(false);
+  }
+  // start a new segment if this one is full or already being drained
+  if (write_size + length > SPOOL_SEGMENT_SIZE || (segment_loaded == write_segment && write_size > 0)) {
+    write_segment++;
+    write_size = 0;
+  }
+  char file_name[15];
+  getSegmentFileName(write_segment, file_name, sizeof(file_name));
+  sd->append(file_name);
+  // whole strings (up to 31 bytes per i2c transaction instead of one per byte)
+  char prefix[3] = {type, ' ', 0};
+  sd->writeString(prefix);
+  sd->writeString(log);
+  sd->writeString("\r\n");
+  if (!sd->syncFile()) return(false);
+  write_size += length;
+  count++;
+  if (debug) Serial.printlnf("DEBUG: spooled log #%lu to %s: '%s'", count, file_name, log);
+  // no index save: the log is counted from the segment file after a reboot
+  return(true);
+}
+
+bool LoggerSpool::loadSegment() {
+  if (segment_loaded == read_segment) return(true);
+  // the segment being written is sealed once it is being drained
+  if (read_segment == write_segment) {
+    write_segment++;
+    write_size = 0;
+    saveIndex();
+  }
+  char file_name[15];
+  getSegmentFileName(read_segment, file_name, sizeof(file_name));
+  long file_size = sd->size(file_name);
+  if (file_size < 0) file_size = 0;
+  if (file_size > SPOOL_SEGMENT_SIZE) file_size = SPOOL_SEGMENT_SIZE;
+  if (file_size > 0) sd->read((uint8_t*) segment, file_size, file_name);
+  segment[file_size] = 0;
+  segment_size = file_size;
+  segment_loaded = read_segment;
+  return(true);
+}
+
+size_t LoggerSpool::skipLine(size_t offset) {
+  // lines are terminated by terminateLine() or still end with \r\n
+  offset += strcspn(segment + offset, "\n");
+  while (offset < segment_size && (segment[offset] == 0 || segment[offset] == '\r' || segment[offset] == '\n')) offset++;
+  return(offset);
+}
+
+const char* LoggerSpool::terminateLine(size_t offset, char* type) {
+  if (offset + 2 >= segment_size) return(0);
+  char* line = segment + offset;
+  char* end = line + strcspn(line, "\n");
+  if (*end == 0 && end - segment < (long) segment_size) {
+    // already terminated
+  } else if (*end == '\n') {
+    *end = 0;
+    if (end > line && *(end - 1) == '\r') *(end - 1) = 0;
+  } else {
+    // incomplete line
+    return(0);
+  }
+  *type = line[0];
+  return(line + 2);
+}
+
+const char* LoggerSpool::front(char* type) {
+  if (count == 0 || (!ready && !init())) return(0);
+  // find the next complete line, moving on to the next segment if this one is done
+  while (true) {
+    loadSegment();
+    const char* log = terminateLine(read_offset, type);
+    if (log != 0) return(log);
+    // segment complete
+    if (read_segment >= write_segment) {
+      // nothing left even though the count says otherwise (e.g. card swapped)
+      Serial.printlnf("WARNING: log spool empty but %lu logs expected, resetting spool", count);
+      count = 0;
+      read_offset = 0;
+      saveIndex();
+      return(0);
+    }
+    // index first: a segment left behind by a power loss is not read again
+    char file_name[15];
+    getSegmentFileName(read_segment, file_name, sizeof(file_name));
+    read_segment++;
+    read_offset = 0;
+    saveIndex();
+    sd->removeFile(file_name);
+  }
+}
+
+const char* LoggerSpool::peek(size_t i, char* type) {
+  if (i == 0) return(front(type));
+  if (i >= count || segment_loaded != read_segment) return(0);
+  size_t offset = read_offset;
+  for (size_t j = 0; j < i && offset < segment_size; j++) offset = skipLine(offset);
+  return(terminateLine(offset, type));
+}
+
+void LoggerSpool::pop(size_t n) {
+  // positioned on the oldest log (e.g. logs moved here from the RAM queues while they were being published)
+  char type;
+  if (front(&type) == 0) return;
+  for (size_t i = 0; i < n && count > 0 && read_offset < segment_size; i++) {
+    read_offset = skipLine(read_offset);
+    count--;
+  }
+  saveIndex();
+}
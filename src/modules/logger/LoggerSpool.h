@@ -0,0 +1,75 @@
+#pragma once
+#include "LoggerSD.h"
+
+/*** spool ***/
+#define SPOOL_SEGMENT_SIZE     2048 // max bytes per spool file (each is read back in one go)
+#define SPOOL_INDEX_FILE       "spool%d.idx" // persisted read/write position of the spool (two copies, written in turn)
+#define SPOOL_TYPE_STATE       'S' // spooled state log
+#define SPOOL_TYPE_DATA        'D' // spooled data log
+
+// Logs that do not fit into the RAM log queues are spooled to the SD card
+// - logs are appended to numbered segment files (SP000001.LOG, SP000002.LOG, ...), one log per line prefixed by its type
+// - the read position (segment + offset) is saved in the index after every log taken from the spool
+//   so that draining resumes where it stopped after a reboot
+// - the index is written to two files in turn, each with a sequence number and a CRC-32: a save interrupted
+//   by a power loss leaves the other file intact
+// - spooling a log does not save the index, logs appended after the last save are counted from the
+//   segment files when the spool is restored
+// - the Qwiic OpenLog can only read files from the start, so the segment being drained is read in full
+//   into a buffer and is no longer appended to
+class LoggerSpool {
+
+  private:
+
+    LoggerSD* sd;
+    bool ready = false; // whether the index was restored
+
+    // position
+    unsigned long read_segment = 1;
+    unsigned long read_offset = 0;
+    unsigned long write_segment = 1;
+    unsigned long write_size = 0; // bytes in the write segment
+    unsigned long count = 0; // logs in the spool
+    unsigned long index_sequence = 0; // sequence number of the last index save
+
+    // segment being drained
+    char segment[SPOOL_SEGMENT_SIZE + 1];
+    unsigned long segment_loaded = 0; // which segment is in the buffer (0 = none)
+    unsigned long segment_size = 0;
+
+    void getSegmentFileName(unsigned long i, char* target, int size);
+    bool loadSegment();
+    bool loadIndex(uint8_t copy, unsigned long* position); // position = sequence, read segment, read offset, write segment, write size, count
+    bool saveIndex();
+    unsigned long countAppended(); // logs appended to the segment files after the last index save
+    size_t skipLine(size_t offset); // offset of the line after the one at offset
+    const char* terminateLine(size_t offset, char* type); // log on the line at offset (0 if there is no complete line)
+
+  public:
+
+    bool debug = false;
+
+    LoggerSpool (LoggerSD* sd) : sd(sd) {}
+
+    // restore the read/write position from the card
+    bool init();
+
+    // append a log of the given type
+    // @return false if the log could not be spooled (no card)
+    bool push(char type, const char* log);
+
+    // oldest spooled log (returns 0 if the spool is empty or could not be read)
+    // @param type where to store the log type
+    const char* front(char* type);
+
+    // i-th oldest spooled log within the same spool file as front() (returns 0 if there are no more)
+    const char* peek(size_t i, char* type);
+
+    // remove the n oldest spooled logs (the ones returned by front() / peek())
+    void pop(size_t n = 1);
+
+    // status
+    bool isEmpty() const { return(count == 0); }
+    unsigned long getCount() const { return(count); }
+
+};
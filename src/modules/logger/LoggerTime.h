@@ -0,0 +1,37 @@
+#pragma once
+#include "application.h"
+
+/**** CACHED TIMESTAMPS ****/
+
+// date time format used in all logs and variables
+#define DATE_TIME_FORMAT "%Y-%m-%d %H:%M:%S %Z"
+
+// hands out the current date time, formatted at most once per second
+// (Time.format allocates a String and runs strftime on every call, logs often come in bursts within the same second)
+class LoggerTime {
+
+  private:
+
+    time_t formatted_at = 0; // second the date time buffer was formatted for
+    char date_time[25];
+
+  public:
+
+    LoggerTime () { date_time[0] = 0; }
+
+    // current date time as DATE_TIME_FORMAT (buffer is valid until the next call)
+    const char* getDateTime() {
+      time_t now = Time.now();
+      if (now != formatted_at || date_time[0] == 0) {
+        Time.format(now, DATE_TIME_FORMAT).toCharArray(date_time, sizeof(date_time));
+        formatted_at = now;
+      }
+      return(date_time);
+    }
+
+    // current date time as seconds since 1970-01-01 00:00:00 UTC (for compact logs)
+    unsigned long getEpoch() {
+      return((unsigned long) Time.now());
+    }
+
+};
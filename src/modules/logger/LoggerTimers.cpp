@@ -0,0 +1,137 @@
+#include "application.h"
+#include "LoggerTimers.h"
+
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+
+LoggerTimers::LoggerTimers() {
+  for (uint8_t level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+    for (uint8_t i = 0; i < TIMER_WHEEL_SLOTS; i++) slots[level][i] = 0;
+    occupied[level] = 0;
+  }
+}
+
+void LoggerTimers::start() {
+  if (!started) {
+    wheel_time = millis();
+    started = true;
+  }
+}
+
+/*** slot lists ***/
+
+void LoggerTimers::link(LoggerTimer* timer, LoggerTimer** list) {
+  timer->prev = 0;
+  timer->next = *list;
+  if (*list != 0) (*list)->prev = timer;
+  *list = timer;
+  timer->list = list;
+}
+
+void LoggerTimers::unlink(LoggerTimer* timer) {
+  if (timer->prev != 0) timer->prev->next = timer->next;
+  else *timer->list = timer->next;
+  if (timer->next != 0) timer->next->prev = timer->prev;
+  // slot emptied?
+  if (*timer->list == 0 && timer->list != &due) {
+    size_t i = timer->list - &slots[0][0];
+    occupied[i / TIMER_WHEEL_SLOTS] &= ~(1ULL << (i % TIMER_WHEEL_SLOTS));
+  }
+  timer->list = 0;
+  timer->next = timer->prev = 0;
+}
+
+void LoggerTimers::place(LoggerTimer* timer) {
+  // past due: current tick
+  int32_t delta = (int32_t) (timer->expires - wheel_time);
+  uint32_t at = (delta < 0) ? wheel_time : timer->expires;
+  if (delta < 0) delta = 0;
+  // coarsest level needed
+  uint8_t level = 0;
+  while (level < TIMER_WHEEL_LEVELS - 1 && (uint32_t) delta >= (1UL << (TIMER_WHEEL_BITS * (level + 1)))) level++;
+  // beyond the wheel: wait on the top level for a full turn and get placed again
+  if ((uint32_t) delta >= TIMER_WHEEL_SPAN) at = wheel_time;
+  uint8_t slot = (at >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+  link(timer, &slots[level][slot]);
+  occupied[level] |= 1ULL << slot;
+}
+
+void LoggerTimers::cascade(uint8_t level, uint8_t slot) {
+  // move the timers of a slot down to the finer levels
+  LoggerTimer* timer = slots[level][slot];
+  slots[level][slot] = 0;
+  occupied[level] &= ~(1ULL << slot);
+  while (timer != 0) {
+    LoggerTimer* next = timer->next;
+    place(timer);
+    timer = next;
+  }
+}
+
+/*** timers ***/
+
+void LoggerTimers::add(LoggerTimer* timer, uint32_t expires, uint32_t period) {
+  start();
+  if (timer->isPending()) unlink(timer);
+  else pending++;
+  timer->expires = expires;
+  timer->period = period;
+  place(timer);
+}
+
+void LoggerTimers::addIn(LoggerTimer* timer, uint32_t delay, uint32_t period) {
+  add(timer, millis() + delay, period);
+}
+
+void LoggerTimers::cancel(LoggerTimer* timer) {
+  if (timer->isPending()) {
+    unlink(timer);
+    pending--;
+  }
+}
+
+LoggerTimer* LoggerTimers::next(uint32_t now) {
+  start();
+  while (due == 0 && (int32_t) (now - wheel_time) >= 0) {
+
+    // start of a turn of level 0: bring down the timers of the next slot of level 1 (and so on)
+    uint8_t i = wheel_time & TIMER_WHEEL_MASK;
+    if (i == 0) {
+      for (uint8_t level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+        uint8_t slot = (wheel_time >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+        cascade(level, slot);
+        if (slot != 0) break;
+      }
+    }
+
+    // timers of this tick
+    if (slots[0][i] != 0) {
+      due = slots[0][i];
+      slots[0][i] = 0;
+      occupied[0] &= ~(1ULL << i);
+      for (LoggerTimer* timer = due; timer != 0; timer = timer->next) timer->list = &due;
+    }
+
+    // skip to the next occupied slot of level 0 (or the start of the next turn), at most to the tick after now
+    uint32_t skip = TIMER_WHEEL_SLOTS - i;
+    if (i < TIMER_WHEEL_MASK) {
+      uint64_t later = occupied[0] >> (i + 1);
+      if (later != 0) skip = 1 + __builtin_ctzll(later);
+    }
+    if (skip > now - wheel_time + 1) skip = now - wheel_time + 1;
+    wheel_time += skip;
+  }
+
+  // hand out the due timers one at a time
+  if (due == 0) return(0);
+  LoggerTimer* timer = due;
+  unlink(timer);
+  if (timer->period > 0) {
+    // next run on the same grid (skipping runs that were missed entirely)
+    uint32_t behind = now - timer->expires;
+    timer->expires += (behind / timer->period + 1) * timer->period;
+    place(timer);
+  } else {
+    pending--;
+  }
+  return(timer);
+}
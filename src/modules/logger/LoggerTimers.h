@@ -0,0 +1,72 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/*** timer wheel ***/
+#define TIMER_WHEEL_LEVELS  4 // levels of the wheel (each 64 times coarser than the one below)
+#define TIMER_WHEEL_BITS    6 // slots per level = 2^BITS
+#define TIMER_WHEEL_SLOTS   (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_SPAN    (1UL << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_BITS)) // ms covered by the wheel (~4.7 hours), later timers wait on the top level and are placed again
+
+// forward declaration for the timer owner
+class LoggerComponent;
+
+// timer of a component (or of the controller if component = 0), owned by whoever registers it (no heap allocation)
+struct LoggerTimer {
+  LoggerComponent* component = 0; // handleTimer() of this component is called when the timer is due
+  uint32_t expires = 0; // when the timer is due (millis())
+  uint32_t period = 0; // periodic timers: time between two runs (in ms), 0 = one-shot
+  // wheel slot (managed by LoggerTimers)
+  LoggerTimer* next = 0;
+  LoggerTimer* prev = 0;
+  LoggerTimer** list = 0; // list the timer is in, 0 = not pending
+
+  LoggerTimer() {}
+  LoggerTimer(LoggerComponent* component) : component(component) {}
+
+  bool isPending() const { return(list != 0); }
+};
+
+// Hierarchical timer wheel with ms ticks (as in classic kernel timers):
+// - level 0 has a slot for each of the next 64 ms, level 1 for each of the next 64 x 64 ms, ...
+// - a timer goes into the slot of its due time on the coarsest level needed and moves down a level whenever the wheel
+//   reaches its slot, so adding/cancelling a timer is O(1) and a pass without due timers only checks a few bitmaps
+//   no matter how many timers are pending
+class LoggerTimers {
+
+  private:
+
+    LoggerTimer* slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    uint64_t occupied[TIMER_WHEEL_LEVELS]; // non-empty slots of each level
+    LoggerTimer* due = 0; // timers due in the current tick (handed out one at a time by next())
+    uint32_t wheel_time = 0; // next tick to process (millis())
+    bool started = false; // wheel_time set (on first use)
+    size_t pending = 0;
+
+    void link(LoggerTimer* timer, LoggerTimer** list);
+    void unlink(LoggerTimer* timer);
+    void place(LoggerTimer* timer);
+    void cascade(uint8_t level, uint8_t slot);
+    void start();
+
+  public:
+
+    LoggerTimers();
+
+    // (re)schedule a timer to be due at a time (millis(), past times are due on the next pass)
+    // @param period for periodic timers: due again every period ms after that (0 = one-shot)
+    void add(LoggerTimer* timer, uint32_t expires, uint32_t period = 0);
+
+    // (re)schedule a timer to be due in delay ms
+    void addIn(LoggerTimer* timer, uint32_t delay, uint32_t period = 0);
+
+    // take a timer off the wheel (no-op if it is not pending)
+    void cancel(LoggerTimer* timer);
+
+    // next timer that is due at now (periodic timers are already rescheduled), 0 if none
+    LoggerTimer* next(uint32_t now);
+
+    // status
+    size_t getPending() const { return(pending); }
+
+};
@@ -0,0 +1,33 @@
+#include "application.h"
+#include "LoggerTrace.h"
+
+void LoggerTrace::clear() {
+  length = 0;
+  text_length = 0;
+  at = 0;
+  step = 0;
+  unknown = 0;
+  unchecked = 0;
+  failed = 0;
+  truncated = false;
+}
+
+void LoggerTrace::setStep(uint32_t at, uint8_t step) {
+  this->at = at;
+  this->step = step;
+}
+
+bool LoggerTrace::add(const char* command, size_t length, uint8_t check) {
+  if (check == TRACE_CMD_UNKNOWN) unknown++;
+  else if (check == TRACE_CMD_UNCHECKED) unchecked++;
+  if (this->length >= TRACE_MAX || text_length + length + 1 > TRACE_TEXT_MAX) {
+    truncated = true;
+    return(false);
+  }
+  entries[this->length] = {at, step, text_length, check};
+  memcpy(text + text_length, command, length);
+  text_length += length;
+  text[text_length++] = 0;
+  this->length++;
+  return(true);
+}
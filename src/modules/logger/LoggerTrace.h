@@ -0,0 +1,66 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/*** action trace ***/
+#define TRACE_MAX        128 // max commands in a trace
+#define TRACE_TEXT_MAX   2048 // max characters of all commands in a trace
+
+// check of a traced command's root
+#define TRACE_CMD_KNOWN      0 // the controller or a component handles it
+#define TRACE_CMD_UNCHECKED  1 // not routed, components without command roots might handle it (not asked in a dry run)
+#define TRACE_CMD_UNKNOWN    2 // nobody handles it
+
+// command of an action batch recorded instead of run
+struct LoggerTraceEntry {
+  uint32_t at; // seconds after the start of the run (virtual clock)
+  uint8_t step; // schedule step of the batch
+  uint16_t text; // offset of the command in the trace text
+  uint8_t check; // TRACE_CMD_KNOWN, TRACE_CMD_UNCHECKED or TRACE_CMD_UNKNOWN
+};
+
+// Dry run record: the commands of action batches with the virtual time and schedule step they would run at
+// - the controller records into a trace instead of running the commands while tracing (LoggerController::startActionTrace),
+//   so nothing is actuated, no state is saved and no data is logged
+// - entries and their text are kept in preallocated arrays (a trace that does not fit is flagged as truncated)
+class LoggerTrace {
+
+  private:
+
+    LoggerTraceEntry entries[TRACE_MAX];
+    char text[TRACE_TEXT_MAX];
+    uint8_t length = 0;
+    uint16_t text_length = 0;
+    uint32_t at = 0; // virtual time of the next entries
+    uint8_t step = 0; // schedule step of the next entries
+    uint8_t unknown = 0; // commands nobody handles
+    uint8_t unchecked = 0; // commands only components without command roots might handle
+    uint8_t failed = 0; // batches that would not run at all (e.g. too many commands)
+    bool truncated = false;
+
+  public:
+
+    LoggerTrace() {}
+
+    void clear();
+
+    // virtual time and schedule step of the commands that follow
+    void setStep(uint32_t at, uint8_t step);
+
+    // record a command (up to length characters)
+    // @return false if the trace is full
+    bool add(const char* command, size_t length, uint8_t check);
+
+    // record a batch that would not run
+    void addFailed() { failed++; }
+
+    uint8_t getLength() const { return(length); }
+    const LoggerTraceEntry* getEntry(uint8_t i) const { return(&entries[i]); }
+    const char* getCommand(uint8_t i) const { return(text + entries[i].text); }
+    uint32_t getEnd() const { return(at); } // virtual time of the last step
+    uint8_t getUnknown() const { return(unknown); }
+    uint8_t getUnchecked() const { return(unchecked); }
+    uint8_t getFailed() const { return(failed); }
+    bool isTruncated() const { return(truncated); }
+
+};
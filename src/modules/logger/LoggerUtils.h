@@ -8,6 +8,9 @@
 // NOTE: consider implementing better error catching for overlong key/value pairs
 
 // formatting patterns
+#define PATTERN_DATA_LOG_TO_JSON  "{\"id\":\"%s\",\"dt\":\"%s\",\"to\":%lu,\"d\":[%s]}" // data log with a common time offset
+#define PATTERN_DATA_LOG_JSON     "{\"id\":\"%s\",\"dt\":\"%s\",\"d\":[%s]}"
+
 #define PATTERN_IKVSUNT_JSON      "{\"i\":%d,\"k\":\"%s\",\"v\":%s,\"s\":%s,\"u\":\"%s\",\"n\":%d,\"to\":%lu}"
 #define PATTERN_IKVSUN_JSON       "{\"i\":%d,\"k\":\"%s\",\"v\":%s,\"s\":%s,\"u\":\"%s\",\"n\":%d}"
 #define PATTERN_IKVSUN_SIMPLE     "#%d %s: %s+/-%s%s (%d)"
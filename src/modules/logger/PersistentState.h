@@ -0,0 +1,297 @@
+#pragma once
+#include "application.h"
+#include <stddef.h>
+
+/**** PERSISTENT STATE ****/
+
+// EEPROM layout of a state: a ring of slots, each with a record of the state, a sequence number and a CRC-32 (of both)
+// every save goes to the next slot (spreads the wear, e.g. the scheduler saves on every schedule step) and
+// a save interrupted by a power loss leaves a slot with a bad CRC, restoring falls back on the newest good slot
+#ifndef STATE_SLOTS
+#define STATE_SLOTS 8 // slots per state
+#endif
+
+// state record: state version followed by the fields (id, size, bytes) described by a table of StateFields
+// - restoring matches fields by id, fields missing from the record keep their default (e.g. fields added since)
+// - bump the state version only when the meaning of a saved field changes, and register an upgrade from the
+//   previous version (upgrades run in sequence, e.g. 1->2->3 for a record saved with version 1)
+// - a record with version 0 is never restored (resetState() uses it to go back to the defaults on restart)
+#define STATE_RECORD_MAX 255 // max bytes of a record
+#ifndef STATE_UPGRADES_MAX
+#define STATE_UPGRADES_MAX 4 // max upgrades per state
+#endif
+
+// field of a state: id in the record (never reuse an id for a different field), offset and size in the struct
+struct StateField {
+  uint8_t id;
+  uint16_t offset;
+  uint8_t size;
+};
+#define STATE_FIELD(id, type, member) {id, (uint16_t) offsetof(type, member), (uint8_t) sizeof(type::member)}
+
+// CRC-32 (same as zlib's crc32, continue with the previous crc for more data)
+static uint32_t compute_crc32(const uint8_t* data, size_t length, uint32_t crc = 0) {
+  crc = ~crc;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (uint8_t bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+  }
+  return(~crc);
+}
+
+// record of the fields of a struct
+// @return record length, 0 if it does not fit
+static size_t write_state_record(uint8_t* record, size_t size, uint8_t version, const uint8_t* state, const StateField* fields, uint8_t n_fields) {
+  size_t length = 0;
+  if (length + 1 > size) return(0);
+  record[length++] = version;
+  for (uint8_t i = 0; i < n_fields; i++) {
+    if (length + 2 + fields[i].size > size) return(0);
+    record[length++] = fields[i].id;
+    record[length++] = fields[i].size;
+    memcpy(record + length, state + fields[i].offset, fields[i].size);
+    length += fields[i].size;
+  }
+  return(length);
+}
+
+// saved record of a state (for restoring and upgrading)
+class StateRecord {
+
+  private:
+
+    const uint8_t* record;
+    size_t length;
+
+  public:
+
+    StateRecord (const uint8_t* record, size_t length) : record(record), length(length) {}
+
+    uint8_t getVersion() const { return(length > 0 ? record[0] : 0); }
+
+    // bytes of a field
+    // @return 0 if the field is not in the record
+    const uint8_t* find(uint8_t id, uint8_t* size) const {
+      for (size_t i = 1; i + 2 <= length && i + 2 + record[i + 1] <= length; i += 2 + record[i + 1]) {
+        if (record[i] == id) {
+          *size = record[i + 1];
+          return(record + i + 2);
+        }
+      }
+      return(0);
+    }
+
+    // copy of a field (only if it has the same size)
+    bool get(uint8_t id, void* target, size_t size) const {
+      uint8_t field_size;
+      const uint8_t* field = find(id, &field_size);
+      if (field == 0 || field_size != size) return(false);
+      memcpy(target, field, size);
+      return(true);
+    }
+    template<typename V> bool get(uint8_t id, V* value) const { return(get(id, value, sizeof(V))); }
+
+};
+
+template<typename T> class PersistentState {
+
+  public:
+
+    // upgrade of a restored state from version N to N+1 (the state already has all fields the record has in common with it)
+    typedef void (*Upgrade)(T* state, const StateRecord& saved);
+
+  private:
+
+    T* state; // the live state
+    const StateField* fields;
+    const uint8_t n_fields;
+    const uint8_t capacity; // bytes reserved for the record in each slot
+    const uint8_t slots;
+    uint8_t slot = 0; // slot of the newest save
+    uint32_t sequence = 0; // sequence number of the newest save (0 = nothing saved yet)
+    uint32_t saved_crc = 0; // CRC of the record in the newest save
+    bool scanned = false; // whether the slots were scanned for the newest save
+
+    // upgrades
+    uint8_t upgrade_versions[STATE_UPGRADES_MAX];
+    Upgrade upgrades[STATE_UPGRADES_MAX];
+    uint8_t n_upgrades = 0;
+
+    // layout before the state slots (raw struct), to import states saved by older firmware
+    uint8_t legacy_version = 0;
+    const StateField* legacy_fields = 0;
+    uint8_t n_legacy_fields = 0;
+    size_t legacy_size = 0;
+    size_t legacy_version_offset = 0;
+
+    // slot = record length + record + sequence + crc
+    size_t getSlotSize() const { return(1 + capacity + 2 * sizeof(uint32_t)); }
+
+    // record and sequence of a slot
+    // @return whether the slot's CRC is good
+    bool readSlot(size_t start, uint8_t i, uint8_t* record, size_t* length, uint32_t* target_sequence) {
+      size_t address = start + i * getSlotSize();
+      uint8_t record_length = EEPROM.read(address);
+      if (record_length == 0 || record_length > capacity) return(false);
+      for (uint8_t j = 0; j < record_length; j++) record[j] = EEPROM.read(address + 1 + j);
+      uint32_t crc;
+      EEPROM.get(address + 1 + capacity, *target_sequence);
+      EEPROM.get(address + 1 + capacity + sizeof(uint32_t), crc);
+      uint32_t record_crc = compute_crc32(&record_length, 1);
+      record_crc = compute_crc32(record, record_length, record_crc);
+      *length = record_length;
+      return(crc == compute_crc32((const uint8_t*) target_sequence, sizeof(uint32_t), record_crc));
+    }
+
+    // newest record with a good CRC
+    // @return false if there is none (nothing saved yet or damaged)
+    bool load(size_t start, uint8_t* record, size_t* length) {
+      bool found = false;
+      uint8_t candidate[STATE_RECORD_MAX];
+      size_t candidate_length;
+      uint32_t candidate_sequence;
+      for (uint8_t i = 0; i < slots; i++) {
+        if (readSlot(start, i, candidate, &candidate_length, &candidate_sequence) && (!found || candidate_sequence > sequence)) {
+          memcpy(record, candidate, candidate_length);
+          *length = candidate_length;
+          sequence = candidate_sequence;
+          slot = i;
+          found = true;
+        }
+      }
+      if (found) saved_crc = compute_crc32(record, *length);
+      else sequence = 0;
+      scanned = true;
+      return(found);
+    }
+
+    // record of a state saved in the layout before the state slots
+    // @return record length, 0 if there is no such state
+    size_t importLegacy(const uint8_t* legacy, uint8_t* record) {
+      if (legacy == 0 || legacy_size == 0 || legacy[legacy_version_offset] != legacy_version) return(0);
+      return(write_state_record(record, STATE_RECORD_MAX, legacy_version, legacy, legacy_fields, n_legacy_fields));
+    }
+
+    // fields of a saved record (plus upgrades) into the target
+    bool migrate(const StateRecord& saved, T* target) {
+      uint8_t version = saved.getVersion();
+      if (version == 0 || version > target->version) {
+        Serial.printf("INFO: could not restore state from memory (found state version %d instead of %d), sticking with initial default\n", version, target->version);
+        return(false);
+      }
+      for (uint8_t i = 0; i < n_fields; i++) {
+        saved.get(fields[i].id, (uint8_t*) target + fields[i].offset, fields[i].size);
+      }
+      for (uint8_t v = version; v < target->version; v++) {
+        for (uint8_t i = 0; i < n_upgrades; i++) {
+          if (upgrade_versions[i] == v) upgrades[i](target, saved);
+        }
+      }
+      return(true);
+    }
+
+  public:
+
+    template<size_t N> PersistentState (T* state, const StateField (&fields)[N], uint8_t capacity, uint8_t slots = STATE_SLOTS) :
+      state(state), fields(fields), n_fields(N), capacity(capacity), slots(slots > 0 ? slots : 1) {}
+
+    // register the upgrade from version to version + 1
+    void addUpgrade(uint8_t version, Upgrade upgrade) {
+      if (n_upgrades >= STATE_UPGRADES_MAX) {
+        Serial.printf("ERROR: too many state upgrades, cannot add upgrade from version %d\n", version);
+        return;
+      }
+      upgrade_versions[n_upgrades] = version;
+      upgrades[n_upgrades] = upgrade;
+      n_upgrades++;
+    }
+
+    // describe the layout before the state slots: the raw struct L (with the fields at their offsets in L)
+    template<typename L, size_t N> void setLegacyLayout(uint8_t version, const StateField (&fields)[N]) {
+      legacy_version = version;
+      legacy_fields = fields;
+      n_legacy_fields = N;
+      legacy_size = sizeof(L);
+      legacy_version_offset = offsetof(L, version);
+    }
+
+    // EEPROM bytes taken by all slots
+    size_t getSize() const { return(slots * getSlotSize()); }
+
+    // EEPROM bytes the state took in the layout before the state slots
+    size_t getLegacySize() const { return(legacy_size); }
+
+    // whether there is a good save (e.g. to find out if the EEPROM still has the layout before the state slots)
+    bool hasSave(size_t start) {
+      uint8_t record[STATE_RECORD_MAX];
+      size_t length;
+      return(load(start, record, &length));
+    }
+
+    // restore the live state from the newest save or else from the state in the layout before the state slots (if given)
+    // saves that need an upgrade and imported states are saved again right away (in the current version)
+    bool restore(size_t start, const uint8_t* legacy = 0) {
+      uint8_t record[STATE_RECORD_MAX];
+      size_t length;
+      bool imported = false;
+      if (!load(start, record, &length)) {
+        length = importLegacy(legacy, record);
+        if (length == 0) {
+          Serial.println("INFO: could not restore state from memory (nothing saved), sticking with initial default");
+          return(false);
+        }
+        imported = true;
+      }
+      StateRecord saved(record, length);
+      T restored = *state; // defaults for the fields that are not in the record
+      if (!migrate(saved, &restored)) return(false);
+      memcpy((void*) state, (const void*) &restored, sizeof(T));
+      if (imported) {
+        Serial.printf("INFO: successfully imported state from memory (state version %d, from the layout before the state slots with version %d)\n", state->version, saved.getVersion());
+        save(start);
+      } else if (saved.getVersion() != state->version) {
+        Serial.printf("INFO: successfully restored state from memory (state version %d, upgraded from version %d)\n", state->version, saved.getVersion());
+        save(start);
+      } else {
+        Serial.printf("INFO: successfully restored state from memory (state version %d, save #%lu)\n", state->version, (unsigned long) sequence);
+      }
+      return(true);
+    }
+
+    // save the live state into the next slot (only if it changed since the last save)
+    // @return whether anything was written
+    bool save(size_t start) {
+      if (!scanned) {
+        // continue after the newest save (e.g. when saving defaults without restoring first)
+        hasSave(start);
+      }
+      uint8_t record[STATE_RECORD_MAX];
+      size_t length = write_state_record(record, capacity, state->version, (const uint8_t*) state, fields, n_fields);
+      if (length == 0) {
+        Serial.printf("ERROR: state record does not fit into the %d bytes reserved for it, cannot save state\n", capacity);
+        return(false);
+      }
+      uint32_t record_crc = compute_crc32(record, length);
+      if (sequence > 0 && record_crc == saved_crc) return(false);
+      // record first, sequence and crc last: an interrupted save never has a good CRC
+      uint8_t next = (sequence > 0) ? (slot + 1) % slots : 0;
+      uint32_t next_sequence = sequence + 1;
+      uint8_t record_length = length;
+      uint32_t crc = compute_crc32(&record_length, 1);
+      crc = compute_crc32(record, length, crc);
+      crc = compute_crc32((const uint8_t*) &next_sequence, sizeof(uint32_t), crc);
+      size_t address = start + next * getSlotSize();
+      EEPROM.write(address, record_length);
+      for (size_t i = 0; i < length; i++) EEPROM.write(address + 1 + i, record[i]);
+      EEPROM.put(address + 1 + capacity, next_sequence);
+      EEPROM.put(address + 1 + capacity + sizeof(uint32_t), crc);
+      slot = next;
+      sequence = next_sequence;
+      saved_crc = record_crc;
+      return(true);
+    }
+
+    // sequence number of the newest save
+    uint32_t getSequence() const { return(sequence); }
+
+};
@@ -28,34 +28,43 @@ void RelayLoggerComponent::completeStartup() {
         Serial.printf("INFO: logged '%s' value at startup: off (%.1f)\n", id, data[0].getValue());
 }
 
+/*** loop ***/
+
+bool RelayLoggerComponent::isPolled() {
+    // only changes on commands
+    return(false);
+}
+
 /*** state management ***/
     
 size_t RelayLoggerComponent::getStateSize() { 
-    return(sizeof(*state));
+    return(persistent_state.getSize());
+}
+
+size_t RelayLoggerComponent::getLegacyStateSize() { 
+    return(persistent_state.getLegacySize());
 }
 
 void RelayLoggerComponent::saveState(bool always) { 
+    state_changed = true; // state variable & display info out of date
     if (ctrl->state->save_state || always) {
-        EEPROM.put(eeprom_start, *state);
-        if (ctrl->debug_state) {
-            Serial.printf("DEBUG: component '%s' state saved in memory (if any updates were necessary)\n", id);
-        }
+        // in an action batch: saved once at its end
+        if (!ctrl->deferStateSave(this)) commitState();
     } else {
         Serial.printlnf("DEBUG: component '%s' state NOT saved because state saving is off", id);
     }
 } 
 
-bool RelayLoggerComponent::restoreState() {
-    RelayState *saved_state = new RelayState();
-    EEPROM.get(eeprom_start, *saved_state);
-    bool recoverable = saved_state->version == state->version;
-    if(recoverable) {
-        EEPROM.get(eeprom_start, *state);
-        Serial.printf("INFO: successfully restored component state from memory (state version %d)\n", state->version);
-    } else {
-        Serial.printf("INFO: could not restore state from memory (found state version %d instead of %d), sticking with initial default\n", saved_state->version, state->version);
-        saveState(true);
+void RelayLoggerComponent::commitState() { 
+    persistent_state.save(eeprom_start);
+    if (ctrl->debug_state) {
+        Serial.printf("DEBUG: component '%s' state saved in memory (if any updates were necessary)\n", id);
     }
+} 
+
+bool RelayLoggerComponent::restoreState() {
+    bool recoverable = persistent_state.restore(eeprom_start, getLegacyState());
+    if (!recoverable) saveState(true);
     return(recoverable);
 }
 
@@ -66,6 +75,10 @@ void RelayLoggerComponent::resetState() {
 
 /*** command parsing ***/
 
+void RelayLoggerComponent::registerCommands() {
+  ctrl->registerCommand(cmd, this);
+}
+
 bool RelayLoggerComponent::parseCommand(LoggerCommand *command) {
   if (parseRelay(command)) {
     // check for relay on/off command
@@ -19,6 +19,12 @@ struct RelayState {
 
 };
 
+// EEPROM record of the state (ids of the fields and bytes reserved in each slot, with room for new fields)
+#define RELAY_STATE_RECORD 8
+static const StateField relay_state_fields[] = {
+  STATE_FIELD(1, RelayState, on)
+};
+
 /*** state variable formatting ***/
 static void getRelayStateText(char* variable, bool on, char* target, int size, char* pattern, bool include_key = true) {
     getStateBooleanText(variable, on, CMD_RELAY_ON, CMD_RELAY_OFF, target, size, pattern, include_key);
@@ -46,24 +52,34 @@ class RelayLoggerComponent : public ControllerLoggerComponent {
 
     // state
     RelayState* state;
+    PersistentState<RelayState> persistent_state; // EEPROM slots of the state
 
     /*** constructors ***/
     // derived from controllerlogger component which has NO global time offsets and manages own data clearing by default --> keep defaults
     RelayLoggerComponent (const char *id, LoggerController *ctrl, bool on, pin_t pin, int type) : 
-      ControllerLoggerComponent(id, ctrl), state(new RelayState(on)), relay_pin(pin), relay_type(type) { cmd = strdup(id); }
+      ControllerLoggerComponent(id, ctrl), relay_type(type), relay_pin(pin), state(new RelayState(on)), persistent_state(state, relay_state_fields, RELAY_STATE_RECORD) {
+        cmd = strdup(id);
+        persistent_state.setLegacyLayout<RelayState>(1, relay_state_fields); // raw struct before the state slots
+      }
 
     /*** setup ***/
     uint8_t setupDataVector(uint8_t start_idx);
     virtual void init();
     virtual void completeStartup();
 
+    /*** loop ***/
+    virtual bool isPolled();
+
     /*** state management ***/
     virtual size_t getStateSize();
+    virtual size_t getLegacyStateSize();
     virtual void saveState(bool always = false);
+    virtual void commitState();
     virtual bool restoreState();
     virtual void resetState();
 
     /*** command parsing ***/
+    void registerCommands();
     bool parseCommand(LoggerCommand *command);
     bool parseRelay(LoggerCommand *command);
     
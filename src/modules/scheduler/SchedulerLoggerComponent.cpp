@@ -1,5 +1,6 @@
 #include "application.h"
 #include "SchedulerLoggerComponent.h"
+#include "LoggerBuffer.h"
 
 /*** setup ***/
 
@@ -13,13 +14,35 @@ uint8_t SchedulerLoggerComponent::setupDataVector(uint8_t start_idx) {
 
 void SchedulerLoggerComponent::init() {
     ControllerLoggerComponent::init();
+    // schedule loaded at runtime before the restart
+    if (state->schedule == SCHEDULE_FILE) {
+        char file_name[13];
+        getScheduleFileName(file_name, sizeof(file_name));
+        if (loadScheduleFile(file_name)) {
+            applySchedule(tables[next_table].getEvents(), tables[next_table].getLength(), false);
+        } else {
+            Serial.printlnf("ERROR: could not restore schedule '%s' from %s, using the compiled schedule", id, file_name);
+            if (state->status == SCHEDULE_RUNNING) {
+                Serial.printlnf("WARNING: schedule '%s' run stopped (events of the compiled schedule differ)", id);
+                state->status = SCHEDULE_UNSCHEDULED;
+            }
+            applySchedule(compiled_schedule, compiled_length);
+        }
+    }
+    if (state->status == SCHEDULE_RUNNING && state->saved_step >= schedule_length) {
+        Serial.printlnf("WARNING: schedule '%s' saved step #%d is beyond its %d events, run marked complete", id, state->saved_step + 1, schedule_length);
+        state->status = SCHEDULE_COMPLETE;
+        saveState(true);
+    }
     // set starting value from state
     data[0].setNewestValue(state->status == SCHEDULE_RUNNING ? 1.0 : 0.0);
     if (state->status == SCHEDULE_RUNNING) {
         // resume schedule execution where left off
         schedule_i = state->saved_step;
-        schedule_last = state->saved_time;
         schedule_wait = schedule[schedule_i].wait;
+        schedule_origin = state->saved_time;
+        schedule_deadline = schedule_wait * 1000UL;
+        schedule_anchored = false; // once the time is valid
     }
 
 }
@@ -37,22 +60,46 @@ void SchedulerLoggerComponent::completeStartup() {
     } else {
         Serial.printf("INFO: logged %s value at startup: unscheduled (%.1f)\n", id, data[0].getValue());
     }
+    catchUpSchedule();
+    armSchedule();
 }
 
 
 /*** loop ***/
-void SchedulerLoggerComponent::update() {
-    ControllerLoggerComponent::update();
+bool SchedulerLoggerComponent::isPolled() {
+    // runs on its timer
+    return(false);
+}
+
+void SchedulerLoggerComponent::handleTimer(LoggerTimer* timer) {
     // only have time available for sure after startup is complete
     if (ctrl->isStartupComplete()) {
         // continue to run schedule if we're running or testing
         if (state->status == SCHEDULE_RUNNING || testing) runSchedule();
         if (checkSchedule() || start_testing) startSchedule();
+        armSchedule();
+    }
+}
+
+void SchedulerLoggerComponent::armSchedule() {
+    // timer for the next event or the start (armed once startup is complete)
+    if (!ctrl->isStartupComplete()) return;
+    if (start_testing) {
+        ctrl->timers.add(&schedule_timer, millis());
+    } else if (state->status == SCHEDULE_RUNNING || testing) {
+        if (!schedule_anchored) anchorSchedule();
+        ctrl->timers.add(&schedule_timer, schedule_origin_ms + schedule_deadline);
+    } else if (state->status == SCHEDULE_WAITING) {
+        double wait = difftime(state->tstart, Time.now());
+        uint32_t delay = (wait <= 1) ? SCHEDULE_START_POLL : (wait - 1) * 1000;
+        ctrl->timers.addIn(&schedule_timer, (delay < SCHEDULE_START_CHECK) ? delay : SCHEDULE_START_CHECK);
+    } else {
+        ctrl->timers.cancel(&schedule_timer);
     }
 }
 
 bool SchedulerLoggerComponent::checkSchedule() {
-    if (state->status == SCHEDULE_WAITING && difftime(Time.now(), state->tstart) > 0) {
+    if (state->status == SCHEDULE_WAITING && difftime(Time.now(), state->tstart) >= 0) {
         // tstart is set and has been exceeded (yet schedule is not running yet)
         return(true);
     }
@@ -71,21 +118,25 @@ void SchedulerLoggerComponent::startSchedule() {
     (testing) ?
         Serial.printf("INFO: testing schedule '%s' started at ", id) :
         Serial.printf("INFO: schedule '%s' started at ", id);
-    Serial.print(Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z"));
+    Serial.print(ctrl->timestamp.getDateTime());
     (testing && testing_waits > 0) ?
-        Serial.printlnf(" with %d second test wait times for each event", testing_waits/1000) :
+        Serial.printlnf(" with %d second test wait times for each event", testing_waits) :
         Serial.println();
 
-    // start values
+    // start values (deadlines from tstart unless testing or catching up on a start missed while the power was out)
     schedule_i = 0;
-    schedule_last = Time.now();
     schedule_wait = (testing && testing_waits > 0) ? testing_waits : schedule[schedule_i].wait;
+    bool caught_up = difftime(Time.now(), state->tstart) > SCHEDULE_MISSED_AFTER;
+    schedule_origin = (testing || caught_up) ? Time.now() : state->tstart;
+    schedule_deadline = schedule_wait * 1000UL;
+    anchorSchedule();
+    for (uint8_t i = 0; i < schedule_length; i++) schedule_late[i] = SCHEDULE_LATE_UNKNOWN;
 
     // save state if not testing
     if (!testing) {
         state->status = SCHEDULE_RUNNING;
         state->saved_step = schedule_i;
-        state->saved_time = schedule_last;
+        state->saved_time = schedule_origin;
         saveState();
     }
 
@@ -93,33 +144,67 @@ void SchedulerLoggerComponent::startSchedule() {
     logStepData(1.0, 0.1);
 }
 
+void SchedulerLoggerComponent::anchorSchedule() {
+    // resumed after the next event was due (e.g. power was out): the overdue event runs right away and the waits of
+    // the following events count from now (instead of running all events that were due at once)
+    if (!testing && difftime(Time.now(), schedule_origin) > schedule_wait) {
+        Serial.printlnf("INFO: schedule '%s' resumed %.0f seconds after event #%d/%d was due, running it now", 
+            id, difftime(Time.now(), schedule_origin) - schedule_wait, schedule_i + 1, schedule_length);
+        schedule_origin = Time.now() - schedule_wait;
+    }
+    // millis() at the origin (the origin is at most a second into the past at start)
+    schedule_origin_ms = millis() - (unsigned long) (difftime(Time.now(), schedule_origin) * 1000);
+    schedule_anchored = true;
+}
+
 void SchedulerLoggerComponent::runSchedule() {
-    if ( round(difftime(Time.now(), schedule_last)) > schedule_wait) {
+    if (!schedule_anchored) anchorSchedule();
+    unsigned long elapsed = millis() - schedule_origin_ms;
+    if (elapsed >= schedule_deadline) {
+        schedule_late[schedule_i] = elapsed - schedule_deadline;
         // info
         (testing) ? Serial.print("INFO: testing schedule") : Serial.print("DEBUG: schedule");
         Serial.printf(" '%s' event #%d/%d: %s (%s) at ", id, schedule_i + 1, schedule_length, schedule[schedule_i].label, schedule[schedule_i].description);
-        Serial.print(Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z"));
-        Serial.printlnf(" after a %.0f min %.0f second wait.", floor(schedule_wait/60.), fmod(schedule_wait, 60.));
+        Serial.print(ctrl->timestamp.getDateTime());
+        Serial.printlnf(" after a %.0f min %.0f second wait (%lu ms late).", floor(schedule_wait/60.), fmod(schedule_wait, 60.), schedule_late[schedule_i]);
         // run event
         runEvent(schedule[schedule_i].event);
         schedule_i++;
-        schedule_last = Time.now();
         if (schedule_i >= schedule_length) {
             finishSchedule();
         } else {
+            // next deadline from this event's deadline (not from when it ran): the origin moves to it, so the ms
+            // timing only ever spans one wait (a whole schedule can be longer than the 49.7 days of millis())
+            schedule_origin += schedule_deadline / 1000;
+            schedule_origin_ms += schedule_deadline;
             schedule_wait = (testing && testing_waits > 0) ? testing_waits : schedule[schedule_i].wait;
             // save state if not testing
             if (!testing) {
                 state->saved_step = schedule_i;
-                state->saved_time = schedule_last;
+                state->saved_time = schedule_origin;
                 saveState();
             }
+            schedule_deadline = schedule_wait * 1000UL;
         }
+        ctrl->updateDebugVariable();
     }
 }
 
 void SchedulerLoggerComponent::runEvent(uint8_t event) {
-    // overload in derived classes
+    // all actions of the event as one batch (one state save per component and one data log)
+    const SchedulerAction* action = getAction(event);
+    if (action != 0) {
+        char label[30];
+        snprintf(label, sizeof(label), "%s event %d", id, event);
+        ctrl->runActions(label, action->commands);
+    }
+}
+
+const SchedulerAction* SchedulerLoggerComponent::getAction(uint8_t event) {
+    for (uint8_t i = 0; i < actions_length; i++) {
+        if (actions[i].event == event) return(&actions[i]);
+    }
+    return(0);
 }
 
 void SchedulerLoggerComponent::getSchedulerStatus(char* target, int size) {
@@ -128,7 +213,9 @@ void SchedulerLoggerComponent::getSchedulerStatus(char* target, int size) {
         if (!ctrl->isStartupComplete()) {
             snprintf(target, size, "%s: starting up...", id); 
         } else {
-            diff = schedule_wait - round(difftime(Time.now(), schedule_last));
+            diff = (schedule_anchored) ?
+                ceil(((long) schedule_deadline - (long) (millis() - schedule_origin_ms)) / 1000.) :
+                round(difftime(schedule_origin + schedule_deadline / 1000, Time.now()));
             (diff > 60) ?
                 snprintf(target, size, "%s: %s in %.0fm%.0fs", id, schedule[schedule_i].label, floor(diff/60.), fmod(diff, 60.)) :
                 snprintf(target, size, "%s: %s in %ds", id, schedule[schedule_i].label, diff);
@@ -148,11 +235,18 @@ void SchedulerLoggerComponent::finishSchedule() {
     (testing) ?
         Serial.printf("INFO: testing schedule '%s' finished at ", id) :
         Serial.printf("INFO: schedule '%s' finished at ", id);
-    Serial.println(Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z"));
+    Serial.println(ctrl->timestamp.getDateTime());
 
-    // save state if not testing
+    // save state if not testing (recurring schedules wait for their next start)
     if (!testing) {
-        state->status = SCHEDULE_COMPLETE;
+        time_t next = getNextStart(Time.now());
+        state->status = (next > 0) ? SCHEDULE_WAITING : SCHEDULE_COMPLETE;
+        if (next > 0) {
+            state->tstart = next;
+            state->saved_step = 0;
+            Serial.printf("INFO: schedule '%s' starts again at ", id);
+            Serial.println(Time.format(state->tstart, "%Y-%m-%d %H:%M (UTC)"));
+        }
         state->saved_time = Time.now();
         saveState();
     }
@@ -160,36 +254,57 @@ void SchedulerLoggerComponent::finishSchedule() {
 
     // log step change
     logStepData(0.0, 0.1);
+
+    applyPendingSchedule();
+}
+
+void SchedulerLoggerComponent::catchUpSchedule() {
+    // recurring schedule whose start passed while the power was out: run it now or skip to the next start
+    if (state->status != SCHEDULE_WAITING || !isRecurring() || difftime(Time.now(), state->tstart) <= SCHEDULE_MISSED_AFTER) return;
+    if (state->recurrence.repeat & SCHEDULE_CATCH_UP) {
+        Serial.printf("INFO: schedule '%s' missed its start at ", id);
+        Serial.print(Time.format(state->tstart, "%Y-%m-%d %H:%M (UTC)"));
+        Serial.println(", catching up now");
+    } else {
+        Serial.printf("INFO: schedule '%s' missed its start at ", id);
+        Serial.print(Time.format(state->tstart, "%Y-%m-%d %H:%M (UTC)"));
+        state->tstart = getNextStart(Time.now());
+        Serial.print(", skipped to ");
+        Serial.println(Time.format(state->tstart, "%Y-%m-%d %H:%M (UTC)"));
+        saveState(true);
+    }
 }
 
 /*** state management ***/
     
 size_t SchedulerLoggerComponent::getStateSize() { 
-    return(sizeof(*state));
+    return(persistent_state.getSize());
+}
+
+size_t SchedulerLoggerComponent::getLegacyStateSize() { 
+    return(persistent_state.getLegacySize());
 }
 
 void SchedulerLoggerComponent::saveState(bool always) { 
+    state_changed = true; // state variable & display info out of date
     if (ctrl->state->save_state || always) {
-        EEPROM.put(eeprom_start, *state);
-        if (ctrl->debug_state) {
-            Serial.printf("DEBUG: component '%s' state saved in memory (if any updates were necessary)\n", id);
-        }
+        // in an action batch: saved once at its end
+        if (!ctrl->deferStateSave(this)) commitState();
     } else {
         Serial.printlnf("DEBUG: component '%s' state NOT saved because state saving is off", id);
     }
 } 
 
-bool SchedulerLoggerComponent::restoreState() {
-    SchedulerState *saved_state = new SchedulerState();
-    EEPROM.get(eeprom_start, *saved_state);
-    bool recoverable = saved_state->version == state->version;
-    if(recoverable) {
-        EEPROM.get(eeprom_start, *state);
-        Serial.printf("INFO: successfully restored component state from memory (state version %d)\n", state->version);
-    } else {
-        Serial.printf("INFO: could not restore state from memory (found state version %d instead of %d), sticking with initial default\n", saved_state->version, state->version);
-        saveState(true);
+void SchedulerLoggerComponent::commitState() { 
+    persistent_state.save(eeprom_start);
+    if (ctrl->debug_state) {
+        Serial.printf("DEBUG: component '%s' state saved in memory (if any updates were necessary)\n", id);
     }
+} 
+
+bool SchedulerLoggerComponent::restoreState() {
+    bool recoverable = persistent_state.restore(eeprom_start, getLegacyState());
+    if (!recoverable) saveState(true);
     return(recoverable);
 }
 
@@ -200,6 +315,10 @@ void SchedulerLoggerComponent::resetState() {
 
 /*** command parsing ***/
 
+void SchedulerLoggerComponent::registerCommands() {
+  ctrl->registerCommand(cmd, this);
+}
+
 bool SchedulerLoggerComponent::parseCommand(LoggerCommand *command) {
   if (parseSchedule(command)) {
     // check for scheduling command
@@ -221,23 +340,104 @@ bool SchedulerLoggerComponent::parseSchedule(LoggerCommand *command) {
             timeobj.tm_hour = 0;
             timeobj.tm_min = 0;
             timeobj.tm_sec = 0;
+            timeobj.tm_isdst = 0; // otherwise uninitialized (mktime would shift by an hour at random)
 
             // parse with pattern
             if (debug_component) Serial.printlnf("DEBUG: parsing scheduler %s set schedule command with value '%s' and pattern %s", id, command->units, pattern);
             if (strptime(command->units, pattern, &timeobj)) {
                 command->success(changeSchedule(timeobj));
+                armSchedule();
                 getSchedulerStateTimeStart(cmd, state->tstart, command->data, sizeof(command->data));
             } else {
                 command->errorValue();
             }
         } else if (command->parseValue(CMD_SCHEDULER_RESET)) {
             command->success(resetSchedule());
+            armSchedule();
             getStateStringText(cmd, CMD_SCHEDULER_RESET, command->data, sizeof(command->data), PATTERN_KV_JSON_QUOTED);
         } else if (command->parseValue(CMD_SCHEDULER_TEST)) {
             command->extractUnits();
             int waits = atoi(command->units); // in seconds
             command->success(testSchedule(waits));
+            armSchedule();
             getStateStringText(cmd, CMD_SCHEDULER_TEST, command->data, sizeof(command->data), PATTERN_KV_JSON_QUOTED);
+        } else if (command->parseValue(CMD_SCHEDULER_ADD)) {
+            // event line (the rest of the command)
+            command->assignNotes();
+            if (switch_pending) {
+                command->error(CMD_RET_ERR_SCHEDULE_PENDING, CMD_RET_ERR_SCHEDULE_PENDING_TEXT);
+            } else if (addScheduleEvent(command->notes)) {
+                command->success(true);
+            } else {
+                command->error(CMD_RET_ERR_SCHEDULE_INVALID, CMD_RET_ERR_SCHEDULE_INVALID_TEXT);
+            }
+            char events[4];
+            snprintf(events, sizeof(events), "%d", (tables != 0) ? tables[next_table].getLength() : 0);
+            getStateStringText(cmd, events, command->data, sizeof(command->data), PATTERN_KV_JSON);
+        } else if (command->parseValue(CMD_SCHEDULER_USE) || command->parseValue(CMD_SCHEDULER_LOAD)) {
+            // new schedule (uploaded or from a file)
+            bool load = command->parseValue(CMD_SCHEDULER_LOAD);
+            char file_name[20];
+            if (load) {
+                command->extractUnits();
+                if (command->units[0] != 0) strcpy(file_name, command->units);
+                else getScheduleFileName(file_name, sizeof(file_name));
+            }
+            if (switch_pending) {
+                command->error(CMD_RET_ERR_SCHEDULE_PENDING, CMD_RET_ERR_SCHEDULE_PENDING_TEXT);
+            } else if (load && (!ctrl->isSdEnabled() || !ctrl->sd->available())) {
+                command->error(CMD_RET_ERR_SD_UNAVAILABLE, CMD_RET_ERR_SD_UNAVAILABLE_TEXT);
+            } else if ((load && !loadScheduleFile(file_name)) || tables == 0 || tables[next_table].getLength() == 0) {
+                command->error(CMD_RET_ERR_SCHEDULE_INVALID, CMD_RET_ERR_SCHEDULE_INVALID_TEXT);
+            } else if (!useNextSchedule()) {
+                // schedule file could not be written (the card is then flagged unavailable)
+                command->error(CMD_RET_ERR_SD_UNAVAILABLE, CMD_RET_ERR_SD_UNAVAILABLE_TEXT);
+            } else {
+                command->success(true);
+            }
+            char events[4];
+            snprintf(events, sizeof(events), "%d", switch_pending ? pending_length : schedule_length);
+            getStateStringText(cmd, events, command->data, sizeof(command->data), PATTERN_KV_JSON);
+        } else if (command->parseValue(CMD_SCHEDULER_DEFAULT)) {
+            command->success(useCompiledSchedule());
+            getStateStringText(cmd, CMD_SCHEDULER_DEFAULT, command->data, sizeof(command->data), PATTERN_KV_JSON_QUOTED);
+        } else if (command->parseValue(CMD_SCHEDULER_DRY_RUN)) {
+            // schedule in use or the next one
+            command->extractUnits();
+            bool next = command->parseUnits(CMD_SCHEDULER_DRY_RUN_NEXT);
+            const SchedulerEvent* events = (next && tables != 0) ? tables[next_table].getEvents() : schedule;
+            uint8_t length = next ? ((tables != 0) ? tables[next_table].getLength() : 0) : schedule_length;
+            // the controller's trace is shared by all schedulers (only reported if this dry run filled it)
+            const LoggerTrace* trace = 0;
+            if (actions == 0) {
+                command->error(CMD_RET_ERR_SCHEDULE_NO_ACTIONS, CMD_RET_ERR_SCHEDULE_NO_ACTIONS_TEXT);
+            } else if ((!next && command->units[0] != 0) || length == 0) {
+                // unknown option or no next schedule
+                command->error(CMD_RET_ERR_SCHEDULE_INVALID, CMD_RET_ERR_SCHEDULE_INVALID_TEXT);
+            } else {
+                bool valid = dryRunSchedule(events, length);
+                trace = ctrl->getActionTrace();
+                // actions that would not run
+                if (valid) command->success(true);
+                else command->error(CMD_RET_ERR_SCHEDULE_INVALID, CMD_RET_ERR_SCHEDULE_INVALID_TEXT);
+            }
+            // result (at most "255 cmds 999:59:59", longer dry runs show 999 h) and key share the data with the pattern (without its two %s and terminator)
+            char result[19];
+            unsigned long end = (trace != 0) ? trace->getEnd() : 0;
+            snprintf(result, sizeof(result), "%d cmds %lu:%02lu:%02lu", (trace != 0) ? trace->getLength() : 0, min(end / 3600, 999UL), (end / 60) % 60, end % 60);
+            char var_cmd[sizeof(command->data) - (sizeof(PATTERN_KV_JSON_QUOTED) - 5) - (sizeof(result) - 1)];
+            snprintf(var_cmd, sizeof(var_cmd), "%s-%s", cmd, CMD_SCHEDULER_DRY_RUN);
+            getStateStringText(var_cmd, result, command->data, sizeof(command->data), PATTERN_KV_JSON_QUOTED);
+        } else if (command->parseValue(CMD_SCHEDULER_REPEAT)) {
+            SchedulerRecurrence recurrence = state->recurrence;
+            if (parseRecurrence(command, &recurrence)) {
+                command->success(changeRecurrence(recurrence));
+                armSchedule();
+                // next start
+                getSchedulerStateTimeStart(cmd, state->tstart, command->data, sizeof(command->data));
+            } else {
+                command->errorValue();
+            }
         } else {
             command->errorValue(); // invalid value
         }
@@ -274,7 +474,9 @@ bool SchedulerLoggerComponent::resetSchedule() {
     state->tstart = 0;
     state->saved_step = 0;
     state->saved_time = 0;
+    state->recurrence = SchedulerRecurrence(); // stops repeating
     saveState(true);
+    applyPendingSchedule();
     return(true);
 }
 
@@ -285,6 +487,289 @@ bool SchedulerLoggerComponent::testSchedule(unsigned int waits) {
     return(true);
 }
 
+/*** dry run ***/
+
+bool SchedulerLoggerComponent::dryRunSchedule(const SchedulerEvent* events, uint8_t length) {
+    // without an action table the events are run in code (would actuate)
+    if (actions == 0) {
+        Serial.printlnf("WARNING: schedule '%s' has no action table, cannot dry run its events", id);
+        return(false);
+    }
+    // all events at their deadlines on the virtual clock (the controller records the actions instead of running them)
+    LoggerTrace* trace = ctrl->startActionTrace();
+    uint32_t at = 0;
+    for (uint8_t i = 0; i < length; i++) {
+        at += events[i].wait;
+        trace->setStep(at, i);
+        runEvent(events[i].event);
+    }
+    ctrl->stopActionTrace();
+    printTrace(trace, events);
+    return(trace->getUnknown() == 0 && trace->getFailed() == 0 && !trace->isTruncated());
+}
+
+void SchedulerLoggerComponent::printTrace(const LoggerTrace* trace, const SchedulerEvent* events) {
+    for (uint8_t i = 0; i < trace->getLength(); i++) {
+        const LoggerTraceEntry* entry = trace->getEntry(i);
+        Serial.printlnf("TRACE: %s +%lu:%02lu:%02lu #%d %s: %s%s", id, entry->at / 3600, (entry->at / 60) % 60, entry->at % 60,
+            entry->step + 1, events[entry->step].label, trace->getCommand(i),
+            (entry->check == TRACE_CMD_UNKNOWN) ? " (UNKNOWN COMMAND)" : (entry->check == TRACE_CMD_UNCHECKED) ? " (UNCHECKED)" : "");
+    }
+    uint32_t end = trace->getEnd();
+    Serial.printlnf("INFO: dry run of schedule '%s': %d commands over %lu:%02lu:%02lu, %d unknown, %d unchecked, %d batches too long%s", id,
+        trace->getLength(), end / 3600, (end / 60) % 60, end % 60, trace->getUnknown(), trace->getUnchecked(), trace->getFailed(), trace->isTruncated() ? " (trace truncated)" : "");
+}
+
+/*** recurrence ***/
+
+// weekday of a two letter day name (0 = Sunday), -1 if none
+static int8_t getSchedulerDay(const char* name) {
+    for (uint8_t day = 0; day < 7; day++) {
+        if (strncmp(name, scheduler_day_names[day], 2) == 0) return(day);
+    }
+    return(-1);
+}
+
+bool SchedulerLoggerComponent::isRecurring() {
+    uint8_t mode = state->recurrence.repeat & SCHEDULE_REPEAT_MODE;
+    if (mode == SCHEDULE_REPEAT_INTERVAL) return(state->recurrence.minutes[0] > 0 && state->recurrence.minutes[0] != SCHEDULE_TIME_NONE);
+    if (mode == SCHEDULE_REPEAT_DAILY) return((state->recurrence.days & SCHEDULE_DAYS_ALL) != 0 && state->recurrence.minutes[0] != SCHEDULE_TIME_NONE);
+    return(false);
+}
+
+time_t SchedulerLoggerComponent::getNextStart(time_t after) {
+    if (!isRecurring()) return(0);
+    const SchedulerRecurrence* recurrence = &state->recurrence;
+    if ((recurrence->repeat & SCHEDULE_REPEAT_MODE) == SCHEDULE_REPEAT_INTERVAL) {
+        // on the grid of the start time (skipping the starts that passed)
+        time_t interval = recurrence->minutes[0] * 60L;
+        time_t start = (state->tstart > 0) ? (time_t) state->tstart : after;
+        if (start > after) return(start);
+        return(start + ((after - start) / interval + 1) * interval);
+    }
+    // daily: earliest time of day after the time on the first weekday that has one (at most a week ahead)
+    time_t offset = ctrl->state->tz * 3600L; // local time - UTC
+    time_t day = (after + offset) / 86400L; // local day since 1970-01-01 (a Thursday)
+    for (uint8_t d = 0; d <= 7; d++, day++) {
+        if (!(recurrence->days & (1 << ((day + 4) % 7)))) continue;
+        time_t next = 0;
+        for (uint8_t i = 0; i < SCHEDULE_TIMES_MAX; i++) {
+            if (recurrence->minutes[i] == SCHEDULE_TIME_NONE) continue;
+            time_t start = day * 86400L + recurrence->minutes[i] * 60L - offset;
+            if (start > after && (next == 0 || start < next)) next = start;
+        }
+        if (next > 0) return(next);
+    }
+    return(0);
+}
+
+bool SchedulerLoggerComponent::changeRecurrence(const SchedulerRecurrence& recurrence) {
+    bool changed = memcmp(&recurrence, &state->recurrence, sizeof(SchedulerRecurrence)) != 0;
+    state->recurrence = recurrence;
+    // next start (a waiting start is kept, the recurrence applies from the run after it)
+    if (isRecurring() && (state->status == SCHEDULE_UNSCHEDULED || state->status == SCHEDULE_COMPLETE)) {
+        if ((recurrence.repeat & SCHEDULE_REPEAT_MODE) == SCHEDULE_REPEAT_INTERVAL && state->status == SCHEDULE_UNSCHEDULED) state->tstart = Time.now();
+        state->tstart = getNextStart(Time.now());
+        state->status = SCHEDULE_WAITING;
+        state->saved_step = 0;
+        changed = true;
+    }
+    if (changed) saveState(true);
+    char text[50];
+    getSchedulerRecurrenceText(state->recurrence, text, sizeof(text));
+    Serial.printlnf("INFO: schedule '%s' repeat %s", id, text);
+    if (state->status == SCHEDULE_WAITING) {
+        Serial.printf("INFO: next start of %s: ", id);
+        Serial.println(Time.format(state->tstart, "%Y-%m-%d %H:%M (UTC)"));
+    }
+    return(changed);
+}
+
+bool SchedulerLoggerComponent::parseRecurrence(LoggerCommand *command, SchedulerRecurrence* recurrence) {
+    command->extractUnits();
+    command->assignNotes();
+    const char* param = command->notes;
+    if (command->parseUnits(CMD_SCHEDULER_REPEAT_OFF)) {
+        recurrence->repeat = SCHEDULE_REPEAT_OFF | (recurrence->repeat & SCHEDULE_CATCH_UP);
+    } else if (command->parseUnits(CMD_SCHEDULER_REPEAT_EVERY)) {
+        // every <n> <m|h|d>
+        unsigned long n, minutes;
+        char unit;
+        if (sscanf(param, "%lu %c", &n, &unit) != 2) return(false);
+        if (unit == 'm') minutes = n;
+        else if (unit == 'h') minutes = n * 60;
+        else if (unit == 'd') minutes = n * 24 * 60;
+        else return(false);
+        if (minutes == 0 || minutes >= SCHEDULE_TIME_NONE) return(false);
+        recurrence->repeat = SCHEDULE_REPEAT_INTERVAL | (recurrence->repeat & SCHEDULE_CATCH_UP);
+        recurrence->minutes[0] = minutes;
+        for (uint8_t i = 1; i < SCHEDULE_TIMES_MAX; i++) recurrence->minutes[i] = SCHEDULE_TIME_NONE;
+    } else if (command->parseUnits(CMD_SCHEDULER_REPEAT_DAILY)) {
+        // daily HH:MM[,HH:MM...]
+        uint16_t minutes[SCHEDULE_TIMES_MAX] = {SCHEDULE_TIME_NONE, SCHEDULE_TIME_NONE, SCHEDULE_TIME_NONE};
+        uint8_t n = 0;
+        for (const char* c = param; *c != 0; n++) {
+            unsigned int hours, mins;
+            int length;
+            if (n >= SCHEDULE_TIMES_MAX || sscanf(c, "%u:%u%n", &hours, &mins, &length) != 2 || hours > 23 || mins > 59) return(false);
+            minutes[n] = hours * 60 + mins;
+            c += length;
+            if (*c == ',') c++;
+            else if (*c != 0) return(false);
+        }
+        if (n == 0) return(false);
+        recurrence->repeat = SCHEDULE_REPEAT_DAILY | (recurrence->repeat & SCHEDULE_CATCH_UP);
+        memcpy(recurrence->minutes, minutes, sizeof(minutes));
+    } else if (command->parseUnits(CMD_SCHEDULER_REPEAT_DAYS)) {
+        // days all or mo,we,fr or mo-fr
+        uint8_t days = (strcmp(param, "all") == 0) ? SCHEDULE_DAYS_ALL : 0;
+        for (const char* c = param; days != SCHEDULE_DAYS_ALL && *c != 0; ) {
+            int8_t from = getSchedulerDay(c);
+            int8_t to = (from >= 0 && c[2] == '-') ? getSchedulerDay(c + 3) : from;
+            if (from < 0 || to < 0) return(false);
+            for (int8_t day = from; ; day = (day + 1) % 7) {
+                days |= 1 << day;
+                if (day == to) break;
+            }
+            c += (c[2] == '-') ? 5 : 2;
+            if (*c == ',') c++;
+            else if (*c != 0) return(false);
+        }
+        if (days == 0) return(false);
+        recurrence->days = days;
+    } else if (command->parseUnits(CMD_SCHEDULER_REPEAT_CATCH_UP)) {
+        if (strcmp(param, "on") == 0) recurrence->repeat |= SCHEDULE_CATCH_UP;
+        else if (strcmp(param, "off") == 0) recurrence->repeat &= ~SCHEDULE_CATCH_UP;
+        else return(false);
+    } else {
+        return(false);
+    }
+    return(true);
+}
+
+/*** schedules loaded at runtime ***/
+
+bool SchedulerLoggerComponent::isValidEvent(uint8_t event) {
+    // events with actions (without an action table: overload in derived classes)
+    return(actions == 0 || getAction(event) != 0);
+}
+
+bool SchedulerLoggerComponent::addScheduleEvent(const char* line) {
+    if (tables == 0) tables = new SchedulerTable[2];
+    SchedulerTable* table = &tables[next_table];
+    if (!table->add(line)) {
+        Serial.printlnf("WARNING: invalid event line for schedule '%s': %s", id, line);
+        return(false);
+    }
+    if (!isValidEvent(table->getEvents()[table->getLength() - 1].event)) {
+        Serial.printlnf("WARNING: unknown event code for schedule '%s': %s", id, line);
+        table->removeLast();
+        return(false);
+    }
+    return(true);
+}
+
+bool SchedulerLoggerComponent::loadScheduleFile(const char* file_name) {
+    if (tables == 0) tables = new SchedulerTable[2];
+    SchedulerTable* table = &tables[next_table];
+    table->clear();
+    if (!ctrl->isSdEnabled() || !ctrl->sd->available()) return(false);
+    long file_size = ctrl->sd->size(file_name);
+    if (file_size <= 0 || file_size > SCHEDULE_FILE_MAX) {
+        Serial.printlnf("WARNING: schedule file %s is missing, empty or too large (%ld bytes)", file_name, file_size);
+        return(false);
+    }
+    // file text (not on the stack, allocated when first needed and shared by all schedulers)
+    static char* text = 0;
+    if (text == 0) text = new char[SCHEDULE_FILE_MAX + 1];
+    ctrl->sd->read((uint8_t*) text, file_size, file_name);
+    text[file_size] = 0;
+    if (!table->parse(text)) {
+        Serial.printlnf("WARNING: invalid line #%d in schedule file %s", table->getLength() + 1, file_name);
+        table->clear();
+        return(false);
+    }
+    for (uint8_t i = 0; i < table->getLength(); i++) {
+        if (!isValidEvent(table->getEvents()[i].event)) {
+            Serial.printlnf("WARNING: unknown event code %d in schedule file %s", table->getEvents()[i].event, file_name);
+            table->clear();
+            return(false);
+        }
+    }
+    return(table->getLength() > 0);
+}
+
+bool SchedulerLoggerComponent::useNextSchedule() {
+    if (tables == 0 || tables[next_table].getLength() == 0) return(false);
+    return(switchSchedule(tables[next_table].getEvents(), tables[next_table].getLength()));
+}
+
+bool SchedulerLoggerComponent::useCompiledSchedule() {
+    if (schedule == compiled_schedule && !switch_pending) return(false);
+    switch_pending = false; // drop a loaded schedule that was waiting
+    return(switchSchedule(compiled_schedule, compiled_length));
+}
+
+bool SchedulerLoggerComponent::switchSchedule(const SchedulerEvent* events, uint8_t length) {
+    if (isScheduleInUse()) {
+        // the events of a run do not change under it
+        Serial.printlnf("INFO: schedule '%s' switches to the new schedule (%d events) once the current run is finished", id, length);
+        pending_schedule = events;
+        pending_length = length;
+        switch_pending = true;
+        return(true);
+    }
+    return(applySchedule(events, length));
+}
+
+void SchedulerLoggerComponent::applyPendingSchedule() {
+    if (!switch_pending) return;
+    switch_pending = false;
+    if (!applySchedule(pending_schedule, pending_length)) {
+        Serial.printlnf("ERROR: schedule '%s' did not switch to the pending schedule (%d events) and keeps its current one", id, pending_length);
+    }
+}
+
+bool SchedulerLoggerComponent::applySchedule(const SchedulerEvent* events, uint8_t length, bool save_file) {
+    bool compiled = (events == compiled_schedule);
+
+    // keep the loaded schedule on the sd card (restored after a restart)
+    if (!compiled && save_file) {
+        char file_name[13];
+        getScheduleFileName(file_name, sizeof(file_name));
+        char line[SCHEDULE_LABEL_MAX + 20];
+        ctrl->sd->removeFile(file_name);
+        ctrl->sd->append(file_name);
+        for (uint8_t i = 0; i < length; i++) {
+            tables[next_table].getLine(i, line, sizeof(line));
+            ctrl->sd->println(line);
+        }
+        if (!ctrl->sd->syncFile()) {
+            Serial.printlnf("ERROR: could not write schedule file %s, schedule '%s' unchanged", file_name, id);
+            return(false);
+        }
+    }
+
+    // switch
+    schedule = events;
+    schedule_length = length;
+    for (uint8_t i = 0; i < schedule_length; i++) schedule_late[i] = SCHEDULE_LATE_UNKNOWN;
+    if (!compiled) next_table = 1 - next_table; // the next schedule goes into the other table
+    if (tables != 0) tables[next_table].clear();
+    state->schedule = (compiled) ? SCHEDULE_COMPILED : SCHEDULE_FILE;
+    saveState(true);
+    Serial.printlnf("INFO: schedule '%s' now uses the %s schedule (%d events)", id, compiled ? "compiled" : "loaded", schedule_length);
+    return(true);
+}
+
+void SchedulerLoggerComponent::getScheduleFileName(char* target, int size) {
+    snprintf(target, size, "%.8s%s", id, SCHEDULE_FILE_EXT);
+}
+
+bool SchedulerLoggerComponent::isScheduleInUse() {
+    return(state->status == SCHEDULE_RUNNING || testing || start_testing);
+}
+
 void SchedulerLoggerComponent::activateDataLogging() {
   logData();
 }
@@ -295,6 +780,24 @@ void SchedulerLoggerComponent::assembleStateVariable() {
   char pair[60];
   getSchedulerStateTimeStart(cmd, state->tstart, pair, sizeof(pair)); ctrl->addToStateVariableBuffer(pair);
   getSchedulerStateStatus(cmd, state->status, pair, sizeof(pair)); ctrl->addToStateVariableBuffer(pair);
+  if (isRecurring()) {
+    char repeat[sizeof(PATTERN_KV_JSON_QUOTED) + SCHEDULE_KEY_MAX + SCHEDULE_REPEAT_TEXT_MAX];
+    getSchedulerStateRecurrence(cmd, state->recurrence, repeat, sizeof(repeat)); ctrl->addToStateVariableBuffer(repeat);
+  }
+}
+
+/*** debug variable ***/
+
+void SchedulerLoggerComponent::assembleDebugVariable() {
+  ControllerLoggerComponent::assembleDebugVariable();
+  // lateness of each event (ms), - for events not run since the start/restart
+  char late[150];
+  LoggerBuffer late_list(late);
+  for (uint8_t i = 0; i < schedule_length; i++) {
+    if (schedule_late[i] == SCHEDULE_LATE_UNKNOWN) late_list.addItem("-");
+    else late_list.addf((i > 0) ? ",%lu" : "%lu", schedule_late[i]);
+  }
+  ctrl->addToDebugVariableBuffer("late", late);
 }
 
 /*** particle webhook data log ***/
@@ -1,5 +1,6 @@
 #pragma once
 #include "ControllerLoggerComponent.h"
+#include "SchedulerTable.h"
 
 /*** commands ***/
 
@@ -12,42 +13,130 @@
 // device <scheduleID> reset [msg] : reset event
 #define CMD_SCHEDULER_RESET  "reset" 
 
+// device <scheduleID> add <wait> <unit> <event> <label> : add an event to a new schedule (e.g. add 15 m 4 flush probe)
+#define CMD_SCHEDULER_ADD     "add"
+
+// device <scheduleID> use : switch to the new schedule (saved as <ID>.SCH on the SD card)
+#define CMD_SCHEDULER_USE     "use"
+
+// device <scheduleID> load [file] : switch to the schedule from a file on the SD card (default <ID>.SCH)
+#define CMD_SCHEDULER_LOAD    "load"
+
+// device <scheduleID> default : switch back to the compiled schedule
+#define CMD_SCHEDULER_DEFAULT "default"
+
+// device <scheduleID> repeat off/every/daily/days/catch-up ... : start the schedule again after each run
+// repeat off : run once
+// repeat every <n> <m|h|d> : every n minutes/hours/days from the start time (e.g. repeat every 6 h)
+// repeat daily <HH:MM>[,<HH:MM>...] : at up to 3 times of day (local time, e.g. repeat daily 06:30,18:00)
+// repeat days <all|mo,tu,...|mo-fr> : weekdays of the daily runs
+// repeat catch-up on/off : a start missed while the power was out runs right away (on) or is skipped (off)
+#define CMD_SCHEDULER_REPEAT          "repeat"
+#define CMD_SCHEDULER_REPEAT_OFF      "off"
+#define CMD_SCHEDULER_REPEAT_EVERY    "every"
+#define CMD_SCHEDULER_REPEAT_DAILY    "daily"
+#define CMD_SCHEDULER_REPEAT_DAYS     "days"
+#define CMD_SCHEDULER_REPEAT_CATCH_UP "catch-up"
+
+// device <scheduleID> dry-run [next] : run the schedule (or the next one, added/loaded but not used yet) on a virtual
+// clock and print the trace of its actions (nothing is actuated, saved or logged)
+#define CMD_SCHEDULER_DRY_RUN      "dry-run"
+#define CMD_SCHEDULER_DRY_RUN_NEXT "next"
+
 /*** state ***/
 #define SCHEDULE_UNSCHEDULED 1
 #define SCHEDULE_WAITING     2
 #define SCHEDULE_RUNNING     3
 #define SCHEDULE_COMPLETE    4
+#define SCHEDULE_LATE_UNKNOWN 0xFFFFFFFF // lateness of events not run (yet)
+#define SCHEDULE_START_CHECK  60000 // waiting: check the start time at least every minute (in case the time is synced)
+#define SCHEDULE_START_POLL   10 // waiting: last second before the start is checked every 10 ms (time is in seconds)
+#define SCHEDULE_COMPILED     0 // schedule compiled into the firmware
+#define SCHEDULE_FILE         1 // schedule from the <ID>.SCH file on the SD card
+
+// recurrence: the next start is set when a run finishes (and checked at startup for starts missed while the power was out)
+#define SCHEDULE_REPEAT_OFF      0 // runs once
+#define SCHEDULE_REPEAT_INTERVAL 1 // every interval from the start time
+#define SCHEDULE_REPEAT_DAILY    2 // at the times of day on the weekdays
+#define SCHEDULE_REPEAT_MODE     0x0F // mode bits of repeat
+#define SCHEDULE_CATCH_UP        0x80 // flag of repeat: a missed start runs right away (once) instead of being skipped
+#define SCHEDULE_DAYS_ALL        0x7F // weekdays bit mask (bit 0 = Sunday ... bit 6 = Saturday)
+#define SCHEDULE_TIMES_MAX       3 // times of day of daily runs
+#define SCHEDULE_TIME_NONE       0xFFFF // unused time of day
+#define SCHEDULE_MISSED_AFTER    60 // seconds after its start time that a start at startup counts as missed
+struct SchedulerRecurrence {
+  uint8_t repeat = SCHEDULE_REPEAT_OFF; // mode (plus the SCHEDULE_CATCH_UP flag)
+  uint8_t days = SCHEDULE_DAYS_ALL; // weekdays of daily runs
+  uint16_t minutes[SCHEDULE_TIMES_MAX] = {SCHEDULE_TIME_NONE, SCHEDULE_TIME_NONE, SCHEDULE_TIME_NONE}; // daily: times of day (minutes after midnight, local time), interval: the interval in minutes[0]
+};
+
 struct SchedulerState {
 
   uint8_t status = SCHEDULE_UNSCHEDULED; // status of the scheduler
-  time_t tstart = 0; // scheduled start time
+  uint32_t tstart = 0; // scheduled start time (32 bit to leave room for the recurrence in the record)
   uint8_t saved_step = 0; // last saved schedule step
-  time_t saved_time = 0; // last saved schedule step time
-  uint8_t version = 1;
+  uint32_t saved_time = 0; // last saved schedule step time
+  uint8_t schedule = SCHEDULE_COMPILED; // which schedule is used
+  SchedulerRecurrence recurrence; // repeated runs
+  uint8_t version = 2;
 
   SchedulerState() {};
 
 };
 
-/*** schedule ***/
+// EEPROM record of the state (ids of the fields and bytes reserved in each slot, with room for new fields)
+#define SCHEDULER_STATE_RECORD 32
+// (ids 2 and 4 were the time_t start and step times of version 1)
+static const StateField scheduler_state_fields[] = {
+  STATE_FIELD(1, SchedulerState, status),
+  STATE_FIELD(3, SchedulerState, saved_step),
+  STATE_FIELD(5, SchedulerState, schedule),
+  STATE_FIELD(6, SchedulerState, tstart),
+  STATE_FIELD(7, SchedulerState, saved_time),
+  STATE_FIELD(8, SchedulerState, recurrence)
+};
 
-#define SECONDS       1
-#define MINUTES       SECONDS * 60
-#define HOURS         MINUTES * 60
-#define DAYS          HOURS * 24
+// time_t field of a version 1 record (4 or 8 bytes depending on the platform)
+static uint32_t getSchedulerRecordTime(const StateRecord& saved, uint8_t id) {
+  int64_t time64;
+  int32_t time32;
+  if (saved.get(id, &time64)) return(time64);
+  if (saved.get(id, &time32)) return(time32);
+  return(0);
+}
 
-#define EVENT_DEFAULT 0
+// version 1 -> 2: start and step times as 32 bit fields
+static void upgradeSchedulerState1(SchedulerState* state, const StateRecord& saved) {
+  state->tstart = getSchedulerRecordTime(saved, 2);
+  state->saved_time = getSchedulerRecordTime(saved, 4);
+}
 
-struct SchedulerEvent {
-   const uint8_t event; // event
-   const unsigned int wait; // length of wait in seconds
-   const char *label;
-   const char *description;
-   SchedulerEvent(float wait, unsigned int time_unit, uint8_t event, const char* label, const char* description) : wait(round(wait * time_unit)), event(event), label(label), description(description) {};
-   SchedulerEvent(float wait, unsigned int time_unit, uint8_t event, const char* label) : SchedulerEvent(wait, time_unit, event, label, "") {};
+// state in the layout before the state slots (raw struct)
+struct SchedulerStateV1 {
+  uint8_t status;
+  time_t tstart;
+  uint8_t saved_step;
+  time_t saved_time;
+  uint8_t version;
+};
+static const StateField scheduler_state_v1_fields[] = {
+  STATE_FIELD(1, SchedulerStateV1, status),
+  STATE_FIELD(2, SchedulerStateV1, tstart),
+  STATE_FIELD(3, SchedulerStateV1, saved_step),
+  STATE_FIELD(4, SchedulerStateV1, saved_time)
+};
+
+/*** event actions ***/
+
+// commands run for an event as one action batch (see LoggerController::runActions), e.g. {4, "bypass off;25cm on"}
+struct SchedulerAction {
+  const uint8_t event;
+  const char* commands; // separated by ';'
 };
 
 /*** state variable formatting ***/
+#define SCHEDULE_KEY_MAX         20 // state variable keys ("<id>-<setting>", with the terminating 0)
+#define SCHEDULE_REPEAT_TEXT_MAX 50 // recurrence text (with the terminating 0)
 
 // time start
 static void getSchedulerStateTimeStart(char* variable, time_t tstart, char* target, int size, char* pattern, bool include_key = true) {
@@ -88,6 +177,49 @@ static void getSchedulerStateStatus(char* variable, uint8_t status, char* target
   else getSchedulerStateStatus(variable, status, target, size, PATTERN_KV_JSON_QUOTED, true);
 }
 
+// recurrence (e.g. "every 6h", "daily 06:30,18:00 mo,tu,we,th,fr catch-up")
+static const char* scheduler_day_names[] = {"su", "mo", "tu", "we", "th", "fr", "sa"};
+static void getSchedulerRecurrenceText(const SchedulerRecurrence& recurrence, char* target, int size) {
+  LoggerBuffer text(target, size);
+  uint8_t mode = recurrence.repeat & SCHEDULE_REPEAT_MODE;
+  if (mode == SCHEDULE_REPEAT_INTERVAL) {
+    uint16_t interval = recurrence.minutes[0];
+    if (interval % (24 * 60) == 0) text.addf("every %ud", interval / (24 * 60));
+    else if (interval % 60 == 0) text.addf("every %uh", interval / 60);
+    else text.addf("every %um", interval);
+  } else if (mode == SCHEDULE_REPEAT_DAILY) {
+    text.add("daily");
+    for (uint8_t i = 0; i < SCHEDULE_TIMES_MAX; i++) {
+      if (recurrence.minutes[i] != SCHEDULE_TIME_NONE) text.addf("%s%02u:%02u", i == 0 ? " " : ",", recurrence.minutes[i] / 60, recurrence.minutes[i] % 60);
+    }
+    if (recurrence.days != SCHEDULE_DAYS_ALL) {
+      bool first = true;
+      for (uint8_t day = 0; day < 7; day++) {
+        if (recurrence.days & (1 << day)) {
+          text.addf("%s%s", first ? " " : ",", scheduler_day_names[day]);
+          first = false;
+        }
+      }
+    }
+  } else {
+    text.add("off");
+  }
+  if (mode != SCHEDULE_REPEAT_OFF && (recurrence.repeat & SCHEDULE_CATCH_UP)) text.add(" catch-up");
+}
+
+static void getSchedulerStateRecurrence(char* variable, const SchedulerRecurrence& recurrence, char* target, int size, char* pattern, bool include_key = true) {
+  char var_cmd[SCHEDULE_KEY_MAX];
+  snprintf(var_cmd, sizeof(var_cmd), "%s-%s", variable, CMD_SCHEDULER_REPEAT);
+  char text[SCHEDULE_REPEAT_TEXT_MAX];
+  getSchedulerRecurrenceText(recurrence, text, sizeof(text));
+  getStateStringText(var_cmd, text, target, size, pattern, include_key);
+}
+
+static void getSchedulerStateRecurrence(char* variable, const SchedulerRecurrence& recurrence, char* target, int size, bool value_only = false) {
+  if (value_only) getSchedulerStateRecurrence(variable, recurrence, target, size, PATTERN_V_SIMPLE, false);
+  else getSchedulerStateRecurrence(variable, recurrence, target, size, PATTERN_KV_JSON_QUOTED, true);
+}
+
 /*** scheduler component ***/
 #define SCHEDULER_DT_PATTERN_YMD_24HM "%Y-%m-%d %H:%M"
 class SchedulerLoggerComponent : public ControllerLoggerComponent {
@@ -104,10 +236,27 @@ class SchedulerLoggerComponent : public ControllerLoggerComponent {
 
     // scheduler events
     const SchedulerEvent* schedule; 
-    const uint8_t schedule_length;
+    uint8_t schedule_length;
+    // schedules loaded at runtime: the one in use and the next one (allocated when first needed)
+    const SchedulerEvent* compiled_schedule;
+    const uint8_t compiled_length;
+    SchedulerTable* tables = 0;
+    uint8_t next_table = 0; // table the next schedule is added/loaded to
+    bool switch_pending = false; // next schedule is used once the current run is finished
+    const SchedulerEvent* pending_schedule = 0;
+    uint8_t pending_length = 0;
+    // event actions (if the events are not run by a derived class)
+    const SchedulerAction* actions;
+    const uint8_t actions_length;
     uint8_t schedule_i = 0;
-    time_t schedule_last = 0;
     unsigned int schedule_wait = 0;
+    // absolute deadlines: each event is due its wait after the previous event's deadline (lateness does not carry over)
+    time_t schedule_origin = 0; // deadline of the previous event (tstart, start of a test or resume point for the first)
+    unsigned long schedule_origin_ms = 0; // millis() at the origin (for ms resolution)
+    bool schedule_anchored = false; // whether schedule_origin_ms is set (needs a valid time)
+    unsigned long schedule_deadline = 0; // deadline of the next event (ms after the origin, at most SCHEDULE_WAIT_MAX)
+    unsigned long* schedule_late; // observed lateness of each event (ms, SCHEDULE_LATE_UNKNOWN if not run since boot)
+    LoggerTimer schedule_timer{this}; // next start/event (no checks on the loop passes in between)
     bool start_testing = false;
     bool testing = false;
     unsigned int testing_waits = 0;
@@ -116,13 +265,21 @@ class SchedulerLoggerComponent : public ControllerLoggerComponent {
 
     // state
     SchedulerState* state;
+    PersistentState<SchedulerState> persistent_state; // EEPROM slots of the state
 
     /*** constructors ***/
     // derived from controllerlogger component which has NO global time offsets and manages own data clearing by default --> keep defaults
-    SchedulerLoggerComponent (const char *id, LoggerController *ctrl, SchedulerState* state, const char *pattern, const SchedulerEvent* schedule, const uint8_t schedule_length) : 
-      ControllerLoggerComponent(id, ctrl), state(state), pattern(pattern), schedule(schedule), schedule_length(schedule_length) { cmd = strdup(id); }
-    SchedulerLoggerComponent (const char *id, LoggerController *ctrl, const char *pattern, const SchedulerEvent* schedule, const uint8_t schedule_length) : 
-      SchedulerLoggerComponent (id, ctrl, new SchedulerState(), pattern, schedule, schedule_length) {}
+    SchedulerLoggerComponent (const char *id, LoggerController *ctrl, SchedulerState* state, const char *pattern, const SchedulerEvent* schedule, const uint8_t schedule_length, const SchedulerAction* actions = 0, const uint8_t actions_length = 0) : 
+      ControllerLoggerComponent(id, ctrl), pattern(pattern), schedule(schedule), schedule_length(schedule_length), compiled_schedule(schedule), compiled_length(schedule_length), actions(actions), actions_length(actions_length), state(state), persistent_state(state, scheduler_state_fields, SCHEDULER_STATE_RECORD) {
+        cmd = strdup(id);
+        uint8_t max_length = (schedule_length > SCHEDULE_TABLE_MAX) ? schedule_length : SCHEDULE_TABLE_MAX;
+        schedule_late = new unsigned long[max_length];
+        for (uint8_t i = 0; i < max_length; i++) schedule_late[i] = SCHEDULE_LATE_UNKNOWN;
+        persistent_state.setLegacyLayout<SchedulerStateV1>(1, scheduler_state_v1_fields); // raw struct before the state slots
+        persistent_state.addUpgrade(1, upgradeSchedulerState1);
+      }
+    SchedulerLoggerComponent (const char *id, LoggerController *ctrl, const char *pattern, const SchedulerEvent* schedule, const uint8_t schedule_length, const SchedulerAction* actions = 0, const uint8_t actions_length = 0) : 
+      SchedulerLoggerComponent (id, ctrl, new SchedulerState(), pattern, schedule, schedule_length, actions, actions_length) {}
     SchedulerLoggerComponent (const char *id, LoggerController *ctrl, const SchedulerEvent* schedule, const uint8_t schedule_length) : 
       SchedulerLoggerComponent (id, ctrl, SCHEDULER_DT_PATTERN_YMD_24HM, schedule, schedule_length) {}
 
@@ -132,21 +289,29 @@ class SchedulerLoggerComponent : public ControllerLoggerComponent {
     virtual void completeStartup();
 
     /*** loop ***/
-    virtual void update(); 
+    virtual bool isPolled();
+    virtual void handleTimer(LoggerTimer* timer);
+    void armSchedule();
     bool checkSchedule();
     void startSchedule();
+    void anchorSchedule();
     virtual void runSchedule();
-    virtual void runEvent(uint8_t event);
+    virtual void runEvent(uint8_t event); // runs the event's actions (or override in derived classes)
+    const SchedulerAction* getAction(uint8_t event); // actions of an event, 0 if none
     void getSchedulerStatus(char* target, int size);
     void finishSchedule();
+    void catchUpSchedule(); // start missed while the power was out (recurring schedules)
 
     /*** state management ***/
     virtual size_t getStateSize();
+    virtual size_t getLegacyStateSize();
     virtual void saveState(bool always = false);
+    virtual void commitState();
     virtual bool restoreState();
     virtual void resetState();
 
     /*** command parsing ***/
+    void registerCommands();
     bool parseCommand(LoggerCommand *command);
     bool parseSchedule(LoggerCommand *command);
     
@@ -154,11 +319,38 @@ class SchedulerLoggerComponent : public ControllerLoggerComponent {
     bool changeSchedule(tm timeobj);
     bool resetSchedule();
     bool testSchedule(unsigned int waits = 0);
+
+    /*** dry run ***/
+    bool dryRunSchedule(const SchedulerEvent* events, uint8_t length); // actions of all events on a virtual clock (needs an action table)
+    void printTrace(const LoggerTrace* trace, const SchedulerEvent* events);
+
+    /*** recurrence ***/
+    bool isRecurring(); // whether the schedule starts again after each run
+    time_t getNextStart(time_t after); // next start of a recurring schedule after a time (0 if none)
+    bool changeRecurrence(const SchedulerRecurrence& recurrence);
+    bool parseRecurrence(LoggerCommand *command, SchedulerRecurrence* recurrence);
+
+    /*** schedules loaded at runtime ***/
+    virtual bool isValidEvent(uint8_t event); // whether runEvent() knows an event code (has actions, or override in derived classes)
+    bool addScheduleEvent(const char* line); // add an event line to the next schedule
+    bool loadScheduleFile(const char* file_name); // read the next schedule from a file on the SD card
+    bool useNextSchedule(); // switch to the next schedule (now or at the end of the current run), false if there is none or its file could not be saved
+    bool useCompiledSchedule(); // switch back to the compiled schedule (now or at the end of the current run)
+    bool switchSchedule(const SchedulerEvent* events, uint8_t length); // switch now or once the current run is finished
+    void applyPendingSchedule(); // switch waiting for the end of the run
+    bool applySchedule(const SchedulerEvent* events, uint8_t length, bool save_file = true); // switch now (saves the schedule file of loaded schedules)
+    void getScheduleFileName(char* target, int size);
+    bool isScheduleInUse(); // whether a run (or test) is in progress
+    uint8_t getScheduleLength() { return(schedule_length); }
+    const SchedulerEvent* getSchedule() { return(schedule); }
     virtual void activateDataLogging();
 
     /*** logger state variable ***/
     virtual void assembleStateVariable();
 
+    /*** debug variable ***/
+    virtual void assembleDebugVariable();
+
     /*** particle webhook data log ***/
     virtual void logData();
 
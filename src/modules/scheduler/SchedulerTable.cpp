@@ -0,0 +1,61 @@
+#include "application.h"
+#include "SchedulerTable.h"
+#include <new>
+
+bool SchedulerTable::add(const char* line) {
+  if (length >= SCHEDULE_TABLE_MAX) return(false);
+
+  // <wait> <unit> <event code> <label>
+  float wait;
+  char unit[5];
+  unsigned int event;
+  int label_start = 0;
+  if (sscanf(line, " %f %4s %u %n", &wait, unit, &event, &label_start) < 3 || label_start == 0) return(false);
+  unsigned int time_unit;
+  if (strcmp(unit, "s") == 0) time_unit = SECONDS;
+  else if (strcmp(unit, "m") == 0) time_unit = MINUTES;
+  else if (strcmp(unit, "h") == 0) time_unit = HOURS;
+  else if (strcmp(unit, "d") == 0) time_unit = DAYS;
+  else return(false);
+  if (wait < 0 || wait * time_unit > SCHEDULE_WAIT_MAX || event > 255) return(false);
+
+  // label (without trailing whitespace)
+  const char* label = line + label_start;
+  size_t label_length = strlen(label);
+  while (label_length > 0 && isspace(label[label_length - 1])) label_length--;
+  if (label_length == 0 || label_length > SCHEDULE_LABEL_MAX) return(false);
+  memcpy(labels[length], label, label_length);
+  labels[length][label_length] = 0;
+
+  new (pool + length * sizeof(SchedulerEvent)) SchedulerEvent(wait, time_unit, event, labels[length]);
+  length++;
+  return(true);
+}
+
+bool SchedulerTable::parse(const char* text) {
+  clear();
+  char line[60];
+  while (*text != 0) {
+    // next line
+    size_t n = strcspn(text, "\r\n");
+    if (n >= sizeof(line)) return(false);
+    memcpy(line, text, n);
+    line[n] = 0;
+    text += n;
+    text += strspn(text, "\r\n");
+    // skip empty lines and comments
+    const char* start = line + strspn(line, " \t");
+    if (*start == 0 || *start == '#') continue;
+    if (!add(start)) return(false);
+  }
+  return(true);
+}
+
+void SchedulerTable::getLine(uint8_t i, char* target, size_t size) {
+  const SchedulerEvent* event = getEvents() + i;
+  snprintf(target, size, "%u s %u %s", event->wait, event->event, event->label);
+}
+
+const SchedulerEvent* SchedulerTable::getEvents() {
+  return((const SchedulerEvent*) pool);
+}
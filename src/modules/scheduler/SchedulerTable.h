@@ -0,0 +1,63 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+/*** schedule ***/
+
+#define SECONDS       1
+#define MINUTES       SECONDS * 60
+#define HOURS         MINUTES * 60
+#define DAYS          HOURS * 24
+
+#define EVENT_DEFAULT 0
+
+struct SchedulerEvent {
+   const uint8_t event; // event
+   const unsigned int wait; // length of wait in seconds
+   const char *label;
+   const char *description;
+   SchedulerEvent(float wait, unsigned int time_unit, uint8_t event, const char* label, const char* description) : event(event), wait(round(wait * time_unit)), label(label), description(description) {};
+   SchedulerEvent(float wait, unsigned int time_unit, uint8_t event, const char* label) : SchedulerEvent(wait, time_unit, event, label, "") {};
+};
+
+/*** schedule table ***/
+#define SCHEDULE_TABLE_MAX    24 // events of a schedule loaded at runtime
+#define SCHEDULE_LABEL_MAX    15 // max characters of an event label
+#define SCHEDULE_WAIT_MAX     (24UL * 24 * 3600) // max wait of an event (in seconds, waits are timed in ms)
+#define SCHEDULE_FILE_MAX     1024 // max bytes of a schedule file on the SD card
+#define SCHEDULE_FILE_EXT     ".SCH" // schedule file of a scheduler: <ID>.SCH (8.3 file name)
+
+// Schedule loaded at runtime (from the SD card or uploaded with commands) instead of compiled in
+// - one event per line: <wait> <unit: s, m, h or d> <event code> <label>, e.g. "15 m 4 flush probe"
+//   (empty lines and lines starting with # are skipped)
+// - events are validated as they are added and stored in a preallocated pool (incl. their labels)
+class SchedulerTable {
+
+  private:
+
+    alignas(SchedulerEvent) uint8_t pool[SCHEDULE_TABLE_MAX * sizeof(SchedulerEvent)]; // events (constructed in place)
+    char labels[SCHEDULE_TABLE_MAX][SCHEDULE_LABEL_MAX + 1];
+    uint8_t length = 0;
+
+  public:
+
+    SchedulerTable() {}
+
+    // parse and add an event line
+    // @return false if the line is invalid or the table is full
+    bool add(const char* line);
+
+    // replace the events with the lines of a text
+    // @return false if any line is invalid (the table then holds the events up to that line)
+    bool parse(const char* text);
+
+    // event line (in seconds, as written to the schedule file)
+    void getLine(uint8_t i, char* target, size_t size);
+
+    void clear() { length = 0; }
+    void removeLast() { if (length > 0) length--; }
+    const SchedulerEvent* getEvents();
+    uint8_t getLength() const { return(length); }
+
+};
@@ -41,31 +41,33 @@ void ValveLoggerComponent::update() {
 /*** state management ***/
     
 size_t ValveLoggerComponent::getStateSize() { 
-    return(sizeof(*state));
+    return(persistent_state.getSize());
+}
+
+size_t ValveLoggerComponent::getLegacyStateSize() { 
+    return(persistent_state.getLegacySize());
 }
 
 void ValveLoggerComponent::saveState(bool always) { 
+    state_changed = true; // state variable & display info out of date
     if (ctrl->state->save_state || always) {
-        EEPROM.put(eeprom_start, *state);
-        if (ctrl->debug_state) {
-            Serial.printf("DEBUG: component '%s' state saved in memory (if any updates were necessary)\n", id);
-        }
+        // in an action batch: saved once at its end
+        if (!ctrl->deferStateSave(this)) commitState();
     } else {
         Serial.printlnf("DEBUG: component '%s' state NOT saved because state saving is off", id);
     }
 } 
 
-bool ValveLoggerComponent::restoreState() {
-    ValveState *saved_state = new ValveState();
-    EEPROM.get(eeprom_start, *saved_state);
-    bool recoverable = saved_state->version == state->version;
-    if(recoverable) {
-        EEPROM.get(eeprom_start, *state);
-        Serial.printf("INFO: successfully restored component state from memory (state version %d)\n", state->version);
-    } else {
-        Serial.printf("INFO: could not restore state from memory (found state version %d instead of %d), sticking with initial default\n", saved_state->version, state->version);
-        saveState(true);
+void ValveLoggerComponent::commitState() { 
+    persistent_state.save(eeprom_start);
+    if (ctrl->debug_state) {
+        Serial.printf("DEBUG: component '%s' state saved in memory (if any updates were necessary)\n", id);
     }
+} 
+
+bool ValveLoggerComponent::restoreState() {
+    bool recoverable = persistent_state.restore(eeprom_start, getLegacyState());
+    if (!recoverable) saveState(true);
     return(recoverable);
 }
 
@@ -76,6 +78,10 @@ void ValveLoggerComponent::resetState() {
 
 /*** command parsing ***/
 
+void ValveLoggerComponent::registerCommands() {
+  ctrl->registerCommand(cmd, this);
+}
+
 bool ValveLoggerComponent::parseCommand(LoggerCommand *command) {
   if (parseMovement(command)) {
     // valve position and direction
@@ -29,6 +29,13 @@ struct ValveState {
 
 };
 
+// EEPROM record of the state (ids of the fields and bytes reserved in each slot, with room for new fields)
+#define VALVE_STATE_RECORD 12
+static const StateField valve_state_fields[] = {
+  STATE_FIELD(1, ValveState, pos),
+  STATE_FIELD(2, ValveState, cw)
+};
+
 /*** state variable formatting ***/
 static void getValveStatePosText(char* variable, uint8_t pos, char* target, int size, char* pattern, bool include_key = true) {
     char var_cmd[20];
@@ -70,11 +77,15 @@ class ValveLoggerComponent : public SerialReaderLoggerComponent {
 
     // state
     ValveState* state;
+    PersistentState<ValveState> persistent_state; // EEPROM slots of the state
 
     /*** constructors ***/
     // vavle doesn't have global offset, it uses individual data points with different time offsets to report step change
     ValveLoggerComponent (const char *id, LoggerController *ctrl, ValveState* state, const long baud_rate, const long serial_config, uint8_t max_pos, const char *request_command, unsigned int data_pattern_size) : 
-      SerialReaderLoggerComponent(id, ctrl, false, baud_rate, serial_config, request_command, data_pattern_size), state(state), max_pos(max_pos) { cmd = strdup(id); }
+      SerialReaderLoggerComponent(id, ctrl, false, baud_rate, serial_config, request_command, data_pattern_size), max_pos(max_pos), state(state), persistent_state(state, valve_state_fields, VALVE_STATE_RECORD) {
+        cmd = strdup(id);
+        persistent_state.setLegacyLayout<ValveState>(1, valve_state_fields); // raw struct before the state slots
+      }
     ValveLoggerComponent (const char *id, LoggerController *ctrl, ValveState* state, const long baud_rate, const long serial_config, uint8_t max_pos, const char *request_command) : 
       ValveLoggerComponent(id, ctrl, state, baud_rate, serial_config, max_pos, request_command, 0) {}
     ValveLoggerComponent (const char *id, LoggerController *ctrl, ValveState* state, const long baud_rate, const long serial_config, uint8_t max_pos, unsigned int data_pattern_size) : 
@@ -92,11 +103,14 @@ class ValveLoggerComponent : public SerialReaderLoggerComponent {
 
     /*** state management ***/
     virtual size_t getStateSize();
+    virtual size_t getLegacyStateSize();
     virtual void saveState(bool always = false);
+    virtual void commitState();
     virtual bool restoreState();
     virtual void resetState();
 
     /*** command parsing ***/
+    void registerCommands();
     bool parseCommand(LoggerCommand *command);
     bool parseMovement(LoggerCommand *command);
     
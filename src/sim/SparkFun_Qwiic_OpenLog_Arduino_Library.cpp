@@ -0,0 +1,120 @@
+#include "SparkFun_Qwiic_OpenLog_Arduino_Library.h"
+#include "sim.h"
+#include <sys/stat.h>
+#include <unistd.h>
+
+// card contents are files in the simulation's sd directory
+static std::string path(const std::string& file_name) {
+  return(sim::sdDirectory() + "/" + file_name);
+}
+
+// file that is currently appended to (kept open between writes)
+static std::string open_name;
+static FILE* open_file = 0;
+
+static void closeFile() {
+  if (open_file) fclose(open_file);
+  open_file = 0;
+  open_name.clear();
+}
+
+static void appendToFile(const std::string& file_name, const char* data, size_t n) {
+  if (open_file == 0 || open_name != file_name) {
+    closeFile();
+    open_file = fopen(path(file_name).c_str(), "ab");
+    if (open_file == 0) return;
+    open_name = file_name;
+  }
+  fwrite(data, 1, n, open_file);
+}
+
+void OpenLog::transaction(size_t bytes) {
+  i2c->beginTransmission(address);
+  for (size_t i = 0; i < bytes; i++) i2c->write((uint8_t) 0);
+  i2c->endTransmission();
+}
+
+void OpenLog::request(size_t bytes) {
+  i2c->requestFrom(address, (uint8_t) bytes);
+}
+
+bool OpenLog::begin(uint8_t device_address, TwoWire& wire_port) {
+  address = device_address;
+  i2c = &wire_port;
+  // status check
+  transaction(1);
+  request(1);
+  return(true);
+}
+
+uint8_t OpenLog::getStatus() {
+  transaction(1);
+  request(1);
+  return(0);
+}
+
+size_t OpenLog::append(String file_name) {
+  // register + file name
+  transaction(1 + file_name.length());
+  current_file = file_name.c_str();
+  appendToFile(current_file, "", 0);
+  return(1);
+}
+
+size_t OpenLog::create(String file_name) {
+  transaction(1 + file_name.length());
+  appendToFile(file_name.c_str(), "", 0);
+  return(1);
+}
+
+int32_t OpenLog::size(String file_name) {
+  transaction(1 + file_name.length());
+  request(4);
+  closeFile();
+  struct stat info;
+  if (stat(path(file_name.c_str()).c_str(), &info) != 0) return(-1);
+  return((int32_t) info.st_size);
+}
+
+void OpenLog::read(uint8_t* user_buffer, uint16_t buffer_size, String file_name) {
+  // always reads from the start of the file
+  transaction(1 + file_name.length());
+  // read back in 32 byte chunks
+  for (uint16_t i = 0; i < buffer_size; i += 32) request(buffer_size - i < 32 ? buffer_size - i : 32);
+  closeFile();
+  FILE* file = fopen(path(file_name.c_str()).c_str(), "rb");
+  if (file == 0) return;
+  size_t n = fread(user_buffer, 1, buffer_size, file);
+  (void) n;
+  fclose(file);
+}
+
+uint32_t OpenLog::removeFile(String file_name) {
+  transaction(1 + file_name.length());
+  request(4);
+  if (current_file == file_name.c_str()) current_file.clear();
+  closeFile();
+  return(unlink(path(file_name.c_str()).c_str()) == 0 ? 1 : 0);
+}
+
+bool OpenLog::syncFile() {
+  transaction(2);
+  if (open_file) fflush(open_file);
+  return(true);
+}
+
+int OpenLog::writeString(String string) {
+  // register + up to 31 bytes per transaction
+  size_t n = string.length();
+  for (size_t i = 0; i < n; i += 31) transaction(1 + (n - i < 31 ? n - i : 31));
+  if (!current_file.empty()) appendToFile(current_file, string.c_str(), n);
+  return(n);
+}
+
+size_t OpenLog::write(uint8_t character) {
+  // the Print interface sends every byte in its own transaction
+  transaction(1);
+  char c = (char) character;
+  if (!current_file.empty()) appendToFile(current_file, &c, 1);
+  return(1);
+}
@@ -0,0 +1,39 @@
+/**
+ * Host stand-in for the SparkFun Qwiic OpenLog library.
+ * Files are kept in a host directory (sim::sdDirectory()) so the card contents survive a simulated reboot.
+ * Every call costs the same i2c transactions as the real library (e.g. one transaction per byte written
+ * through the Print interface) so the simulation accounts the blocking bus time in its virtual clock.
+ */
+
+#pragma once
+#include "application.h"
+
+#define QOL_DEFAULT_ADDRESS 0x2A
+
+class OpenLog : public Print {
+
+  private:
+
+    uint8_t address = QOL_DEFAULT_ADDRESS;
+    TwoWire* i2c = 0;
+    std::string current_file; // file that writes are appended to
+
+    void transaction(size_t bytes); // one i2c write transaction
+    void request(size_t bytes); // one i2c read transaction
+
+  public:
+
+    bool begin(uint8_t device_address = QOL_DEFAULT_ADDRESS, TwoWire& wire_port = Wire);
+    uint8_t getStatus();
+
+    size_t append(String file_name);
+    size_t create(String file_name);
+    int32_t size(String file_name);
+    void read(uint8_t* user_buffer, uint16_t buffer_size, String file_name);
+    uint32_t removeFile(String file_name);
+    bool syncFile();
+
+    int writeString(String string);
+    virtual size_t write(uint8_t character);
+
+};
@@ -0,0 +1,3 @@
+// host stand-in: everything lives in application.h
+#pragma once
+#include "application.h"
@@ -0,0 +1,418 @@
+#include "application.h"
+#include "sim.h"
+#include <malloc.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <map>
+#include <vector>
+
+/*** globals ***/
+
+USBSerial Serial;
+USARTSerial Serial1;
+TwoWire Wire;
+SPIClass SPI;
+EEPROMClass EEPROM;
+CloudClass Particle;
+SystemClass System;
+TimeClass Time;
+WiFiClass WiFi;
+
+/*** simulation state ***/
+
+namespace sim {
+
+  bool echo_serial = false;
+  bool console_input = false;
+  bool echo_publish = false;
+  unsigned long connect_ms = 2000;
+  unsigned long publish_ack_ms = 500;
+  const char* device_name = "sim";
+  std::function<void(uint8_t)> serial1_device;
+  uint32_t heap_size = 80000;
+  long heap_excluded = 0;
+  Stats stats;
+
+  // clock
+  static unsigned long long clock_us = 0;
+  static time_t epoch = 1656633600; // 2022-07-01 00:00:00 UTC
+
+  // network & cloud
+  static bool network = true;
+  static bool connection_started = false;
+  static unsigned long long connected_at = 0;
+  static std::map<std::string, const char*> variables;
+  static std::map<std::string, std::function<int(String)>> functions;
+  static std::vector<std::pair<std::string, std::function<void(const char*, const char*)>>> subscriptions;
+  static std::deque<std::pair<std::string, std::string>> pending_events;
+
+  // pins
+  static uint8_t pins[SIM_PIN_COUNT];
+
+  // EEPROM (erased flash reads 0xFF)
+  static uint8_t eeprom[EEPROMClass::EEPROM_SIZE];
+  static bool eeprom_erased = (memset(eeprom, 0xFF, sizeof(eeprom)), true);
+  static unsigned long eeprom_cell_writes[EEPROMClass::EEPROM_SIZE];
+  long eeprom_write_budget = -1;
+
+  // storage
+  static std::string storage;
+  static int eeprom_fd = -1;
+
+  // heap usage at the first memory check (after the firmware globals are constructed)
+  static size_t heap_baseline = 0;
+
+  unsigned long long now_us() { return(clock_us); }
+  void advanceMicros(unsigned long long us) { clock_us += us; }
+  void advance(unsigned long ms) { clock_us += 1000ULL * ms; }
+  void setEpoch(time_t t) { epoch = t; }
+
+  void setNetwork(bool up) {
+    // a restored network needs a new connection handshake
+    if (up && !network) connected_at = clock_us + 1000ULL * connect_ms;
+    network = up;
+  }
+
+  bool isNetworkUp() { return(network); }
+
+  void setStorage(const char* dir) {
+    storage = dir;
+    mkdir(storage.c_str(), 0755);
+    mkdir((storage + "/sd").c_str(), 0755);
+    // restore EEPROM image (or start a new one from the current contents)
+    if (eeprom_fd >= 0) close(eeprom_fd);
+    eeprom_fd = open((storage + "/eeprom.bin").c_str(), O_RDWR | O_CREAT, 0644);
+    if (eeprom_fd < 0) return;
+    uint8_t image[sizeof(eeprom)];
+    if (pread(eeprom_fd, image, sizeof(image), 0) == (ssize_t) sizeof(image)) {
+      memcpy(eeprom, image, sizeof(eeprom));
+    } else if (pwrite(eeprom_fd, eeprom, sizeof(eeprom), 0) < 0) {
+      perror("eeprom image");
+    }
+  }
+
+  std::string sdDirectory() {
+    if (storage.empty()) {
+      char dir[] = "/tmp/sim-XXXXXX";
+      if (mkdtemp(dir) != 0) setStorage(dir);
+    }
+    return(storage + "/sd");
+  }
+
+  unsigned long eepromCellWrites(int address) {
+    return((address >= 0 && address < (int) EEPROMClass::EEPROM_SIZE) ? eeprom_cell_writes[address] : 0);
+  }
+
+  bool loadEEPROM(const char* path) {
+    uint8_t image[sizeof(eeprom)];
+    memset(image, 0xFF, sizeof(image));
+    if (path) {
+      FILE* file = fopen(path, "rb");
+      size_t read = file ? fread(image, 1, sizeof(image), file) : 0;
+      if (file) fclose(file);
+      if (read != sizeof(image)) {
+        fprintf(stderr, "ERROR: could not read EEPROM image '%s'\n", path);
+        return(false);
+      }
+    }
+    memcpy(eeprom, image, sizeof(eeprom));
+    if (eeprom_fd >= 0 && pwrite(eeprom_fd, eeprom, sizeof(eeprom), 0) < 0) perror("eeprom image");
+    return(true);
+  }
+
+  static void saveEEPROM(int address) {
+    if (eeprom_fd >= 0 && pwrite(eeprom_fd, eeprom + address, 1, address) < 0) perror("eeprom image");
+  }
+
+  int callFunction(const char* name, const char* arg) {
+    auto fn = functions.find(name);
+    if (fn == functions.end()) return(-1);
+    return(fn->second(String(arg)));
+  }
+
+  const char* getVariable(const char* name) {
+    auto var = variables.find(name);
+    return(var == variables.end() ? 0 : var->second);
+  }
+
+}
+
+/*** timing ***/
+
+unsigned long millis() { return(sim::clock_us / 1000ULL); }
+unsigned long micros() { return(sim::clock_us); }
+void delay(unsigned long ms) { sim::advance(ms); }
+void delayMicroseconds(unsigned int us) { sim::advanceMicros(us); }
+
+/*** pins ***/
+
+void pinMode(pin_t pin, uint8_t mode) {}
+
+void digitalWrite(pin_t pin, uint8_t value) {
+  if (pin < SIM_PIN_COUNT) sim::pins[pin] = value;
+}
+
+int32_t digitalRead(pin_t pin) {
+  return(pin < SIM_PIN_COUNT ? sim::pins[pin] : LOW);
+}
+
+/*** print ***/
+
+size_t Print::vprintf(bool newline, const char* format, va_list args) {
+  char buffer[256];
+  va_list args2;
+  va_copy(args2, args);
+  int n = vsnprintf(buffer, sizeof(buffer), format, args);
+  size_t written = 0;
+  if (n >= (int) sizeof(buffer)) {
+    std::string large(n + 1, 0);
+    vsnprintf(&large[0], n + 1, format, args2);
+    written = write((const uint8_t*) large.c_str(), n);
+  } else if (n > 0) {
+    written = write((const uint8_t*) buffer, n);
+  }
+  va_end(args2);
+  if (newline) written += println();
+  return(written);
+}
+
+size_t Print::printf(const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  size_t n = vprintf(false, format, args);
+  va_end(args);
+  return(n);
+}
+
+size_t Print::printlnf(const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  size_t n = vprintf(true, format, args);
+  va_end(args);
+  return(n);
+}
+
+/*** usb serial ***/
+
+size_t USBSerial::write(uint8_t c) {
+  if (sim::echo_serial && c != '\r') fputc(c, stdout);
+  return(1);
+}
+
+size_t USBSerial::write(const uint8_t* buffer, size_t size) {
+  if (sim::echo_serial) {
+    for (size_t i = 0; i < size; i++) if (buffer[i] != '\r') fputc(buffer[i], stdout);
+  }
+  return(size);
+}
+
+// console input: bytes from stdin (without blocking, stdin is only read when there is something to read)
+static std::deque<uint8_t> console_rx;
+static bool console_closed = false;
+
+static void readConsoleInput() {
+  if (!sim::console_input || console_closed) return;
+  struct pollfd fd = {0, POLLIN, 0};
+  while (poll(&fd, 1, 0) > 0) {
+    uint8_t buffer[256];
+    ssize_t n = ::read(0, buffer, sizeof(buffer));
+    if (n <= 0) {
+      console_closed = true;
+      break;
+    }
+    console_rx.insert(console_rx.end(), buffer, buffer + n);
+  }
+}
+
+bool sim::isConsoleDone() {
+  readConsoleInput();
+  return(console_closed && console_rx.empty());
+}
+
+int USBSerial::available() {
+  readConsoleInput();
+  return(console_rx.size());
+}
+
+int USBSerial::read() {
+  readConsoleInput();
+  if (console_rx.empty()) return(-1);
+  uint8_t b = console_rx.front();
+  console_rx.pop_front();
+  return(b);
+}
+
+int USBSerial::peek() {
+  readConsoleInput();
+  return(console_rx.empty() ? -1 : console_rx.front());
+}
+
+/*** hardware serial ***/
+
+size_t USARTSerial::write(uint8_t c) {
+  if (sim::serial1_device) sim::serial1_device(c);
+  return(1);
+}
+
+int USARTSerial::read() {
+  if (rx.empty()) return(-1);
+  uint8_t b = rx.front();
+  rx.pop_front();
+  return(b);
+}
+
+void USARTSerial::inject(const char* data) {
+  for (; *data; data++) rx.push_back(*data);
+}
+
+/*** i2c ***/
+
+// devices that acknowledge their address: SerLCD and Qwiic OpenLog
+static bool isI2CDevicePresent(uint8_t address) {
+  return(address == 0x72 || address == 0x2a);
+}
+
+uint8_t TwoWire::endTransmission(bool stop) {
+  // 100 kHz bus: ~90 us per byte incl. ack, plus address byte and start/stop
+  sim::stats.i2c_transactions++;
+  sim::stats.i2c_bytes += tx_bytes;
+  sim::advanceMicros((tx_bytes + 2) * 90);
+  tx_bytes = 0;
+  return(isI2CDevicePresent(tx_address) ? 0 : 2);
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint8_t stop) {
+  sim::stats.i2c_transactions++;
+  sim::stats.i2c_bytes += quantity;
+  sim::advanceMicros((quantity + 2) * 90);
+  return(isI2CDevicePresent(address) ? quantity : 0);
+}
+
+/*** EEPROM ***/
+
+uint8_t EEPROMClass::read(int address) {
+  return((address >= 0 && address < (int) EEPROM_SIZE) ? sim::eeprom[address] : 0xFF);
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+  if (address >= 0 && address < (int) EEPROM_SIZE && sim::eeprom[address] != value) {
+    if (sim::eeprom_write_budget == 0) return; // power lost
+    if (sim::eeprom_write_budget > 0) sim::eeprom_write_budget--;
+    sim::eeprom[address] = value;
+    sim::eeprom_cell_writes[address]++;
+    sim::stats.eeprom_writes++;
+    sim::saveEEPROM(address);
+  }
+}
+
+/*** cloud ***/
+
+void CloudClass::connect() {
+  if (!sim::connection_started) {
+    sim::connection_started = true;
+    sim::connected_at = sim::clock_us + 1000ULL * sim::connect_ms;
+  }
+}
+
+void CloudClass::disconnect() {
+  sim::connection_started = false;
+}
+
+bool CloudClass::connected() {
+  return(sim::network && sim::connection_started && sim::clock_us >= sim::connected_at);
+}
+
+void CloudClass::process() {
+  // deliver subscribed events
+  while (!sim::pending_events.empty()) {
+    std::pair<std::string, std::string> event = sim::pending_events.front();
+    sim::pending_events.pop_front();
+    for (auto& sub : sim::subscriptions) {
+      if (event.first.compare(0, sub.first.length(), sub.first) == 0) sub.second(event.first.c_str(), event.second.c_str());
+    }
+  }
+}
+
+void CloudClass::syncTime() {}
+
+particle::Future<bool> CloudClass::publish(const char* name, PublishFlags flags) {
+  return(publish(name, "", flags));
+}
+
+particle::Future<bool> CloudClass::publish(const char* name, const char* data, PublishFlags flags) {
+  if (!connected()) {
+    sim::stats.publishes_failed++;
+    return(particle::Future<bool>(sim::clock_us, false));
+  }
+  // device name request is answered by the cloud with a spark/device/name event
+  if (strcmp(name, "spark/device/name") == 0) {
+    sim::pending_events.push_back(std::make_pair(std::string(name), std::string(sim::device_name)));
+  }
+  if (sim::echo_publish) fprintf(stdout, "PUBLISH %s: %s\n", name, data);
+  sim::stats.publishes++;
+  sim::stats.publish_bytes += strlen(data);
+  unsigned long long done_at = sim::clock_us + (flags.has(WITH_ACK) ? 1000ULL * sim::publish_ack_ms : 0);
+  return(particle::Future<bool>(done_at, true));
+}
+
+bool CloudClass::variable(const char* name, const char* var) {
+  sim::variables[name] = var;
+  return(true);
+}
+
+bool CloudClass::function(const char* name, std::function<int(String)> fn) {
+  sim::functions[name] = fn;
+  return(true);
+}
+
+bool CloudClass::subscribe(const char* prefix, std::function<void(const char*, const char*)> handler, Spark_Subscription_Scope_TypeDef scope) {
+  sim::subscriptions.push_back(std::make_pair(std::string(prefix), handler));
+  return(true);
+}
+
+/*** system ***/
+
+uint32_t SystemClass::freeMemory() {
+  // small blocks + large (mmapped) blocks
+  struct mallinfo2 info = mallinfo2();
+  size_t used = info.uordblks + info.hblkhd - sim::heap_excluded;
+  if (sim::heap_baseline == 0) sim::heap_baseline = used;
+  long free = (long) sim::heap_size - ((long) used - (long) sim::heap_baseline);
+  return(free > 0 ? free : 0);
+}
+
+void SystemClass::reset(uint32_t data, int flags) {
+  sim::stats.resets++;
+}
+
+int SystemClass::resetReason() { return(RESET_REASON_NONE); }
+uint32_t SystemClass::resetReasonData() { return(0); }
+
+/*** time ***/
+
+time_t TimeClass::now() {
+  return(sim::epoch + (time_t) (sim::clock_us / 1000000ULL));
+}
+
+String TimeClass::format(time_t t, const char* format) {
+  // device time is always UTC
+  std::string pattern(format);
+  for (size_t pos = pattern.find("%Z"); pos != std::string::npos; pos = pattern.find("%Z", pos)) pattern.replace(pos, 2, "UTC");
+  struct tm calendar;
+  gmtime_r(&t, &calendar);
+  char buffer[100];
+  strftime(buffer, sizeof(buffer), pattern.c_str(), &calendar);
+  return(String(buffer));
+}
+
+/*** network ***/
+
+bool WiFiClass::ready() { return(sim::network); }
+
+byte* WiFiClass::macAddress(byte* mac) {
+  const byte sim_mac[6] = {0xe0, 0x0f, 0xce, 0x00, 0x00, 0x01};
+  memcpy(mac, sim_mac, sizeof(sim_mac));
+  return(mac);
+}
@@ -0,0 +1,406 @@
+/**
+ * Host stand-in for the Particle Device OS application API.
+ * Provides just enough of application.h (millis, Time, EEPROM, Particle, System, Serial, Serial1, Wire)
+ * for the logger modules to compile and run on Linux against a virtual clock.
+ * The virtual clock and the simulated peripherals are controlled through sim.h
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+#include <sys/types.h>
+#include <chrono>
+#include <string>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <algorithm>
+
+using namespace std::chrono_literals;
+
+/*** platform ***/
+
+#define PLATFORM_PHOTON 6
+#define PLATFORM_ARGON  12
+#define PLATFORM_BORON  13
+#ifndef PLATFORM_ID
+#define PLATFORM_ID PLATFORM_ARGON
+#endif
+
+#define SYSTEM_THREAD(mode)
+#define SYSTEM_MODE(mode)
+
+typedef uint8_t byte;
+typedef uint16_t pin_t;
+
+/*** timing (virtual clock) ***/
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+static long map(long value, long from_low, long from_high, long to_low, long to_high) {
+  return((value - from_low) * (to_high - to_low) / (from_high - from_low) + to_low);
+}
+
+// wiring helpers
+using std::min;
+using std::max;
+
+/*** pins ***/
+
+#define INPUT           0
+#define OUTPUT          1
+#define INPUT_PULLUP    2
+#define INPUT_PULLDOWN  3
+#define LOW             0
+#define HIGH            1
+
+const pin_t D0 = 0, D1 = 1, D2 = 2, D3 = 3, D4 = 4, D5 = 5, D6 = 6, D7 = 7, D8 = 8;
+const pin_t A0 = 19, A1 = 18, A2 = 17, A3 = 16, A4 = 15, A5 = 14;
+#define SIM_PIN_COUNT 20
+
+void pinMode(pin_t pin, uint8_t mode);
+void digitalWrite(pin_t pin, uint8_t value);
+int32_t digitalRead(pin_t pin);
+
+/*** String ***/
+
+class String {
+
+  private:
+
+    std::string s;
+
+  public:
+
+    String() {}
+    String(const char* c) : s(c ? c : "") {}
+    String(const std::string& str) : s(str) {}
+
+    const char* c_str() const { return(s.c_str()); }
+    unsigned int length() const { return(s.length()); }
+    bool equals(const char* c) const { return(s == c); }
+
+    void toCharArray(char* buf, unsigned int size, unsigned int index = 0) const {
+      if (buf == 0 || size == 0) return;
+      size_t n = (index < s.length()) ? s.length() - index : 0;
+      if (n > size - 1) n = size - 1;
+      if (n > 0) memcpy(buf, s.c_str() + index, n);
+      buf[n] = 0;
+    }
+
+};
+
+/*** print & stream ***/
+
+class Print {
+
+  public:
+
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+      size_t n = 0;
+      while (size--) n += write(*buffer++);
+      return(n);
+    }
+    size_t write(const char* str) { return(str ? write((const uint8_t*) str, strlen(str)) : 0); }
+
+    size_t print(const char* str) { return(write(str)); }
+    size_t print(const String& str) { return(write(str.c_str())); }
+    size_t print(char c) { return(write((uint8_t) c)); }
+    size_t print(int n) { return(printf("%d", n)); }
+    size_t print(unsigned int n) { return(printf("%u", n)); }
+    size_t print(long n) { return(printf("%ld", n)); }
+    size_t print(unsigned long n) { return(printf("%lu", n)); }
+    size_t print(double n, int digits = 2) { return(printf("%.*f", digits, n)); }
+
+    size_t println() { return(write("\r\n")); }
+    template <typename T> size_t println(T value) { size_t n = print(value); return(n + println()); }
+
+    size_t printf(const char* format, ...);
+    size_t printlnf(const char* format, ...);
+    size_t vprintf(bool newline, const char* format, va_list args);
+
+};
+
+class Stream : public Print {
+
+  public:
+
+    virtual int available() { return(0); }
+    virtual int read() { return(-1); }
+    virtual int peek() { return(-1); }
+    virtual void flush() {}
+
+};
+
+// USB serial (console) - output is echoed to stdout if the simulation asks for it
+class USBSerial : public Stream {
+
+  public:
+
+    void begin(long baud = 9600) {}
+    bool isConnected() { return(true); }
+    operator bool() { return(true); }
+    virtual size_t write(uint8_t c);
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    virtual int available();
+    virtual int read();
+    virtual int peek();
+
+};
+
+// hardware serial - bytes written are handed to the simulated device attached to the port
+#define SERIAL_8N1 0
+class USARTSerial : public Stream {
+
+  private:
+
+    std::deque<uint8_t> rx;
+
+  public:
+
+    void begin(unsigned long baud, uint32_t config = SERIAL_8N1) {}
+    void end() {}
+    virtual size_t write(uint8_t c);
+    virtual int available() { return(rx.size()); }
+    virtual int read();
+    virtual int peek() { return(rx.empty() ? -1 : rx.front()); }
+    void inject(const char* data);
+
+};
+
+/*** i2c & spi ***/
+
+class TwoWire : public Stream {
+
+  private:
+
+    uint8_t tx_address = 0;
+    size_t tx_bytes = 0;
+
+  public:
+
+    void begin() {}
+    void setSpeed(uint32_t speed) {}
+    void stretchClock(bool stretch) {}
+    void beginTransmission(uint8_t address) { tx_address = address; tx_bytes = 0; }
+    uint8_t endTransmission(bool stop = true);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t stop = true);
+    virtual size_t write(uint8_t c) { tx_bytes++; return(1); }
+
+};
+
+class SPIClass {
+
+  public:
+
+    void begin() {}
+    uint8_t transfer(uint8_t data) { return(0); }
+
+};
+
+/*** EEPROM ***/
+
+class EEPROMClass {
+
+  public:
+
+    static const size_t EEPROM_SIZE = 4096; // argon emulated EEPROM
+
+    size_t length() { return(EEPROM_SIZE); }
+    uint8_t read(int address);
+    void write(int address, uint8_t value);
+    void update(int address, uint8_t value) { write(address, value); }
+
+    template <typename T> T& get(int address, T& t) {
+      for (size_t i = 0; i < sizeof(T); i++) ((uint8_t*) &t)[i] = read(address + i);
+      return(t);
+    }
+
+    template <typename T> const T& put(int address, const T& t) {
+      // only changed bytes are actually written (same as the device implementation)
+      for (size_t i = 0; i < sizeof(T); i++) write(address + i, ((const uint8_t*) &t)[i]);
+      return(t);
+    }
+
+};
+
+/*** cloud ***/
+
+class PublishFlags {
+
+  private:
+
+    uint8_t flags;
+
+  public:
+
+    constexpr explicit PublishFlags(uint8_t flags) : flags(flags) {}
+    constexpr PublishFlags operator|(PublishFlags other) const { return(PublishFlags(flags | other.flags)); }
+    constexpr bool has(PublishFlags other) const { return((flags & other.flags) == other.flags); }
+
+};
+
+constexpr PublishFlags PUBLIC(0x00);
+constexpr PublishFlags PRIVATE(0x01);
+constexpr PublishFlags NO_ACK(0x02);
+constexpr PublishFlags WITH_ACK(0x08);
+
+enum Spark_Subscription_Scope_TypeDef { MY_DEVICES, ALL_DEVICES };
+
+namespace particle {
+
+  // result of an asynchronous cloud operation that completes at a point in virtual time
+  template <typename T> class Future {
+
+    private:
+
+      struct Outcome {
+        unsigned long long done_at; // virtual time of completion (in us)
+        T value;
+      };
+      std::shared_ptr<Outcome> outcome;
+
+    public:
+
+      Future() : outcome(std::make_shared<Outcome>(Outcome{0, T()})) {}
+      Future(unsigned long long done_at, T value) : outcome(std::make_shared<Outcome>(Outcome{done_at, value})) {}
+
+      bool isDone() const;
+      bool isSucceeded() const { return(isDone() && outcome->value); }
+      bool isFailed() const { return(isDone() && !outcome->value); }
+      Future<T>& wait();
+      bool cancel() { if (isDone()) return(false); outcome->done_at = 0; outcome->value = T(); return(true); }
+      T result() { wait(); return(outcome->value); }
+      operator T() { return(result()); }
+
+  };
+
+}
+
+class CloudClass {
+
+  public:
+
+    void connect();
+    void disconnect();
+    bool connected();
+    void process();
+    void syncTime();
+
+    particle::Future<bool> publish(const char* name, PublishFlags flags = PUBLIC);
+    particle::Future<bool> publish(const char* name, const char* data, PublishFlags flags = PUBLIC);
+
+    bool variable(const char* name, const char* var);
+    bool function(const char* name, std::function<int(String)> fn);
+    template <typename T> bool function(const char* name, int (T::*fn)(String), T* instance) {
+      return(function(name, [=](String arg) { return((instance->*fn)(arg)); }));
+    }
+
+    bool subscribe(const char* prefix, std::function<void(const char*, const char*)> handler, Spark_Subscription_Scope_TypeDef scope = ALL_DEVICES);
+    template <typename T> bool subscribe(const char* prefix, void (T::*handler)(const char*, const char*), T* instance, Spark_Subscription_Scope_TypeDef scope = ALL_DEVICES) {
+      return(subscribe(prefix, [=](const char* topic, const char* data) { (instance->*handler)(topic, data); }, scope));
+    }
+
+};
+
+/*** system ***/
+
+#define RESET_NO_WAIT       1
+#define RESET_REASON_NONE   0
+#define RESET_REASON_USER   140
+#define FEATURE_RESET_INFO  1
+
+class SystemClass {
+
+  public:
+
+    uint32_t freeMemory();
+    void reset(uint32_t data = 0, int flags = 0);
+    int resetReason();
+    uint32_t resetReasonData();
+    void enableFeature(int feature) {}
+
+};
+
+class ApplicationWatchdog {
+
+  public:
+
+    ApplicationWatchdog(std::chrono::milliseconds timeout, void (*fn)(), size_t stack_size = 512) {}
+    void checkin() {}
+
+};
+
+/*** time ***/
+
+class TimeClass {
+
+  public:
+
+    time_t now();
+    bool isValid() { return(true); }
+    void zone(float tz) {}
+    String format(time_t t, const char* format);
+
+};
+
+/*** network ***/
+
+class IPAddress {
+
+  public:
+
+    String toString() { return(String("10.0.0.2")); }
+
+};
+
+class WiFiClass {
+
+  public:
+
+    void on() {}
+    void off() {}
+    bool ready();
+    byte* macAddress(byte* mac);
+    IPAddress localIP() { return(IPAddress()); }
+
+};
+
+/*** globals ***/
+
+extern USBSerial Serial;
+extern USARTSerial Serial1;
+extern TwoWire Wire;
+extern SPIClass SPI;
+extern EEPROMClass EEPROM;
+extern CloudClass Particle;
+extern SystemClass System;
+extern TimeClass Time;
+extern WiFiClass WiFi;
+
+/*** future implementation (needs the virtual clock) ***/
+
+namespace sim { unsigned long long now_us(); void advanceMicros(unsigned long long us); }
+
+template <typename T> bool particle::Future<T>::isDone() const {
+  return(sim::now_us() >= outcome->done_at);
+}
+
+template <typename T> particle::Future<T>& particle::Future<T>::wait() {
+  // blocking wait: the virtual clock moves forward until the operation completes
+  if (!isDone()) sim::advanceMicros(outcome->done_at - sim::now_us());
+  return(*this);
+}
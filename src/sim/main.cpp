@@ -0,0 +1,271 @@
+/**
+ * Host simulation of a logger program (setup/loop) against the virtual clock.
+ * Runs the loop latency benchmark: per-pass cost of loop() (i.e. LoggerController::update()
+ * plus the program's own loop work) at idle, during data logging and while draining a publish backlog.
+ *
+ * usage: sim-<program> [-v] [-p] [--ack ms] [--tick ms] [--storage dir] [--eeprom file] [--sd json|binary] [--console | --power-loss | --resume | --drain n]
+ *  -v            echo USB serial output
+ *  -p            echo published events
+ *  --ack         publish acknowledgement round trip in ms (default 500)
+ *  --tick        virtual time between loop passes in ms (default 10)
+ *  --storage     keep SD card and EEPROM contents in this directory (default: fresh temporary directory)
+ *  --eeprom      boot with this EEPROM image (e.g. one saved by older firmware, to check that its states are restored)
+ *  --sd          also log to the SD card in this format (e.g. to compare sd-decode of the binary logs with the published ones)
+ *  --console     only boot and run console commands from stdin in real time until stdin is closed
+ *                (e.g. printf "power on\nget state\n" | sim-swiss --console), prints the USB serial output
+ *  --power-loss  stop at the end of the cloud outage (simulated power loss)
+ *  --resume      only boot and drain the backlog (e.g. after --power-loss with the same --storage)
+ *  --drain       drain time of a backlog of n logs, publishing one log per event vs. batches of logs
+ */
+
+#include "application.h"
+#include "sim.h"
+#include "LoggerController.h"
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+
+// program entry points
+void setup();
+void loop();
+extern LoggerController* controller;
+
+/*** valco valve model (Serial1) ***/
+
+static std::string valco_cmd;
+static int valco_pos = 1;
+
+static void valco(uint8_t b) {
+  if (b != '\r') {
+    valco_cmd.push_back((char) b);
+    return;
+  }
+  if (valco_cmd == "CP") {
+    char reply[10];
+    snprintf(reply, sizeof(reply), "CP%d\r", valco_pos);
+    Serial1.inject(reply);
+  } else if (valco_cmd.compare(0, 2, "CW") == 0 || valco_cmd.compare(0, 2, "CC") == 0) {
+    valco_pos = atoi(valco_cmd.c_str() + 2);
+  }
+  valco_cmd.clear();
+}
+
+/*** benchmark ***/
+
+static unsigned long tick_ms = 10;
+
+struct Scenario {
+
+  const char* name;
+  std::vector<double> cpu_us; // host cpu time per pass
+  std::vector<double> loop_ms; // virtual time per pass (includes blocking i2c, delays and publishes)
+  unsigned long publishes = 0;
+  unsigned long i2c_transactions = 0;
+  double duration_s = 0;
+
+  Scenario(const char* name) : name(name) {}
+
+};
+
+// benchmark samples live on the host heap, keep them out of the device memory accounting
+static void record(std::vector<double>& samples, double value) {
+  size_t capacity = samples.capacity();
+  samples.push_back(value);
+  sim::heap_excluded += (long) ((samples.capacity() - capacity) * sizeof(double));
+}
+
+static void pass(Scenario* scenario) {
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  unsigned long long v0 = sim::now_us();
+  loop();
+  std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+  if (scenario) {
+    record(scenario->cpu_us, std::chrono::duration<double, std::micro>(t1 - t0).count());
+    record(scenario->loop_ms, (sim::now_us() - v0) / 1000.);
+  }
+  sim::advance(tick_ms);
+}
+
+// run loop passes until the condition is met or the virtual time limit (in s) is reached
+static void run(Scenario* scenario, double limit_s, std::function<bool()> done = 0) {
+  unsigned long long start = sim::now_us();
+  unsigned long publishes = sim::stats.publishes;
+  unsigned long i2c_transactions = sim::stats.i2c_transactions;
+  while (sim::now_us() - start < limit_s * 1e6 && !(done && done())) pass(scenario);
+  if (scenario) {
+    scenario->publishes += sim::stats.publishes - publishes;
+    scenario->i2c_transactions += sim::stats.i2c_transactions - i2c_transactions;
+    scenario->duration_s += (sim::now_us() - start) / 1e6;
+  }
+}
+
+static void command(const char* cmd) {
+  int ret = sim::callFunction(CMD_ROOT, cmd);
+  printf("INFO: command '%s' returned %d\n", cmd, ret);
+}
+
+// read a numeric field from the state variable
+static int stateField(const char* key) {
+  const char* state = sim::getVariable(STATE_INFO_VARIABLE);
+  const char* field = state ? strstr(state, key) : 0;
+  return(field ? atoi(field + strlen(key)) : -1);
+}
+
+static bool logQueuesEmpty() {
+  return(stateField("\"sls\":") == 0 && stateField("\"dls\":") == 0 && stateField("\"sps\":") == 0);
+}
+
+static int backlogSize() {
+  return(stateField("\"sls\":") + stateField("\"dls\":") + stateField("\"sps\":"));
+}
+
+static void reportQueues(const char* when) {
+  printf("INFO: %s: %d state and %d data logs queued (oldest %d s), %d spooled, %d data logs dropped\n", when,
+    stateField("\"sls\":"), stateField("\"dls\":"), stateField("\"dla\":"), stateField("\"sps\":"), stateField("\"dld\":"));
+}
+
+static double percentile(std::vector<double> values, double p) {
+  if (values.empty()) return(0);
+  std::sort(values.begin(), values.end());
+  size_t i = (size_t) (p * values.size());
+  return(values[i < values.size() ? i : values.size() - 1]);
+}
+
+static void report(std::vector<Scenario*> scenarios) {
+  printf("\nloop latency per pass (virtual tick %lu ms, publish ack %lu ms)\n", tick_ms, sim::publish_ack_ms);
+  printf("%-10s %8s %8s | %9s %9s %9s %9s | %9s %9s %9s | %9s %9s\n",
+    "scenario", "passes", "time[s]", "cpu p50", "cpu p90", "cpu p99", "cpu max", "loop p50", "loop p99", "loop max", "publishes", "i2c tx");
+  printf("%-10s %8s %8s | %9s %9s %9s %9s | %9s %9s %9s | %9s %9s\n",
+    "", "", "", "[us]", "[us]", "[us]", "[us]", "[ms]", "[ms]", "[ms]", "", "");
+  for (Scenario* s : scenarios) {
+    printf("%-10s %8zu %8.0f | %9.1f %9.1f %9.1f %9.1f | %9.2f %9.2f %9.2f | %9lu %9lu\n",
+      s->name, s->cpu_us.size(), s->duration_s,
+      percentile(s->cpu_us, 0.5), percentile(s->cpu_us, 0.9), percentile(s->cpu_us, 0.99), percentile(s->cpu_us, 1.0),
+      percentile(s->loop_ms, 0.5), percentile(s->loop_ms, 0.99), percentile(s->loop_ms, 1.0),
+      s->publishes, s->i2c_transactions);
+  }
+  printf("\nfree memory at the end: %lu bytes\n", (unsigned long) System.freeMemory());
+}
+
+int main(int argc, char** argv) {
+
+  // device time is always UTC
+  setenv("TZ", "UTC", 1);
+  tzset();
+
+  // options
+  bool power_loss = false, resume = false, console = false;
+  const char* sd_format = 0;
+  const char* eeprom_image = 0;
+  int drain = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-v") == 0) sim::echo_serial = true;
+    else if (strcmp(argv[i], "-p") == 0) sim::echo_publish = true;
+    else if (strcmp(argv[i], "--ack") == 0 && i + 1 < argc) sim::publish_ack_ms = atol(argv[++i]);
+    else if (strcmp(argv[i], "--tick") == 0 && i + 1 < argc) tick_ms = atol(argv[++i]);
+    else if (strcmp(argv[i], "--storage") == 0 && i + 1 < argc) sim::setStorage(argv[++i]);
+    else if (strcmp(argv[i], "--eeprom") == 0 && i + 1 < argc) eeprom_image = argv[++i];
+    else if (strcmp(argv[i], "--sd") == 0 && i + 1 < argc) sd_format = argv[++i];
+    else if (strcmp(argv[i], "--console") == 0) console = true;
+    else if (strcmp(argv[i], "--power-loss") == 0) power_loss = true;
+    else if (strcmp(argv[i], "--resume") == 0) resume = true;
+    else if (strcmp(argv[i], "--drain") == 0 && i + 1 < argc) drain = atoi(argv[++i]);
+    else {
+      fprintf(stderr, "usage: %s [-v] [-p] [--ack ms] [--tick ms] [--storage dir] [--eeprom file] [--sd json|binary] [--console | --power-loss | --resume | --drain n]\n", argv[0]);
+      return(1);
+    }
+  }
+
+  // peripherals
+  sim::device_name = "sim";
+  sim::serial1_device = valco;
+
+  // boot
+  if (eeprom_image && !sim::loadEEPROM(eeprom_image)) return(1);
+  Scenario startup("startup"), idle("idle"), logging("logging"), offline("offline"), backlog("backlog");
+  setup();
+  run(&startup, 60, [] { return(controller->isStartupComplete()); });
+  run(&startup, 10); // let the startup logs go out
+
+  // sd card logging
+  if (sd_format) {
+    command("sd-log on");
+    command((std::string("sd-format ") + sd_format).c_str());
+  }
+
+  // local console: loop in real time (so typed commands are answered right away) until stdin is closed
+  if (console) {
+    sim::echo_serial = true;
+    sim::console_input = true;
+    while (!sim::isConsoleDone()) {
+      pass(0);
+      usleep(tick_ms * 1000);
+    }
+    run(0, 1); // last command's output
+    return(0);
+  }
+
+  // resume after a power loss
+  if (resume) {
+    reportQueues("after reboot");
+    run(&backlog, 4 * 60 * 60, logQueuesEmpty);
+    reportQueues("after backlog");
+    report({&startup, &backlog});
+    return(0);
+  }
+
+  // backlog drain time without and with log batching
+  if (drain > 0) {
+    Scenario single("single"), batch("batch");
+    command("state-log on");
+    command("read-period 2 s");
+    for (Scenario* scenario : {&single, &batch}) {
+      command(scenario == &single ? "log-batch off" : "log-batch on");
+      // build up the backlog quickly during an outage
+      sim::setNetwork(false);
+      command("log-period 5 s");
+      command("data-log on");
+      run(0, 24 * 60 * 60, [drain] { return(backlogSize() >= drain); });
+      reportQueues(scenario->name);
+      // drain at the regular logging rate
+      command("log-period 1 m");
+      sim::setNetwork(true);
+      run(scenario, 24 * 60 * 60, logQueuesEmpty);
+    }
+    printf("\ndrain time for a backlog of %d logs (publish ack %lu ms):\n", drain, sim::publish_ack_ms);
+    for (Scenario* scenario : {&single, &batch}) {
+      printf("  %-8s %8.0f s, %6lu publishes\n", scenario->name, scenario->duration_s, scenario->publishes);
+    }
+    printf("  speedup  %8.1fx\n", single.duration_s / batch.duration_s);
+    report({&startup, &single, &batch});
+    return(0);
+  }
+
+  // idle
+  run(&idle, 120);
+
+  // state and data logging (every component logs once a minute)
+  command("state-log on");
+  command("read-period 10 s");
+  command("log-period 1 m");
+  command("data-log on");
+  run(&logging, 15 * 60);
+
+  // cloud outage builds up a backlog
+  sim::setNetwork(false);
+  run(&offline, 60 * 60);
+  reportQueues("after outage");
+  if (power_loss) {
+    printf("INFO: power loss (SD card and EEPROM kept in %s/..)\n", sim::sdDirectory().c_str());
+    return(0);
+  }
+
+  // backlog drain
+  sim::setNetwork(true);
+  run(&backlog, 4 * 60 * 60, logQueuesEmpty);
+  reportQueues("after backlog");
+  if (sd_format) command("sd-flush");
+
+  report({&startup, &idle, &logging, &offline, &backlog});
+  return(0);
+}
@@ -0,0 +1,126 @@
+// scheduler event actions: the swiss events run from an action table (one batch per event) vs. the previous hand-written
+// runEvent (kept here as the reference): same component states after every event, and the EEPROM bytes written,
+// data logs and data variable updates per schedule run
+
+#include "micro.h"
+#include "fixture.h"
+
+// previous scheduler: each event's actions called directly
+class ReferenceScheduler : public SchedulerLoggerComponent {
+
+  SwissUnit* unit;
+
+  public:
+
+    ReferenceScheduler(SwissUnit* unit) : SchedulerLoggerComponent("s1", unit->controller, new SchedulerState(), SCHEDULER_DT_PATTERN_YMD_24HM, swiss_schedule, SWISS_EVENTS), unit(unit) {}
+
+    void runEvent(uint8_t event) {
+      RelayLoggerComponent *rpower = unit->rpower, *rbypass = unit->rbypass, *r25cm = unit->r25cm, *r50cm = unit->r50cm, *r75cm = unit->r75cm;
+      ValveLoggerComponent* valco = unit->valco;
+      if (event == EVENT_START) {
+        rpower->changeRelay(true); rbypass->changeRelay(false); r25cm->changeRelay(false); r50cm->changeRelay(false); r75cm->changeRelay(false);
+        valco->changeDirection(VALVE_DIR_CW); valco->changePosition(1);
+        ctrl->pauseStateSaving();
+      } else if (event == EVENT_CLEAN) {
+        rbypass->changeRelay(true);
+      } else if (event == EVENT_CLEAN25CM) {
+        rbypass->changeRelay(false); r25cm->changeRelay(true);
+      } else if (event == EVENT_START_25CM) {
+        valco->changeDirection(VALVE_DIR_CC); valco->changePosition(2);
+      } else if (event == EVENT_END_25CM) {
+        valco->changeDirection(VALVE_DIR_CW); valco->changePosition(1); r25cm->changeRelay(false);
+        ctrl->resumeStateSaving();
+      } else if (event == EVENT_CLEAN50CM) {
+        ctrl->pauseStateSaving();
+        valco->changePosition(1); r50cm->changeRelay(true);
+      } else if (event == EVENT_START_50CM) {
+        valco->changeDirection(VALVE_DIR_CC); valco->changePosition(3);
+      } else if (event == EVENT_END_50CM) {
+        valco->changeDirection(VALVE_DIR_CW); valco->changePosition(1); r50cm->changeRelay(false);
+        ctrl->resumeStateSaving();
+      } else if (event == EVENT_CLEAN75CM) {
+        ctrl->pauseStateSaving();
+        valco->changeDirection(VALVE_DIR_CW); valco->changePosition(1); r75cm->changeRelay(true);
+      } else if (event == EVENT_START_75CM) {
+        valco->changeDirection(VALVE_DIR_CC); valco->changePosition(4);
+      } else if (event == EVENT_END_75CM) {
+        valco->changeDirection(VALVE_DIR_CW); valco->changePosition(1); r75cm->changeRelay(false);
+        ctrl->resumeStateSaving();
+      } else if (event == EVENT_END_CLEAN) {
+        ctrl->pauseStateSaving();
+        valco->changeDirection(VALVE_DIR_CW); valco->changePosition(1); rbypass->changeRelay(true);
+      } else if (event == EVENT_END) {
+        rbypass->changeRelay(false); rpower->changeRelay(false);
+        ctrl->resumeStateSaving();
+      }
+    }
+
+};
+
+struct ActionsRun {
+  unsigned long eeprom_bytes, data_logs, data_entries, data_variable_updates;
+  std::vector<std::string> states; // after each event
+};
+
+// all events of the schedule (on a fresh EEPROM, valve away from home turning cc and all relays on)
+static ActionsRun run(SwissUnit* unit, SchedulerLoggerComponent* scheduler) {
+  sim::loadEEPROM(0);
+  unit->add(scheduler);
+  unit->valco->state->pos = 9;
+  unit->valco->state->cw = false;
+  for (RelayLoggerComponent* relay : {unit->rpower, unit->rbypass, unit->r25cm, unit->r50cm, unit->r75cm}) relay->state->on = true;
+  DataCountingController* controller = unit->controller;
+  ActionsRun result;
+  unsigned long eeprom_writes = sim::stats.eeprom_writes;
+  char states[30];
+  for (uint8_t i = 0; i < SWISS_EVENTS; i++) {
+    scheduler->runEvent(swiss_schedule[i].event);
+    unit->getStates(states, sizeof(states));
+    result.states.push_back(states);
+    sim::advance(1000);
+  }
+  result.eeprom_bytes = sim::stats.eeprom_writes - eeprom_writes;
+  result.data_logs = controller->data_logs;
+  result.data_entries = controller->data_entries;
+  result.data_variable_updates = controller->data_variable_updates;
+  return(result);
+}
+
+static micro::Benchmark actions_benchmark("actions", [] {
+
+  SwissUnit reference_unit, table_unit;
+  ActionsRun reference = run(&reference_unit, new ReferenceScheduler(&reference_unit));
+  ActionsRun table = run(&table_unit, new SchedulerLoggerComponent("s1", table_unit.controller, new SchedulerState(), SCHEDULER_DT_PATTERN_YMD_24HM, swiss_schedule, SWISS_EVENTS, swiss_actions, SWISS_EVENTS));
+  SchedulerLoggerComponent* scheduler = table_unit.scheduler;
+
+  int mismatches = 0;
+  for (uint8_t i = 0; i < SWISS_EVENTS; i++) if (reference.states[i] != table.states[i]) mismatches++;
+  printf("  %d events: %d state mismatches (final states %s / %s)\n", (int) SWISS_EVENTS, mismatches, reference.states.back().c_str(), table.states.back().c_str());
+  micro::check(mismatches == 0, "actions: same states as direct calls");
+  micro::check(table.eeprom_bytes <= reference.eeprom_bytes && table.data_logs < reference.data_logs &&
+    table.data_entries == reference.data_entries, "actions: fewer saves and data logs, same data");
+  printf("  %-24s %8s %10s %12s %12s\n", "", "EEPROM", "data logs", "data entries", "data var");
+  printf("  %-24s %8lu %10lu %12lu %12lu\n", "direct calls:", reference.eeprom_bytes, reference.data_logs, reference.data_entries, reference.data_variable_updates);
+  printf("  %-24s %8lu %10lu %12lu %12lu\n", "action table:", table.eeprom_bytes, table.data_logs, table.data_entries, table.data_variable_updates);
+  printf("  unknown event code 99 valid: %s, event 13 valid: %s\n", scheduler->isValidEvent(99) ? "YES" : "no", scheduler->isValidEvent(EVENT_END_CLEAN) ? "yes" : "NO");
+  micro::check(!scheduler->isValidEvent(99) && scheduler->isValidEvent(EVENT_END_CLEAN), "actions: valid event codes");
+
+  // pause while already paused (e.g. an event that pauses run twice): resume goes back to saving
+  // (state logs on: the state variable is updated after each command)
+  DataCountingController* ctrl = table_unit.controller;
+  ctrl->receiveCommand("state-log on");
+  ctrl->receiveCommand("save-state on");
+  bool on_shown = strstr(ctrl->getStateVariable(), "\"k\":\"save-state\",\"v\":\"on\"") != 0;
+  int pause_ret = ctrl->receiveCommand("save-state pause");
+  bool paused_shown = strstr(ctrl->getStateVariable(), "\"k\":\"save-state\",\"v\":\"off\"") != 0;
+  printf("  state variable before/after 'save-state pause': save-state %s/%s\n", on_shown ? "on" : "NOT on", paused_shown ? "off" : "NOT off");
+  micro::check(on_shown && paused_shown, "actions: pause shown in the state variable");
+  int repeat_ret = ctrl->receiveCommand("save-state pause");
+  int resume_ret = ctrl->receiveCommand("save-state resume");
+  printf("  'save-state pause' twice + 'resume': return codes %d, %d, %d, saving %s\n", pause_ret, repeat_ret, resume_ret, ctrl->state->save_state ? "on" : "OFF");
+  micro::check(ctrl->state->save_state && ctrl->receiveCommand("save-state resume") == CMD_RET_WARN_NO_CHANGE, "actions: nested pause resumed");
+
+  // cost of an event's actions (parsed and dispatched like commands)
+  micro::measure("event actions (7 commands + pause)", [&] { scheduler->runEvent(EVENT_START); table_unit.controller->resumeStateSaving(); });
+  sim::loadEEPROM(0);
+});
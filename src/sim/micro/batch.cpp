@@ -0,0 +1,106 @@
+// command batches: a unit reconfigured with one batch vs. one command at a time (same states, state logs and state
+// variable updates per call), the packed return codes of batches with warnings, errors and a locked logger
+
+#include "micro.h"
+#include "sim.h"
+#include "LoggerController.h"
+#include "LoggerDisplay.h"
+#include "RelayLoggerComponent.h"
+#include "ValveLoggerComponent.h"
+
+// reconfiguration of a unit (same as the commands of the batch)
+static const char* commands[] = {"power on", "bypass off", "valco pos 3", "log-period 5 m", "state-log on"};
+#define BATCH "power on;bypass off;valco pos 3;log-period 5 m;state-log on"
+
+// controller that counts its state logs and state variable updates
+class CountingController : public LoggerController {
+
+  public:
+
+    unsigned long state_logs = 0;
+    unsigned long state_variable_updates = 0;
+    char last_state_log[STATE_LOG_MAX_CHAR];
+
+    CountingController() : LoggerController("micro", A0, new LoggerControllerState(false, -6, false, false, false, 60, LOG_BY_TIME, 200, 10000), false) {}
+
+    void queueStateLog(bool log_always = false) {
+      state_logs++;
+      strcpy(last_state_log, state_log);
+      LoggerController::queueStateLog(log_always);
+    }
+
+    void updateStateVariable() {
+      state_variable_updates++;
+      LoggerController::updateStateVariable();
+    }
+
+};
+
+static CountingController* build() {
+  CountingController* controller = new CountingController();
+  controller->setDisplay(new LoggerDisplay(controller, 16, 2, 2));
+  controller->addComponent(new ValveLoggerComponent("valco", controller, new ValveState(), 9600, SERIAL_8N1, 16));
+  controller->addComponent(new RelayLoggerComponent("power", controller, false, D2, RELAY_NORMALLY_OPEN));
+  controller->addComponent(new RelayLoggerComponent("bypass", controller, true, D3, RELAY_NORMALLY_OPEN));
+  return(controller);
+}
+
+static bool same(CountingController* a, CountingController* b) {
+  return(a->state->data_logging_period == b->state->data_logging_period && a->state->state_logging == b->state->state_logging &&
+    ((RelayLoggerComponent*) a->components[1])->state->on == ((RelayLoggerComponent*) b->components[1])->state->on &&
+    ((RelayLoggerComponent*) a->components[2])->state->on == ((RelayLoggerComponent*) b->components[2])->state->on &&
+    ((ValveLoggerComponent*) a->components[0])->state->pos == ((ValveLoggerComponent*) b->components[0])->state->pos);
+}
+
+// status of command i in a batch return code
+static int status(int ret_val, int i) {
+  return((abs(ret_val) >> (i * CMD_BATCH_RET_BITS)) & 3);
+}
+
+static micro::Benchmark batch("batch", [] {
+
+  sim::loadEEPROM(0);
+  CountingController* single = build();
+  CountingController* batched = build();
+
+  // same states, fewer state logs
+  single->state_variable_updates = batched->state_variable_updates = 0;
+  for (const char* text : commands) single->receiveCommand(text);
+  int ret_val = batched->receiveCommand(BATCH);
+  printf("  %d commands: same states: %s, %lu vs. %lu state logs, %lu vs. %lu state variable updates (incl. 2 for the relays' data logs), return code %d\n",
+    (int) (sizeof(commands) / sizeof(commands[0])), same(single, batched) ? "yes" : "NO",
+    single->state_logs, batched->state_logs, single->state_variable_updates, batched->state_variable_updates, ret_val);
+  micro::check(same(single, batched) && ret_val == CMD_RET_SUCCESS && batched->state_logs == 1, "batch: same states, one state log");
+  printf("  state log: %s\n", batched->last_state_log);
+
+  // warnings and errors: 2nd command unchanged (warning), 3rd invalid (error)
+  ret_val = batched->receiveCommand("power off; power off ;power maybe;;");
+  printf("  'power off; power off ;power maybe;;': return code %d (statuses %d %d %d)\n",
+    ret_val, status(ret_val, 0), status(ret_val, 1), status(ret_val, 2));
+  micro::check(ret_val < 0 && status(ret_val, 0) == CMD_BATCH_RET_SUCCESS && status(ret_val, 1) == CMD_BATCH_RET_WARNING &&
+    status(ret_val, 2) == CMD_BATCH_RET_ERROR, "batch: statuses of each command");
+
+  // locked: none of the commands run, a lock in the batch applies after it
+  batched->receiveCommand("lock on;power on");
+  bool power_on = ((RelayLoggerComponent*) batched->components[1])->state->on;
+  ret_val = batched->receiveCommand("lock off;power off");
+  printf("  'lock on;power on': power %s, then 'lock off;power off' while locked: return code %d, power %s, %s\n",
+    power_on ? "on" : "OFF", ret_val, ((RelayLoggerComponent*) batched->components[1])->state->on ? "on" : "OFF",
+    batched->state->locked ? "still locked" : "UNLOCKED");
+  micro::check(power_on && ((RelayLoggerComponent*) batched->components[1])->state->on && batched->state->locked, "batch: locked batch not run");
+  batched->receiveCommand("lock off");
+
+  // too many commands
+  ret_val = batched->receiveCommand("tz 1;tz 1;tz 1;tz 1;tz 1;tz 1;tz 1;tz 1;tz 1;x;x;x;x;x;x;x");
+  printf("  16 commands: return code %d (none run, tz still %d)\n", ret_val, batched->state->tz);
+  micro::check(ret_val < 0 && batched->state->tz == -6, "batch: too many commands, none run");
+
+  // cost on the device (besides the cloud round trips)
+  micro::measure("one command at a time", [&] {
+    for (const char* text : commands) micro::keep(single->receiveCommand(text));
+  });
+  micro::measure("batch", [&] {
+    micro::keep(batched->receiveCommand(BATCH));
+  });
+  sim::loadEEPROM(0);
+});
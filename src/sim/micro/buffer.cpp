@@ -0,0 +1,60 @@
+// data log assembly: self-referential snprintf (previous LoggerController::addToDataLogBuffer) vs. LoggerBuffer
+
+#include "micro.h"
+#include "LoggerBuffer.h"
+
+#define DATA_LOG_MAX_CHAR 621
+#define RESERVE 50
+
+static const char* item = "{\"i\":2,\"k\":\"relay\",\"v\":0,\"u\":\"power\",\"n\":1,\"to\":0}";
+static char data_log[DATA_LOG_MAX_CHAR];
+static char data_log_buffer[DATA_LOG_MAX_CHAR-10];
+
+// previous implementation (rescans and recopies the buffer on every append, source & target overlap)
+// note: the overlap is undefined behaviour and glibc's snprintf drops the existing content, so the number of
+// appends is fixed to what fits into a full data log rather than relying on the size check (and its warning is off)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wrestrict"
+static bool addWithSnprintf(const char* info) {
+  if (strlen(data_log_buffer) + strlen(info) + RESERVE >= sizeof(data_log)) return(false);
+  if (data_log_buffer[0] == 0) {
+    strncpy(data_log_buffer, info, sizeof(data_log_buffer));
+  } else {
+    snprintf(data_log_buffer, sizeof(data_log_buffer), "%s,%s", data_log_buffer, info);
+  }
+  return(true);
+}
+#pragma GCC diagnostic pop
+
+static size_t items = 0; // how many items fit into a full data log
+
+static void assembleWithSnprintf() {
+  data_log_buffer[0] = 0;
+  for (size_t i = 0; i < items; i++) addWithSnprintf(item);
+  snprintf(data_log, sizeof(data_log), "{\"id\":\"%s\",\"dt\":\"%s\",\"d\":[%s]}", "swiss", "2022-07-01 00:00:00 UTC", data_log_buffer);
+  micro::keep(data_log[0]);
+}
+
+static LoggerBuffer data_log_builder(data_log_buffer);
+
+static bool addWithBuilder(const char* info) {
+  if (data_log_builder.length() + strlen(info) + RESERVE >= sizeof(data_log)) return(false);
+  return(data_log_builder.addItem(info));
+}
+
+static void assembleWithBuilder() {
+  data_log_builder.reset();
+  while (addWithBuilder(item));
+  snprintf(data_log, sizeof(data_log), "{\"id\":\"%s\",\"dt\":\"%s\",\"d\":[%s]}", "swiss", "2022-07-01 00:00:00 UTC", data_log_builder.c_str());
+  micro::keep(data_log[0]);
+}
+
+static micro::Benchmark buffer("buffer", [] {
+  assembleWithBuilder();
+  items = (data_log_builder.length() + 1) / (strlen(item) + 1);
+  printf("  full data log: %zu bytes, %zu data entries\n", strlen(data_log), items);
+  micro::check(items > 0 && strcmp(data_log + strlen(data_log) - 2, "]}") == 0, "buffer: full data log closed");
+  double before = micro::measure("assemble data log (snprintf \"%s,%s\")", assembleWithSnprintf);
+  double after = micro::measure("assemble data log (LoggerBuffer)", assembleWithBuilder);
+  printf("  speedup: %.1fx\n", before / after);
+});
@@ -0,0 +1,125 @@
+// recurring schedules on a simulated calendar: daily times on weekdays and a fixed interval run for two weeks (every
+// start compared with the calendar), starts missed while the power was out skipped or caught up after the reboot,
+// invalid repeat commands rejected, and the cost of finding the next start
+
+#include "micro.h"
+#include "fixture.h"
+
+#define TZ          FIXTURE_TZ // controller time zone
+#define RUN_DAYS    14
+
+static const SchedulerEvent schedule[] = {{10, SECONDS, 1, "start"}, {20, MINUTES, 2, "complete"}};
+#define N_EVENTS (sizeof(::schedule) / sizeof(::schedule[0]))
+
+// scheduler that records the start times of its runs
+class CalendarScheduler : public SchedulerLoggerComponent {
+
+  public:
+
+    std::vector<time_t> starts;
+    std::vector<time_t> first_events; // when the first event ran
+
+    CalendarScheduler(const char* id, LoggerController* ctrl) : SchedulerLoggerComponent(id, ctrl, new SchedulerState(), SCHEDULER_DT_PATTERN_YMD_24HM, ::schedule, N_EVENTS) {}
+
+    void runEvent(uint8_t event) {
+      if (event == 1) {
+        starts.push_back(state->tstart);
+        first_events.push_back(Time.now());
+      }
+    }
+
+    // loop passes of a second until a time
+    void runUntil(time_t end) {
+      while (Time.now() < end) {
+        if (state->status == SCHEDULE_RUNNING) runSchedule();
+        if (checkSchedule()) startSchedule();
+        sim::advance(1000);
+      }
+    }
+
+};
+
+typedef SchedulerUnit<CalendarScheduler> CalendarUnit;
+
+// starts expected from the calendar (every minute of the local time checked against the weekdays and times of day)
+static std::vector<time_t> calendarStarts(time_t from, time_t to, uint8_t days, std::vector<int> minutes) {
+  std::vector<time_t> starts;
+  for (time_t t = from - from % 60 + 60; t < to; t += 60) {
+    time_t local = t + TZ * 3600;
+    tm* date = gmtime(&local);
+    if (!(days & (1 << date->tm_wday))) continue;
+    for (int minute : minutes) if (date->tm_hour * 60 + date->tm_min == minute) starts.push_back(t);
+  }
+  return(starts);
+}
+
+static void report(const char* label, const std::vector<time_t>& expected, const std::vector<time_t>& starts) {
+  int wrong = 0;
+  for (size_t i = 0; i < expected.size() && i < starts.size(); i++) if (starts[i] != expected[i]) wrong++;
+  printf("  %-40s %zu runs (%zu on the calendar), %d at the wrong time\n", label, starts.size(), expected.size(), wrong);
+  micro::check(!expected.empty() && starts.size() == expected.size() && wrong == 0, label);
+}
+
+static micro::Benchmark calendar("calendar", [] {
+
+  sim::loadEEPROM(0);
+
+  // daily times on weekdays
+  CalendarUnit daily;
+  time_t from = Time.now();
+  daily.controller->receiveCommand("s1 repeat days mo-fr");
+  int daily_ret = daily.controller->receiveCommand("s1 repeat daily 06:30,18:00");
+  daily.scheduler->runUntil(from + RUN_DAYS * 86400L);
+  char label[60];
+  snprintf(label, sizeof(label), "'repeat daily 06:30,18:00' mo-fr (%d):", daily_ret);
+  report(label, calendarStarts(from, Time.now(), 0x3E, {6 * 60 + 30, 18 * 60}), daily.scheduler->starts);
+
+  // interval from a start time
+  sim::loadEEPROM(0);
+  CalendarUnit interval;
+  from = Time.now();
+  interval.controller->receiveCommand("s1 set 2022-07-16 09:15");
+  int interval_ret = interval.controller->receiveCommand("s1 repeat every 7 h");
+  time_t first = interval.scheduler->state->tstart;
+  interval.scheduler->runUntil(from + RUN_DAYS * 86400L);
+  std::vector<time_t> expected;
+  for (time_t t = first; t < Time.now(); t += 7 * 3600) expected.push_back(t);
+  snprintf(label, sizeof(label), "'repeat every 7 h' (%d):", interval_ret);
+  report(label, expected, interval.scheduler->starts);
+
+  // power out from 05:00 to 09:00 (local) over the 06:30 start: skipped or caught up after the reboot
+  for (bool catch_up : {false, true}) {
+    sim::loadEEPROM(0);
+    CalendarUnit unit;
+    unit.controller->receiveCommand("s1 repeat daily 06:30");
+    unit.controller->receiveCommand(catch_up ? "s1 repeat catch-up on" : "s1 repeat catch-up off");
+    time_t local = Time.now() + TZ * 3600;
+    time_t out = Time.now() - local % 86400 + 86400 + 5 * 3600; // 05:00 tomorrow
+    unit.scheduler->runUntil(out);
+    size_t before = unit.scheduler->starts.size();
+    sim::advance(4 * 3600 * 1000UL);
+    CalendarUnit rebooted(true);
+    time_t reboot = Time.now();
+    rebooted.scheduler->catchUpSchedule();
+    rebooted.scheduler->runUntil(Time.now() + 3600);
+    long first_wait = rebooted.scheduler->first_events.empty() ? -1 : (long) (rebooted.scheduler->first_events[0] - reboot);
+    printf("  power out 05:00-09:00, catch-up %-3s       %zu run(s) before, %zu run(s) within an hour of the reboot (first event after %ld s), next start in %.1f h\n",
+      catch_up ? "on:" : "off:", before, rebooted.scheduler->starts.size(), first_wait, difftime(rebooted.scheduler->state->tstart, Time.now()) / 3600.);
+    micro::check(rebooted.scheduler->starts.size() == (catch_up ? 1 : 0), catch_up ? "calendar: missed start caught up" : "calendar: missed start skipped");
+    if (catch_up) micro::check(first_wait >= ::schedule[0].wait, "calendar: caught-up run keeps its first wait");
+  }
+
+  // invalid repeat commands
+  const char* invalid[] = {"s1 repeat daily 25:00", "s1 repeat daily 06:30,12:00,18:00,20:00", "s1 repeat every 0 m",
+    "s1 repeat every 3 x", "s1 repeat days xx", "s1 repeat catch-up maybe", "s1 repeat weekly"};
+  int rejected = 0;
+  for (const char* text : invalid) if (daily.controller->receiveCommand(text) != CMD_RET_SUCCESS) rejected++;
+  printf("  %d/%d invalid repeat commands rejected\n", rejected, (int) (sizeof(invalid) / sizeof(invalid[0])));
+  micro::check(rejected == (int) (sizeof(invalid) / sizeof(invalid[0])), "calendar: invalid repeat commands rejected");
+
+  // cost
+  time_t now = Time.now();
+  micro::measure("next start, daily 06:30,18:00 mo-fr", [&] { micro::keep(daily.scheduler->getNextStart(now)); now += 3600; });
+  micro::measure("next start, every 7 h", [&] { micro::keep(interval.scheduler->getNextStart(now)); now += 3600; });
+  sim::loadEEPROM(0);
+});
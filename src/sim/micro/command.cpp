@@ -0,0 +1,111 @@
+// command tokenizer: extraction of variable, value, units and notes for the commands of docs/commands.md
+// (placeholders filled in, with and without notes) with the command split once vs. the buffer shifting of
+// the previous LoggerCommand::extractParam (kept here as the reference)
+
+#include "micro.h"
+#include "LoggerCommand.h"
+
+// docs/commands.md
+static const char* commands[] = {
+  "state-log on", "state-log off", "data-log on", "data-log off", "sd-log on", "sd-log off", "sd-test", "sd-flush",
+  "sd-format json", "sd-format binary", "log-batch on", "log-batch off",
+  "log-period 3 x", "log-period 2 s", "log-period 8 m", "log-period 1 h",
+  "read-period manual", "read-period 200 ms", "read-period 5 s",
+  "lock on", "lock off", "debug on", "debug off", "tz -6", "restart", "reset state", "reset data", "page",
+  "lcd power on", "lcd power off", "lcd reset", "lcd contrast 80", "lcd color 255,128,0", "lcd color cyan",
+  "power on", "power off",
+  "valco pos 3", "valco dir cw", "valco dir cc",
+  "s1 set 2022-07-01 09:30", "s1 reset", "s1 test 5"
+};
+#define NOTES " checking the unit before transport"
+
+// previous extraction: copy the token, then shift the rest of the buffer left (strlen in the loop condition)
+struct ShiftingCommand {
+
+  char command[CMD_MAX_CHAR];
+  char buffer[CMD_MAX_CHAR];
+  char variable[25];
+  char value[20];
+  char units[20];
+  char notes[CMD_MAX_CHAR];
+
+  void load(const char* text) {
+    strncpy(command, text, sizeof(command) - 1);
+    command[sizeof(command) - 1] = 0;
+    strcpy(buffer, command);
+  }
+
+  void extractParam(char* param, uint size, uint n_space = 1) {
+    uint space = strcspn(buffer, " ");
+    if (n_space > 1) {
+      for(uint s = 2; s <= n_space; s+=1) {
+        space += strcspn(buffer + space + 1, " ") + 1;
+      }
+    }
+    if (space < size) {
+      strncpy (param, buffer, space);
+      param[space] = 0;
+    } else {
+      memcpy (param, buffer, size); // token longer than param (no terminating 0 within size)
+      param[size] = 0;
+    }
+    if (space == strlen(buffer)) {
+      buffer[0] = 0;
+    } else {
+      for(uint i = space+1; i <= strlen(buffer); i+=1) {
+        buffer[i-space-1] = buffer[i];
+      }
+    }
+  }
+
+  void assignNotes() {
+    strncpy(notes, buffer, sizeof(notes));
+  }
+
+};
+
+// the extractions of a parser: variable, value, units (date and time for a scheduler) and notes
+template<typename C> static void extract(C* command, const char* text) {
+  command->load(text);
+  command->extractParam(command->variable, sizeof(command->variable));
+  command->extractParam(command->value, sizeof(command->value));
+  command->extractParam(command->units, sizeof(command->units), strcmp(command->value, "set") == 0 ? 2 : 1);
+  command->assignNotes();
+}
+
+static micro::Benchmark command("command", [] {
+
+  // all commands with and without notes
+  std::vector<std::string> texts;
+  for (const char* text : commands) {
+    texts.push_back(text);
+    texts.push_back(std::string(text) + NOTES);
+  }
+
+  // same fields as before
+  ShiftingCommand shifting;
+  LoggerCommand tokenized;
+  unsigned long mismatches = 0;
+  for (std::string& text : texts) {
+    extract(&shifting, text.c_str());
+    extract(&tokenized, text.c_str());
+    if (strcmp(shifting.variable, tokenized.variable) != 0 || strcmp(shifting.value, tokenized.value) != 0 ||
+        strcmp(shifting.units, tokenized.units) != 0 || strcmp(shifting.notes, tokenized.notes) != 0) {
+      if (mismatches++ < 3) printf("  mismatch for '%s': '%s' '%s' '%s' '%s'\n", text.c_str(), tokenized.variable, tokenized.value, tokenized.units, tokenized.notes);
+    }
+  }
+  tokenized.load("valco pos 3" NOTES);
+  bool tokens = tokenized.getTokenCount() == 8 && tokenized.isToken(0, "valco") && tokenized.isToken(2, "3") && !tokenized.isToken(2, "30");
+  printf("  %zu commands: %lu mismatches, tokens by index: %s\n", texts.size(), mismatches, tokens ? "ok" : "WRONG");
+  micro::check(mismatches == 0 && tokens, "command: tokenized same as shifted");
+
+  // cost of the whole command set
+  micro::measure("command set, shifting buffer", [&] {
+    for (std::string& text : texts) extract(&shifting, text.c_str());
+    micro::keep(shifting.notes[0]);
+  });
+  micro::measure("command set, split once", [&] {
+    for (std::string& text : texts) extract(&tokenized, text.c_str());
+    micro::keep(tokenized.notes[0]);
+  });
+});
@@ -0,0 +1,83 @@
+// number formatting: pow/round/snprintf (print_to_decimals_snprintf, previous print_to_decimals) vs. print_to_decimals
+// plus an equivalence check of both over the fast decimals range
+
+#include "micro.h"
+#include "LoggerMath.h"
+#include <random>
+
+static char text[20];
+
+// data log values: typical sensor readings with their decimals
+static const double values[] = {23.456789, -0.0123, 1013.25, 0.000456, 12345.678, 7.0, -273.15, 0.5};
+static const int decimals[] = {2, 4, 1, 6, 0, 3, 2, 1};
+#define VALUES_N (sizeof(values) / sizeof(values[0]))
+static size_t value_i = 0;
+
+static void printWithSnprintf() {
+  print_to_decimals_snprintf(text, sizeof(text), values[value_i], decimals[value_i]);
+  value_i = (value_i + 1) % VALUES_N;
+  micro::keep(text[0]);
+}
+
+static void printFast() {
+  print_to_decimals(text, sizeof(text), values[value_i], decimals[value_i]);
+  value_i = (value_i + 1) % VALUES_N;
+  micro::keep(text[0]);
+}
+
+// compare both implementations (incl. cut off into a small target)
+static unsigned long checked = 0, mismatches = 0;
+
+static void check(double number, int d) {
+  char before[40], after[40], before_short[8], after_short[8];
+  print_to_decimals_snprintf(before, sizeof(before), number, d);
+  print_to_decimals(after, sizeof(after), number, d);
+  print_to_decimals_snprintf(before_short, sizeof(before_short), number, d);
+  print_to_decimals(after_short, sizeof(after_short), number, d);
+  checked++;
+  if (strcmp(before, after) != 0 || strcmp(before_short, after_short) != 0) {
+    if (mismatches < 10) printf("  MISMATCH: %.17g with %d decimals: '%s' vs. '%s'\n", number, d, before, after);
+    mismatches++;
+  }
+}
+
+static void checkEquivalence() {
+  std::mt19937_64 random(42);
+  std::uniform_real_distribution<double> mantissa(1.0, 10.0);
+  std::uniform_int_distribution<int> exponent(-15, 17);
+  std::uniform_int_distribution<unsigned long long> bits;
+  for (int d = FAST_DECIMALS_MIN; d <= FAST_DECIMALS_MAX; d++) {
+    // special values
+    for (double number : {0.0, -0.0, 1e-300, -1e-300, (double) NAN, (double) -NAN, (double) INFINITY, (double) -INFINITY, 1e15, -1e15, 4.5e15, 1e300}) check(number, d);
+    // exact halfway and neighbouring cases of the last digit
+    double step = pow(10.0, -d);
+    for (long k = -5000; k <= 5000; k++) {
+      double half = (k + 0.5) * step;
+      check(half, d);
+      check(nextafter(half, INFINITY), d);
+      check(nextafter(half, -INFINITY), d);
+      check(k * step, d);
+    }
+    // all magnitudes
+    for (int i = 0; i < 50000; i++) {
+      double number = mantissa(random) * pow(10.0, exponent(random));
+      check(i % 2 ? number : -number, d);
+    }
+    // random bit patterns
+    for (int i = 0; i < 50000; i++) {
+      unsigned long long b = bits(random);
+      double number;
+      memcpy(&number, &b, sizeof(number));
+      check(number, d);
+    }
+  }
+}
+
+static micro::Benchmark decimals_benchmark("decimals", [] {
+  checkEquivalence();
+  printf("  equivalence: %lu numbers, %lu mismatches (decimals %d to %d)\n", checked, mismatches, FAST_DECIMALS_MIN, FAST_DECIMALS_MAX);
+  micro::check(mismatches == 0, "decimals: same text as snprintf");
+  double before = micro::measure("print_to_decimals (pow + snprintf)", printWithSnprintf);
+  double after = micro::measure("print_to_decimals (digits)", printFast);
+  printf("  speedup: %.1fx\n", before / after);
+});
@@ -0,0 +1,117 @@
+// command dispatch: every command root of a build with over a dozen components (lcd, valve, relays, schedulers plus a
+// component without command roots) handled the same with the sorted command roots as with the previous chain of
+// parsers (kept here as the reference), and the cost of reaching the last component's parser
+
+#include "micro.h"
+#include "sim.h"
+#include "LoggerController.h"
+#include "LoggerDisplay.h"
+#include "ExampleLoggerComponent.h"
+#include "RelayLoggerComponent.h"
+#include "ValveLoggerComponent.h"
+#include "SchedulerLoggerComponent.h"
+
+#define N_RELAYS      12
+#define N_SCHEDULERS  2 // as many components as fit into the EEPROM
+
+static const SchedulerEvent schedule[] = {
+  {10, SECONDS, 1, "start"},
+  {1, MINUTES, 2, "end"}
+};
+
+static LoggerControllerState* micro_state() {
+  return(new LoggerControllerState(false, -6, false, false, false, 60, LOG_BY_TIME, 200, 10000));
+}
+
+// previous dispatch: every parser in turn, then every component
+class ChainController : public LoggerController {
+
+  public:
+
+    ChainController() : LoggerController("micro", A0, micro_state(), false) {}
+
+    void parseCommand() {
+      if (parseLocked()) {
+      } else if (parseDebug()) {
+      } else if (parseTimezone()) {
+      } else if (parseStateSaving()) {
+      } else if (parseSdLogging()) {
+      } else if (parseStateLogging()) {
+      } else if (parseDataLogging()) {
+      } else if (parseLogBatching()) {
+      } else if (parseDataLoggingPeriod()) {
+      } else if (parseDataReadingPeriod()) {
+      } else if (parseReset()) {
+      } else if (parseRestart()) {
+      } else if (parsePage()) {
+      } else if (parseSdTest()) {
+      } else if (parseSdFlush()) {
+      } else if (parseSdFormat()) {
+      } else if (lcd->parseCommand(command)) {
+      } else {
+        for (LoggerComponent* component : components) if (component->parseCommand(command)) break;
+      }
+    }
+
+};
+
+// controller with all components (same ids and order for both dispatches)
+template<typename C> static C* build(C* controller) {
+  controller->setDisplay(new LoggerDisplay(controller, 16, 2, 2));
+  controller->addComponent(new ValveLoggerComponent("valco", controller, new ValveState(), 9600, SERIAL_8N1, 16));
+  controller->addComponent(new ExampleLoggerComponent("example", controller, new ExampleState()));
+  char id[10];
+  for (int i = 1; i <= N_SCHEDULERS; i++) {
+    snprintf(id, sizeof(id), "s%d", i);
+    controller->addComponent(new SchedulerLoggerComponent(strdup(id), controller, new SchedulerState(), SCHEDULER_DT_PATTERN_YMD_24HM, schedule, 2));
+  }
+  for (int i = 1; i <= N_RELAYS; i++) {
+    snprintf(id, sizeof(id), "r%d", i);
+    controller->addComponent(new RelayLoggerComponent(strdup(id), controller, false, D2, RELAY_NORMALLY_OPEN));
+  }
+  return(controller);
+}
+
+// parse a command (without the state log of receiveCommand)
+static void parse(LoggerController* controller, const char* text) {
+  controller->command->reset();
+  controller->command->load(text);
+  controller->command->extractVariable();
+  controller->parseCommand();
+  if (!controller->command->isTypeDefined()) controller->command->errorCommand();
+}
+
+static micro::Benchmark dispatch("dispatch", [] {
+
+  sim::loadEEPROM(0);
+  ChainController* chain = build(new ChainController());
+  LoggerController* routed = build(new LoggerController("micro", A0, micro_state(), false));
+
+  // commands for all parsers (plus locked and unknown ones)
+  std::vector<std::string> texts = {
+    "debug on", "debug off", "tz -6", "save-state on", "sd-log off", "state-log on", "data-log off", "log-batch on",
+    "log-period 2 m", "read-period 5 s", "page", "lcd contrast 80", "lcd color cyan", "valco pos 3", "valco dir cc",
+    "setting yay", "setting nay", "s1 set 2022-07-01 09:30", "s5 reset", "r1 on", "r1 off",
+    "nope", "r99 on", "lock on", "r2 on", "tz 2", "lock off"
+  };
+  for (int i = 1; i <= N_RELAYS; i++) texts.push_back("r" + std::to_string(i) + " on");
+  unsigned long mismatches = 0;
+  for (std::string& text : texts) {
+    parse(chain, text.c_str());
+    parse(routed, text.c_str());
+    if (chain->command->ret_val != routed->command->ret_val || strcmp(chain->command->data, routed->command->data) != 0) {
+      if (mismatches++ < 3) printf("  mismatch for '%s': %d '%s' instead of %d '%s'\n", text.c_str(),
+        routed->command->ret_val, routed->command->data, chain->command->ret_val, chain->command->data);
+    }
+  }
+  printf("  %zu commands for %zu components: %lu mismatches\n", texts.size(), routed->components.size() + 1, mismatches);
+  micro::check(mismatches == 0, "dispatch: routed same as chain");
+
+  // cost of reaching a parser (last relay, display, unknown command)
+  std::string last = "r" + std::to_string(N_RELAYS) + " on";
+  micro::measure("last component, chain of parsers", [&] { parse(chain, last.c_str()); micro::keep(chain->command->ret_val); });
+  micro::measure("last component, sorted command roots", [&] { parse(routed, last.c_str()); micro::keep(routed->command->ret_val); });
+  micro::measure("unknown command, chain of parsers", [&] { parse(chain, "nope"); micro::keep(chain->command->ret_val); });
+  micro::measure("unknown command, sorted command roots", [&] { parse(routed, "nope"); micro::keep(routed->command->ret_val); });
+  sim::loadEEPROM(0);
+});
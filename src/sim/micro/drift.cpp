@@ -0,0 +1,137 @@
+// scheduler timing: a full schedule (same events and waits as swiss) on an accelerated clock with uneven loop passes
+// (incl. occasional long ones), events fired against absolute deadlines vs. the previous relative waits (kept here as
+// the reference): lateness of each event and the drift it carries over to the rest of the schedule
+
+#include "micro.h"
+#include "sim.h"
+#include "LoggerController.h"
+#include "LoggerDisplay.h"
+#include "SchedulerLoggerComponent.h"
+
+static const SchedulerEvent schedule[] = {
+  {10, SECONDS, 1, "start"}, {10, SECONDS, 3, "flush internal"}, {15, MINUTES, 4, "flush probe"},
+  {10, MINUTES, 5, "flush flask"}, {45, MINUTES, 6, "END! 25cm"}, {1, MINUTES, 7, "flush probe"},
+  {10, MINUTES, 8, "flush flask"}, {45, MINUTES, 9, "END! 50cm"}, {1, MINUTES, 10, "flush probe"},
+  {10, MINUTES, 11, "flush flask"}, {45, MINUTES, 12, "END! 75 cm"}, {1, MINUTES, 13, "final clean"},
+  {1, MINUTES, 2, "complete"}
+};
+#define N_EVENTS (sizeof(::schedule) / sizeof(::schedule[0]))
+
+// scheduler that records when its events run (virtual ms since boot)
+class RecordingScheduler : public SchedulerLoggerComponent {
+
+  public:
+
+    unsigned long long fired[N_EVENTS];
+    uint8_t n_fired = 0;
+
+    RecordingScheduler(const char* id, LoggerController* ctrl) : SchedulerLoggerComponent(id, ctrl, new SchedulerState(), SCHEDULER_DT_PATTERN_YMD_24HM, ::schedule, N_EVENTS) {}
+
+    void runEvent(uint8_t event) {
+      if (n_fired < N_EVENTS) fired[n_fired++] = sim::now_us() / 1000;
+    }
+
+    unsigned long getLate(uint8_t i) { return(schedule_late[i]); }
+
+};
+
+// previous scheduler: each wait counted (in seconds) from when the previous event ran
+class RelativeScheduler : public RecordingScheduler {
+
+  time_t schedule_last = 0;
+
+  public:
+
+    RelativeScheduler(const char* id, LoggerController* ctrl) : RecordingScheduler(id, ctrl) {}
+
+    bool checkStart() {
+      return(state->status == SCHEDULE_WAITING && difftime(Time.now(), state->tstart) > 0);
+    }
+
+    void start() {
+      startSchedule();
+      schedule_last = Time.now();
+    }
+
+    void runSchedule() {
+      if (round(difftime(Time.now(), schedule_last)) > schedule_wait) {
+        runEvent(schedule[schedule_i].event);
+        schedule_i++;
+        schedule_last = Time.now();
+        if (schedule_i >= schedule_length) finishSchedule();
+        else schedule_wait = schedule[schedule_i].wait;
+      }
+    }
+
+};
+
+// deterministic uneven loop passes (1-200 ms, every 500th pass blocked for 3 s)
+static unsigned long pass_ms(unsigned long pass) {
+  static uint32_t seed = 12345;
+  seed = seed * 1103515245 + 12345;
+  return((pass % 500 == 499) ? 3000 : 1 + (seed >> 16) % 200);
+}
+
+static void report(const char* label, RecordingScheduler* scheduler, unsigned long long tstart_ms, bool has_late) {
+  unsigned long long ideal = tstart_ms;
+  long max_late = 0, last_off = 0;
+  for (uint8_t i = 0; i < scheduler->n_fired; i++) {
+    ideal += schedule[i].wait * 1000ULL;
+    last_off = (long) (scheduler->fired[i] - ideal);
+    if (last_off > max_late) max_late = last_off;
+  }
+  printf("  %-20s %d/%d events, last one %ld ms after its ideal time (max %ld ms)", label, scheduler->n_fired, (int) N_EVENTS, last_off, max_late);
+  if (has_late) {
+    // deadlines are counted from the moment the start was noticed (Time is in seconds), the rest is lateness
+    long start_off = last_off - (long) scheduler->getLate(N_EVENTS - 1);
+    long first_off = (long) (scheduler->fired[0] - tstart_ms - schedule[0].wait * 1000ULL) - (long) scheduler->getLate(0);
+    printf(", start noticed %ld ms after tstart, cumulative drift %ld ms\n", first_off, start_off - first_off);
+    micro::check(start_off - first_off < 1000, "drift: no cumulative drift with absolute deadlines");
+  } else {
+    printf("\n");
+  }
+}
+
+static micro::Benchmark drift("drift", [] {
+
+  sim::loadEEPROM(0);
+  LoggerController* controller = new LoggerController("micro", A0, new LoggerControllerState(false, -6, false, false, false, 60, LOG_BY_TIME, 200, 10000), false);
+  RecordingScheduler* absolute = new RecordingScheduler("abs", controller);
+  RelativeScheduler* relative = new RelativeScheduler("rel", controller);
+  controller->setDisplay(new LoggerDisplay(controller, 16, 2, 2));
+  controller->addComponent(absolute);
+  controller->addComponent(relative);
+
+  // scheduled a bit into a second from now
+  sim::advance(1000 - (sim::now_us() / 1000) % 1000 + 400);
+  time_t tstart = Time.now() + 10;
+  unsigned long long tstart_ms = sim::now_us() / 1000 - (sim::now_us() / 1000) % 1000 + 10000;
+  for (RecordingScheduler* scheduler : {absolute, (RecordingScheduler*) relative}) {
+    scheduler->state->tstart = tstart;
+    scheduler->state->status = SCHEDULE_WAITING;
+  }
+
+  // run the full schedule (plus a few minutes for the relative waits to catch up)
+  unsigned long passes = 0;
+  while ((absolute->state->status != SCHEDULE_COMPLETE || relative->state->status != SCHEDULE_COMPLETE) && passes < 1000000) {
+    if (absolute->state->status == SCHEDULE_RUNNING) absolute->runSchedule();
+    if (absolute->checkSchedule()) absolute->startSchedule();
+    if (relative->state->status == SCHEDULE_RUNNING) relative->runSchedule();
+    if (relative->checkStart()) relative->start();
+    sim::advance(pass_ms(passes++));
+  }
+  printf("  %lu loop passes over %.1f h\n", passes, (sim::now_us() / 1000 - tstart_ms) / 3600000.);
+  report("absolute deadlines:", absolute, tstart_ms, true);
+  report("relative waits:", relative, tstart_ms, false);
+  micro::check(absolute->n_fired == N_EVENTS && relative->n_fired == N_EVENTS, "drift: every event fired");
+  printf("  lateness per event (debug variable): ");
+  for (uint8_t i = 0; i < N_EVENTS; i++) printf(i > 0 ? ",%lu" : "%lu", absolute->getLate(i));
+  printf(" ms\n");
+
+  // cost of a loop pass with no event due
+  absolute->state->status = SCHEDULE_WAITING;
+  absolute->state->tstart = Time.now();
+  absolute->startSchedule();
+  micro::measure("runSchedule, no event due", [&] { absolute->runSchedule(); micro::keep(absolute->state->status); });
+  sim::loadEEPROM(0);
+});
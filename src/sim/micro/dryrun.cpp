@@ -0,0 +1,95 @@
+// dry runs: the swiss schedule (3 hours, same events and actions as scheduler s1) run on a virtual clock, its trace
+// compared with the action table and the waits, nothing actuated, saved or logged meanwhile, a new schedule with a
+// typo checked before it is used, and the cost of a dry run vs. a test run with 1 second waits
+
+#include "micro.h"
+#include "fixture.h"
+
+// new schedule with a typo in the flush probe event (uploaded with commands)
+static const char* new_schedule[] = {"10 s 1 start", "15 m 4 flush probe", "45 m 6 END! 25cm", "1 m 2 complete"};
+static const SchedulerAction typo_actions[] = {
+  {1, "power on;valco pos 1"}, {4, "bypas off;25cm on"}, {6, "25cm off"}, {2, "power off"}
+};
+
+// commands of an action table entry
+static int countCommands(const char* commands) {
+  int n = 1;
+  for (const char* c = commands; *c != 0; c++) if (*c == ';') n++;
+  return(n);
+}
+
+static micro::Benchmark dryrun("dryrun", [] {
+
+  sim::loadEEPROM(0);
+  SwissUnit unit;
+  unit.add(swiss_actions, SWISS_EVENTS);
+  char before[30], after[30];
+  unit.getStates(before, sizeof(before));
+  unsigned long eeprom_writes = sim::stats.eeprom_writes;
+  unsigned long long clock_us = sim::now_us();
+
+  // full schedule
+  int ret = unit.controller->receiveCommand("s1 dry-run");
+  const LoggerTrace* trace = unit.controller->getActionTrace();
+  unit.getStates(after, sizeof(after));
+
+  // trace vs. the action table (commands in order) and the waits (virtual time of each step)
+  int expected = 0, wrong_time = 0;
+  uint32_t at = 0;
+  for (uint8_t i = 0; i < SWISS_EVENTS; i++) expected += countCommands(swiss_actions[i].commands);
+  for (uint8_t i = 0; i < trace->getLength(); i++) {
+    at = 0;
+    for (uint8_t j = 0; j <= trace->getEntry(i)->step; j++) at += swiss_schedule[j].wait;
+    if (trace->getEntry(i)->at != at) wrong_time++;
+  }
+  printf("  's1 dry-run': return code %d, %d commands traced (%d in the action table), %d at the wrong time, %d unknown, end +%.2f h\n",
+    ret, trace->getLength(), expected, wrong_time, trace->getUnknown(), trace->getEnd() / 3600.);
+  micro::check(ret == CMD_RET_SUCCESS && trace->getLength() == expected && wrong_time == 0 && trace->getUnknown() == 0, "dryrun: trace matches the action table");
+  printf("  meanwhile: states %s -> %s, %lu EEPROM bytes written, %lu data logs, %.3f ms of the clock\n",
+    before, after, sim::stats.eeprom_writes - eeprom_writes, unit.controller->data_logs, (sim::now_us() - clock_us) / 1000.);
+  micro::check(strcmp(before, after) == 0 && sim::stats.eeprom_writes == eeprom_writes && unit.controller->data_logs == 0, "dryrun: nothing actuated, saved or logged");
+  printf("  logged command: '%s'\n", unit.controller->command->command);
+  micro::check(strcmp(unit.controller->command->command, "s1 dry-run") == 0, "dryrun: logged command untouched by the trace");
+
+  // new schedule checked before it is used
+  sim::loadEEPROM(0);
+  SwissUnit typo_unit;
+  typo_unit.add(typo_actions, sizeof(typo_actions) / sizeof(typo_actions[0]));
+  for (const char* line : new_schedule) {
+    char text[40];
+    snprintf(text, sizeof(text), "s1 add %s", line);
+    typo_unit.controller->receiveCommand(text);
+  }
+  int next_ret = typo_unit.controller->receiveCommand("s1 dry-run next");
+  const LoggerTrace* typo_trace = typo_unit.controller->getActionTrace();
+  const char* unknown = "-";
+  for (uint8_t i = 0; i < typo_trace->getLength(); i++) if (typo_trace->getEntry(i)->check == TRACE_CMD_UNKNOWN) unknown = typo_trace->getCommand(i);
+  printf("  new schedule with a typo, 's1 dry-run next': return code %d (%d), %d unknown command: '%s'\n",
+    next_ret, CMD_RET_ERR_SCHEDULE_INVALID, typo_trace->getUnknown(), unknown);
+  micro::check(next_ret == CMD_RET_ERR_SCHEDULE_INVALID && typo_trace->getUnknown() == 1 && strcmp(unknown, "bypas off") == 0, "dryrun: typo found");
+
+  // a component without command roots might handle it: unchecked instead of unknown
+  typo_unit.controller->addComponent(new LoggerComponent("extra", typo_unit.controller, true, true));
+  int unrouted_ret = typo_unit.controller->receiveCommand("s1 dry-run next");
+  printf("  with a component without command roots: return code %d, %d unknown, %d unchecked\n", unrouted_ret, typo_trace->getUnknown(), typo_trace->getUnchecked());
+  micro::check(unrouted_ret == CMD_RET_SUCCESS && typo_trace->getUnknown() == 0 && typo_trace->getUnchecked() == 1, "dryrun: unrouted command unchecked");
+
+  // events run in code instead of an action table
+  SwissUnit code_unit;
+  code_unit.add(0, 0);
+  int code_ret = code_unit.controller->receiveCommand("s1 dry-run");
+  printf("  scheduler without an action table, 's1 dry-run': return code %d (%d)\n", code_ret, CMD_RET_ERR_SCHEDULE_NO_ACTIONS);
+  micro::check(code_ret == CMD_RET_ERR_SCHEDULE_NO_ACTIONS, "dryrun: refused without an action table");
+
+  // cost vs. a test run with 1 second waits (virtual time)
+  unsigned long long test_start = sim::now_us();
+  unit.scheduler->testSchedule(1);
+  unit.scheduler->startSchedule();
+  while (unit.scheduler->isScheduleInUse()) {
+    sim::advance(10);
+    unit.scheduler->runSchedule();
+  }
+  printf("  test run with 1 second waits: %.1f s of the (virtual) clock\n", (sim::now_us() - test_start) / 1e6);
+  micro::measure("dry run of the 3 h schedule", [&] { micro::keep(unit.scheduler->dryRunSchedule(swiss_schedule, SWISS_EVENTS)); });
+  sim::loadEEPROM(0);
+});
@@ -0,0 +1,127 @@
+/**
+ * Shared fixtures of the microbenchmarks: the swiss schedule and its action table (scheduler s1), a controller that
+ * counts its data logs, the swiss components, and a controller with one scheduler (fresh or rebooted).
+ */
+
+#pragma once
+#include "sim.h"
+#include "LoggerController.h"
+#include "LoggerDisplay.h"
+#include "RelayLoggerComponent.h"
+#include "ValveLoggerComponent.h"
+#include "SchedulerLoggerComponent.h"
+
+#define FIXTURE_TZ  -6 // time zone of the fixture controllers (local = UTC - 6 h)
+
+// swiss event codes
+#define EVENT_START       1
+#define EVENT_END         2
+#define EVENT_CLEAN       3
+#define EVENT_CLEAN25CM   4
+#define EVENT_START_25CM  5
+#define EVENT_END_25CM    6
+#define EVENT_CLEAN50CM   7
+#define EVENT_START_50CM  8
+#define EVENT_END_50CM    9
+#define EVENT_CLEAN75CM   10
+#define EVENT_START_75CM  11
+#define EVENT_END_75CM    12
+#define EVENT_END_CLEAN   13
+
+static const SchedulerEvent swiss_schedule[] = {
+  {10, SECONDS, EVENT_START, "start"}, {10, SECONDS, EVENT_CLEAN, "flush internal"}, {15, MINUTES, EVENT_CLEAN25CM, "flush probe"},
+  {10, MINUTES, EVENT_START_25CM, "flush flask"}, {45, MINUTES, EVENT_END_25CM, "END! 25cm"}, {1, MINUTES, EVENT_CLEAN50CM, "flush probe"},
+  {10, MINUTES, EVENT_START_50CM, "flush flask"}, {45, MINUTES, EVENT_END_50CM, "END! 50cm"}, {1, MINUTES, EVENT_CLEAN75CM, "flush probe"},
+  {10, MINUTES, EVENT_START_75CM, "flush flask"}, {45, MINUTES, EVENT_END_75CM, "END! 75 cm"}, {1, MINUTES, EVENT_END_CLEAN, "final clean"},
+  {1, MINUTES, EVENT_END, "complete"}
+};
+#define SWISS_EVENTS (sizeof(swiss_schedule) / sizeof(swiss_schedule[0]))
+
+// same actions as swiss (scheduler s1)
+static const SchedulerAction swiss_actions[] = {
+  {EVENT_START,      "power on;bypass off;25cm off;50cm off;75cm off;valco dir cw;valco pos 1;save-state pause"},
+  {EVENT_CLEAN,      "bypass on"},
+  {EVENT_CLEAN25CM,  "bypass off;25cm on"},
+  {EVENT_START_25CM, "valco dir cc;valco pos 2"},
+  {EVENT_END_25CM,   "valco dir cw;valco pos 1;25cm off;save-state resume"},
+  {EVENT_CLEAN50CM,  "save-state pause;valco pos 1;50cm on"},
+  {EVENT_START_50CM, "valco dir cc;valco pos 3"},
+  {EVENT_END_50CM,   "valco dir cw;valco pos 1;50cm off;save-state resume"},
+  {EVENT_CLEAN75CM,  "save-state pause;valco dir cw;valco pos 1;75cm on"},
+  {EVENT_START_75CM, "valco dir cc;valco pos 4"},
+  {EVENT_END_75CM,   "valco dir cw;valco pos 1;75cm off;save-state resume"},
+  {EVENT_END_CLEAN,  "save-state pause;valco dir cw;valco pos 1;bypass on"},
+  {EVENT_END,        "bypass off;power off;save-state resume"}
+};
+
+// controller that counts its data logs and data variable updates
+class DataCountingController : public LoggerController {
+
+  public:
+
+    unsigned long data_logs = 0;
+    unsigned long data_entries = 0;
+    unsigned long data_variable_updates = 0;
+
+    DataCountingController() : LoggerController("micro", A0, new LoggerControllerState(false, FIXTURE_TZ, false, false, true, 60, LOG_BY_TIME, 200, 10000), false) {}
+
+    void queueDataLog() {
+      data_logs++;
+      for (const char* c = data_log; (c = strstr(c, "\"i\":")) != 0; c++) data_entries++;
+      LoggerController::queueDataLog();
+    }
+
+    void updateDataVariable() {
+      data_variable_updates++;
+      LoggerController::updateDataVariable();
+    }
+
+    const char* getStateVariable() { return(state_variable); }
+
+};
+
+// swiss components (valve and relays, added with the scheduler that runs the events)
+struct SwissUnit {
+
+  DataCountingController* controller = new DataCountingController();
+  ValveLoggerComponent* valco = new ValveLoggerComponent("valco", controller, new ValveState(), 9600, SERIAL_8N1, 16);
+  RelayLoggerComponent* rpower = new RelayLoggerComponent("power", controller, false, D2, RELAY_NORMALLY_OPEN);
+  RelayLoggerComponent* rbypass = new RelayLoggerComponent("bypass", controller, false, D4, RELAY_NORMALLY_CLOSED);
+  RelayLoggerComponent* r25cm = new RelayLoggerComponent("25cm", controller, false, D5, RELAY_NORMALLY_CLOSED);
+  RelayLoggerComponent* r50cm = new RelayLoggerComponent("50cm", controller, false, D6, RELAY_NORMALLY_CLOSED);
+  RelayLoggerComponent* r75cm = new RelayLoggerComponent("75cm", controller, false, D7, RELAY_NORMALLY_CLOSED);
+  SchedulerLoggerComponent* scheduler = 0;
+
+  void add(SchedulerLoggerComponent* scheduler) {
+    this->scheduler = scheduler;
+    controller->setDisplay(new LoggerDisplay(controller, 16, 2, 2));
+    for (LoggerComponent* component : std::vector<LoggerComponent*>{valco, rpower, rbypass, r25cm, r50cm, r75cm, scheduler}) controller->addComponent(component);
+  }
+
+  // with the swiss schedule run from an action table (0 = events run in code)
+  void add(const SchedulerAction* actions, uint8_t actions_length) {
+    add(new SchedulerLoggerComponent("s1", controller, new SchedulerState(), SCHEDULER_DT_PATTERN_YMD_24HM, swiss_schedule, SWISS_EVENTS, actions, actions_length));
+  }
+
+  void getStates(char* target, int size) {
+    snprintf(target, size, "%d%d%d%d%d %d%d %d", rpower->state->on, rbypass->state->on, r25cm->state->on, r50cm->state->on,
+      r75cm->state->on, valco->state->pos, valco->state->cw, controller->state->save_state);
+  }
+
+};
+
+// controller with one scheduler 's1' (constructed from id and controller): fresh or rebooted with the state saved in EEPROM
+template<class Scheduler, bool enable_sd = false> struct SchedulerUnit {
+
+  LoggerController* controller = new LoggerController("micro", A0, new LoggerControllerState(false, FIXTURE_TZ, false, false, false, 60, LOG_BY_TIME, 200, 10000), enable_sd);
+  Scheduler* scheduler = new Scheduler("s1", controller);
+
+  SchedulerUnit(bool reboot = false) {
+    controller->setDisplay(new LoggerDisplay(controller, 16, 2, 2));
+    controller->addComponent(scheduler);
+    if (enable_sd) controller->sd->init();
+    if (reboot) scheduler->restoreState();
+    scheduler->init();
+  }
+
+};
@@ -0,0 +1,81 @@
+// command macros: a macro defined, run (same states as its commands sent one at a time) and restored after a reboot,
+// the errors for unknown macros, macros run from a batch and a full macro store
+
+#include "micro.h"
+#include "sim.h"
+#include "LoggerController.h"
+#include "LoggerDisplay.h"
+#include "RelayLoggerComponent.h"
+#include "ValveLoggerComponent.h"
+
+#define MACROS_START 3600 // after the states of the components (as set up by LoggerController::init())
+
+#define START_COMMANDS "power on;bypass off;valco pos 1"
+static const char* start_commands[] = {"power on", "bypass off", "valco pos 1"};
+
+struct Unit {
+
+  LoggerController* controller = new LoggerController("micro", A0, new LoggerControllerState(false, -6, false, false, false, 60, LOG_BY_TIME, 200, 10000), false);
+  ValveLoggerComponent* valco = new ValveLoggerComponent("valco", controller, new ValveState(), 9600, SERIAL_8N1, 16);
+  RelayLoggerComponent* power = new RelayLoggerComponent("power", controller, false, D2, RELAY_NORMALLY_OPEN);
+  RelayLoggerComponent* bypass = new RelayLoggerComponent("bypass", controller, true, D3, RELAY_NORMALLY_OPEN);
+
+  Unit() {
+    controller->setDisplay(new LoggerDisplay(controller, 16, 2, 2));
+    controller->addComponent(valco);
+    controller->addComponent(power);
+    controller->addComponent(bypass);
+    controller->macros->init(MACROS_START, EEPROM.length(), false);
+  }
+
+  bool same(const Unit& other) {
+    return(power->state->on == other.power->state->on && bypass->state->on == other.bypass->state->on &&
+      valco->state->pos == other.valco->state->pos && valco->state->cw == other.valco->state->cw);
+  }
+
+};
+
+static micro::Benchmark macro("macro", [] {
+
+  sim::loadEEPROM(0);
+  Unit single, macro;
+  single.valco->state->pos = macro.valco->state->pos = 5;
+
+  // define and run
+  int define_ret = macro.controller->receiveCommand("macro define start " START_COMMANDS);
+  for (const char* text : start_commands) single.controller->receiveCommand(text);
+  int run_ret = macro.controller->receiveCommand("run start");
+  printf("  'macro define start %s': return code %d, 'run start': return code %d, same states as %d commands: %s\n",
+    START_COMMANDS, define_ret, run_ret, (int) (sizeof(start_commands) / sizeof(start_commands[0])), single.same(macro) ? "yes" : "NO");
+  micro::check(define_ret == CMD_RET_SUCCESS && run_ret == CMD_RET_SUCCESS && single.same(macro), "macro: same states as its commands");
+
+  // restored after a reboot
+  Unit rebooted;
+  const char* restored = rebooted.controller->macros->getCommands("start");
+  printf("  after a reboot: %s\n", restored != 0 && strcmp(restored, START_COMMANDS) == 0 ? "restored" : "NOT RESTORED");
+  micro::check(restored != 0 && strcmp(restored, START_COMMANDS) == 0, "macro: restored after a reboot");
+
+  // errors
+  int unknown_ret = macro.controller->receiveCommand("run stop");
+  int batch_ret = macro.controller->receiveCommand("power off;run start");
+  printf("  'run stop': return code %d (%d), 'power off;run start': return code %d (2nd command: error)\n",
+    unknown_ret, CMD_RET_ERR_MACRO_UNKNOWN, batch_ret);
+  micro::check(unknown_ret == CMD_RET_ERR_MACRO_UNKNOWN && batch_ret < 0, "macro: unknown macro and macro in a batch");
+  macro.controller->receiveCommand("macro define m2 power on");
+  macro.controller->receiveCommand("macro define m3 power off");
+  int full_ret = macro.controller->receiveCommand("macro define m4 page");
+  int delete_ret = macro.controller->receiveCommand("macro delete m2");
+  int redefine_ret = macro.controller->receiveCommand("macro define m4 page");
+  printf("  %d macros: 4th one return code %d (%d), after deleting one (return code %d): %d\n",
+    MACROS_MAX, full_ret, CMD_RET_ERR_MACROS_FULL, delete_ret, redefine_ret);
+  micro::check(full_ret == CMD_RET_ERR_MACROS_FULL && delete_ret == CMD_RET_SUCCESS && redefine_ret == CMD_RET_SUCCESS, "macro: full store");
+
+  // cost on the device (besides the cloud round trips)
+  micro::measure("commands one at a time", [&] {
+    for (const char* text : start_commands) micro::keep(single.controller->receiveCommand(text));
+  });
+  micro::measure("macro", [&] {
+    micro::keep(macro.controller->receiveCommand("run start"));
+  });
+  sim::loadEEPROM(0);
+});
@@ -0,0 +1,56 @@
+#include "micro.h"
+#include <chrono>
+
+struct Registered {
+  const char* name;
+  std::function<void()> run;
+};
+
+static std::vector<Registered>& registry() {
+  static std::vector<Registered> benchmarks;
+  return(benchmarks);
+}
+
+micro::Benchmark::Benchmark(const char* name, std::function<void()> run) {
+  registry().push_back({name, run});
+}
+
+static int failures = 0;
+
+bool micro::check(bool condition, const char* label) {
+  if (!condition) {
+    printf("  FAILED: %s\n", label);
+    failures++;
+  }
+  return(condition);
+}
+
+double micro::measure(const char* label, std::function<void()> fn, unsigned long min_ms) {
+  // warm up
+  for (int i = 0; i < 100; i++) fn();
+  // double the batch until it runs long enough
+  unsigned long n = 100;
+  double elapsed_ns = 0;
+  while (true) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned long i = 0; i < n; i++) fn();
+    elapsed_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    if (elapsed_ns >= min_ms * 1e6) break;
+    n *= 2;
+  }
+  double per_call = elapsed_ns / n;
+  printf("  %-50s %12.1f ns\n", label, per_call);
+  return(per_call);
+}
+
+int main(int argc, char** argv) {
+  for (Registered& benchmark : registry()) {
+    bool selected = (argc == 1);
+    for (int i = 1; i < argc; i++) if (strcmp(argv[i], benchmark.name) == 0) selected = true;
+    if (!selected) continue;
+    printf("%s\n", benchmark.name);
+    benchmark.run();
+  }
+  if (failures > 0) printf("%d check(s) FAILED\n", failures);
+  return(failures > 0 ? 1 : 0);
+}
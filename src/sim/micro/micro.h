@@ -0,0 +1,31 @@
+/**
+ * Host microbenchmarks for logger building blocks (make micro).
+ * Every benchmark registers itself with a static micro::Benchmark and reports its measurements via measure().
+ * Expected outcomes are asserted with check(): sim-micro exits with an error if any check failed.
+ */
+
+#pragma once
+#include "application.h"
+#include <vector>
+
+namespace micro {
+
+  // register a benchmark under a name (run all with sim-micro, or a selection with sim-micro NAME...)
+  struct Benchmark {
+    Benchmark(const char* name, std::function<void()> run);
+  };
+
+  // time repeated calls of fn (at least min_ms of host time) and print the cost per call
+  // @return ns per call
+  double measure(const char* label, std::function<void()> fn, unsigned long min_ms = 200);
+
+  // assert an expected outcome (failures are printed and counted)
+  // @return the condition
+  bool check(bool condition, const char* label);
+
+  // keep the compiler from optimizing away a result
+  template<typename T> inline void keep(T const& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+  }
+
+}
@@ -0,0 +1,191 @@
+// state migration: the swiss states restored from captured EEPROM images (raw structs saved by swiss 0.3 before
+// the state slots, and state slots) and a state record upgraded over several versions
+
+#include "micro.h"
+#include "sim.h"
+#include "LoggerController.h"
+#include "LoggerDisplay.h"
+#include "RelayLoggerComponent.h"
+#include "ValcoValveLoggerComponent.h"
+#include "SchedulerLoggerComponent.h"
+
+// images captured with --storage (2022-06-30: s1 running at step 5, s2 waiting, lcd contrast 80, logging every minute)
+#define IMAGE_RAW    "src/sim/eeprom/swiss-raw-v5.bin"
+#define IMAGE_SLOTS  "src/sim/eeprom/swiss-slots-v7.bin"
+
+#define UPGRADE_START 0
+
+static const SchedulerEvent schedule[] = {
+  {10, SECONDS, 1, "start"},
+  {1, MINUTES, 2, "end"}
+};
+
+// controller and components with the same states in the same order as src/swiss
+struct Swiss {
+
+  LoggerController* controller = new LoggerController("swiss 0.3", A0, new LoggerControllerState(false, -6, true, false, false, 24*60*60, LOG_BY_TIME, 200, 60*60*1000), true);
+  LoggerDisplay* lcd = new LoggerDisplay(controller, 16, 2, 2);
+  ValcoValveLoggerComponent* valco = new ValcoValveLoggerComponent("valco", controller, 16);
+  std::vector<RelayLoggerComponent*> relays;
+  std::vector<SchedulerLoggerComponent*> schedulers;
+
+  Swiss() {
+    controller->setDisplay(lcd);
+    controller->addComponent(valco);
+    for (const char* id : {"power", "bypass", "25cm", "50cm", "75cm"}) {
+      relays.push_back(new RelayLoggerComponent(id, controller, false, D2, RELAY_NORMALLY_OPEN));
+      controller->addComponent(relays.back());
+    }
+    for (const char* id : {"s1", "s2", "s3", "s4", "s5"}) {
+      schedulers.push_back(new SchedulerLoggerComponent(id, controller, new SchedulerState(), SCHEDULER_DT_PATTERN_YMD_24HM, schedule, 2));
+      controller->addComponent(schedulers.back());
+    }
+  }
+
+  // restore all states like LoggerController::init()
+  // @return number of restored states
+  int restore() {
+    int restored = 0;
+    controller->readLegacyEEPROM();
+    if (controller->restoreState()) restored++;
+    if (lcd->restoreState()) restored++;
+    for (LoggerComponent* component : controller->components) if (component->restoreState()) restored++;
+    controller->clearLegacyEEPROM();
+    return(restored);
+  }
+
+};
+
+// compare the restored states with the captured ones
+// @return number of mismatches
+static int check(Swiss* swiss) {
+  int mismatches = 0;
+  auto expect = [&mismatches](const char* what, double value, double expected) {
+    if (value != expected) {
+      if (mismatches++ < 5) printf("  mismatch: %s is %.0f instead of %.0f\n", what, value, expected);
+    }
+  };
+  LoggerControllerState* state = swiss->controller->state;
+  expect("controller tz", state->tz, -6);
+  expect("controller state-log", state->state_logging, true);
+  expect("controller data-log", state->data_logging, true);
+  expect("controller log-period", state->data_logging_period, 60);
+  expect("controller read-period", state->data_reading_period, 10000);
+  expect("controller name", strcmp(state->name, "sim"), 0);
+  expect("lcd contrast", swiss->lcd->state->contrast, 80);
+  expect("valco position", swiss->valco->state->pos, 1);
+  expect("power relay", swiss->relays[0]->state->on, true);
+  expect("bypass relay", swiss->relays[1]->state->on, false);
+  SchedulerState* s1 = swiss->schedulers[0]->state;
+  expect("s1 status", s1->status, SCHEDULE_RUNNING);
+  expect("s1 start", s1->tstart, 1656630180);
+  expect("s1 saved step", s1->saved_step, 5);
+  expect("s1 saved time", s1->saved_time, 1656637973);
+  SchedulerState* s2 = swiss->schedulers[1]->state;
+  expect("s2 status", s2->status, SCHEDULE_WAITING);
+  expect("s2 start", s2->tstart, 1656775800);
+  expect("s3 status", swiss->schedulers[2]->state->status, SCHEDULE_UNSCHEDULED);
+  return(mismatches);
+}
+
+/*** upgrades over several versions ***/
+
+// version 1: wait in minutes and mode 0-2
+struct WaitStateV1 {
+  uint16_t wait = 0;
+  uint8_t mode = 0;
+  uint8_t version = 1;
+};
+static const StateField wait_state_v1_fields[] = {
+  STATE_FIELD(1, WaitStateV1, wait),
+  STATE_FIELD(2, WaitStateV1, mode)
+};
+
+// version 3: wait in seconds (new field, v2) and mode 1-3 (v3) plus a new setting
+struct WaitState {
+  uint32_t wait_s = 0;
+  uint8_t mode = 1;
+  bool setting = true;
+  uint8_t version = 3;
+};
+static const StateField wait_state_fields[] = {
+  STATE_FIELD(2, WaitState, mode),
+  STATE_FIELD(3, WaitState, wait_s),
+  STATE_FIELD(4, WaitState, setting)
+};
+
+static void upgradeWaitState1(WaitState* state, const StateRecord& saved) {
+  uint16_t minutes;
+  if (saved.get(1, &minutes)) state->wait_s = 60UL * minutes;
+}
+
+static void upgradeWaitState2(WaitState* state, const StateRecord& saved) {
+  state->mode++;
+}
+
+static micro::Benchmark migrate("migrate", [] {
+
+  // import of the raw structs (then restored from the state slots they were imported into)
+  if (!micro::check(sim::loadEEPROM(IMAGE_RAW), "migrate: raw image loaded")) return;
+  Swiss imported;
+  int restored = imported.restore();
+  int mismatches = check(&imported);
+  printf("  %s: %d of 13 states imported, %d mismatches\n", IMAGE_RAW, restored, mismatches);
+  micro::check(restored == 13 && mismatches == 0, "migrate: raw structs imported");
+  Swiss rebooted;
+  restored = rebooted.restore();
+  mismatches = check(&rebooted);
+  printf("  reboot after the import: %d of 13 states restored, %d mismatches, %lu saves\n",
+    restored, mismatches, (unsigned long) rebooted.schedulers[0]->persistent_state.getSequence());
+  micro::check(restored == 13 && mismatches == 0, "migrate: restored after the import");
+
+  // state slots
+  if (!micro::check(sim::loadEEPROM(IMAGE_SLOTS), "migrate: slots image loaded")) return;
+  Swiss slots;
+  restored = slots.restore();
+  mismatches = check(&slots);
+  printf("  %s: %d of 13 states restored, %d mismatches\n", IMAGE_SLOTS, restored, mismatches);
+  micro::check(restored == 13 && mismatches == 0, "migrate: state slots restored");
+
+  // upgrades 1->2->3
+  sim::loadEEPROM(0);
+  WaitStateV1 v1;
+  v1.wait = 90;
+  v1.mode = 2;
+  PersistentState<WaitStateV1> saved_v1(&v1, wait_state_v1_fields, 16);
+  saved_v1.save(UPGRADE_START);
+  WaitState v3;
+  PersistentState<WaitState> persistent_v3(&v3, wait_state_fields, 16);
+  persistent_v3.addUpgrade(1, upgradeWaitState1);
+  persistent_v3.addUpgrade(2, upgradeWaitState2);
+  bool upgraded = persistent_v3.restore(UPGRADE_START);
+  printf("  upgrade 1->3: %s, wait %lu s (90 min), mode %d (3), setting %d (default 1), saved again as version 3: %s\n",
+    upgraded ? "restored" : "FAILED", (unsigned long) v3.wait_s, v3.mode, v3.setting, persistent_v3.getSequence() == 2 ? "yes" : "NO");
+  micro::check(upgraded && v3.wait_s == 5400 && v3.mode == 3 && v3.setting == 1 && persistent_v3.getSequence() == 2, "migrate: upgrade 1->3");
+
+  // newer versions and reset states are not restored
+  v1.version = 4;
+  saved_v1.save(UPGRADE_START);
+  WaitState newer;
+  PersistentState<WaitState> persistent_newer(&newer, wait_state_fields, 16);
+  bool newer_restored = persistent_newer.restore(UPGRADE_START);
+  v1.version = 0;
+  saved_v1.save(UPGRADE_START);
+  WaitState reset;
+  PersistentState<WaitState> persistent_reset(&reset, wait_state_fields, 16);
+  bool reset_restored = persistent_reset.restore(UPGRADE_START);
+  printf("  version 4 record: %s, version 0 (reset) record: %s\n",
+    newer_restored ? "RESTORED" : "defaults", reset_restored ? "RESTORED" : "defaults");
+  micro::check(!newer_restored && !reset_restored, "migrate: newer and reset records not restored");
+
+  // cost of restoring all swiss states at boot
+  Swiss swiss;
+  micro::measure("restore swiss states (import of raw structs)", [&swiss] {
+    sim::loadEEPROM(IMAGE_RAW);
+    micro::keep(swiss.restore());
+  });
+  micro::measure("restore swiss states (state slots)", [&swiss] {
+    micro::keep(swiss.restore());
+  });
+  sim::loadEEPROM(0);
+});
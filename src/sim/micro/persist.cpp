@@ -0,0 +1,107 @@
+// persistent state in EEPROM: power loss after every single byte of a save (restored state must be the old or
+// the new one, never a mix) and wear of the busiest EEPROM byte for scheduler step saves (single put vs. slot ring)
+
+#include "micro.h"
+#include "sim.h"
+#include "SchedulerLoggerComponent.h"
+
+#define STEP_SAVES 10000
+
+// separate areas so the tests do not see each other's saves
+#define RAW_START     0
+#define RING_START    512
+#define LOSS_START    1024
+
+static bool same(const SchedulerState& a, const SchedulerState& b) {
+  return(a.status == b.status && a.tstart == b.tstart && a.saved_step == b.saved_step && a.saved_time == b.saved_time && a.version == b.version);
+}
+
+// scheduler state after a schedule step
+static void step(SchedulerState* state, int i) {
+  state->status = SCHEDULE_RUNNING;
+  state->tstart = 1600000000;
+  state->saved_step = i % 200;
+  state->saved_time = 1600000000 + 60 * i;
+}
+
+static unsigned long maxCellWrites(int start, size_t size) {
+  unsigned long max_writes = 0;
+  for (size_t i = 0; i < size; i++) max_writes = std::max(max_writes, sim::eepromCellWrites(start + i));
+  return(max_writes);
+}
+
+static micro::Benchmark persist("persist", [] {
+
+  sim::loadEEPROM(0);
+
+  // power loss during a save
+  SchedulerState state, restored;
+  PersistentState<SchedulerState> persistent(&state, scheduler_state_fields, SCHEDULER_STATE_RECORD);
+  step(&state, 1);
+  persistent.save(LOSS_START);
+  SchedulerState old_state = state;
+  unsigned long old_states = 0, new_states = 0, broken = 0, cuts = 0;
+  for (long budget = 0; ; budget++) {
+    // back to the old save, then cut the power after budget bytes of the next one
+    state = old_state;
+    PersistentState<SchedulerState> before(&state, scheduler_state_fields, SCHEDULER_STATE_RECORD);
+    before.restore(LOSS_START);
+    step(&state, 2 + (int) budget);
+    SchedulerState new_state = state;
+    unsigned long writes = sim::stats.eeprom_writes;
+    sim::eeprom_write_budget = budget;
+    before.save(LOSS_START);
+    sim::eeprom_write_budget = -1;
+    bool complete = sim::stats.eeprom_writes - writes < (unsigned long) budget;
+    // reboot
+    restored = SchedulerState();
+    PersistentState<SchedulerState> after(&restored, scheduler_state_fields, SCHEDULER_STATE_RECORD);
+    if (!after.restore(LOSS_START)) broken++;
+    else if (same(restored, new_state)) new_states++;
+    else if (same(restored, old_state)) old_states++;
+    else broken++;
+    cuts++;
+    if (complete) break;
+    // the interrupted save stays the old state for the next cut
+    PersistentState<SchedulerState> reset(&old_state, scheduler_state_fields, SCHEDULER_STATE_RECORD);
+    reset.save(LOSS_START);
+  }
+  printf("  power loss after every byte of a save: %lu cuts, %lu restored old state, %lu restored new state, %lu broken\n",
+    cuts, old_states, new_states, broken);
+  micro::check(broken == 0 && new_states > 0, "persist: power loss never breaks the state");
+
+  // wear of scheduler step saves
+  SchedulerState raw_state, ring_state;
+  PersistentState<SchedulerState> ring(&ring_state, scheduler_state_fields, SCHEDULER_STATE_RECORD);
+  for (int i = 0; i < STEP_SAVES; i++) {
+    step(&raw_state, i);
+    EEPROM.put(RAW_START, raw_state);
+    step(&ring_state, i);
+    ring.save(RING_START);
+  }
+  unsigned long raw_max = maxCellWrites(RAW_START, sizeof(raw_state));
+  unsigned long ring_max = maxCellWrites(RING_START, ring.getSize());
+  printf("  %d step saves, busiest EEPROM byte: %lu writes with a single put, %lu writes with %d slots (%.1fx less wear, %zu vs. %zu bytes)\n",
+    STEP_SAVES, raw_max, ring_max, STATE_SLOTS, (double) raw_max / ring_max, sizeof(raw_state), ring.getSize());
+  micro::check(ring_max < raw_max, "persist: less wear with slots");
+
+  // unchanged state is not written again
+  unsigned long writes = sim::stats.eeprom_writes;
+  for (int i = 0; i < 100; i++) ring.save(RING_START);
+  printf("  100 saves of an unchanged state: %lu bytes written\n", sim::stats.eeprom_writes - writes);
+  micro::check(sim::stats.eeprom_writes == writes, "persist: unchanged state not written");
+
+  // cost of a save (CRC + EEPROM bytes) and of a restore (scan of all slots)
+  int i = 0;
+  micro::measure("single put", [&] {
+    step(&raw_state, i++);
+    EEPROM.put(RAW_START, raw_state);
+  });
+  micro::measure("slot ring save", [&] {
+    step(&ring_state, i++);
+    micro::keep(ring.save(RING_START));
+  });
+  micro::measure("slot ring scan", [&] {
+    micro::keep(ring.hasSave(RING_START));
+  });
+});
@@ -0,0 +1,72 @@
+// log queue: std::vector<std::string> stack (previous LoggerController log stacks) vs. LoggerQueue ring buffer
+
+#include "micro.h"
+#include "LoggerQueue.h"
+#include <malloc.h>
+#include <string>
+
+static size_t heapUsed() {
+  struct mallinfo2 info = mallinfo2();
+  return(info.uordblks + info.hblkhd);
+}
+
+// data logs of varying length (like different components)
+static std::vector<std::string> makeLogs() {
+  std::vector<std::string> logs;
+  const char* item = ",{\"i\":2,\"k\":\"relay\",\"v\":0,\"u\":\"power\",\"n\":1,\"to\":0}";
+  for (int n = 1; n <= 11; n++) {
+    std::string log = "{\"id\":\"swiss\",\"dt\":\"2022-07-01 00:00:00 UTC\",\"d\":[";
+    for (int i = 0; i < n; i++) log += (i == 0 ? item + 1 : item);
+    log += "]}";
+    logs.push_back(log);
+  }
+  return(logs);
+}
+
+static uint8_t queue_buffer[32768];
+
+static micro::Benchmark queue("queue", [] {
+
+  std::vector<std::string> logs = makeLogs();
+  const size_t cycles = 50000;
+  const size_t backlog = 50; // logs waiting during the cycles
+
+  // heap usage across enqueue/dequeue cycles
+  {
+    std::vector<std::string> stack;
+    size_t before = heapUsed();
+    for (size_t i = 0; i < cycles; i++) {
+      stack.push_back(logs[i % logs.size()]);
+      if (stack.size() > backlog) stack.pop_back();
+    }
+    printf("  vector stack: heap %+ld bytes after %zu cycles (%zu logs waiting)\n", (long) heapUsed() - (long) before, cycles, stack.size());
+  }
+  {
+    LoggerQueue queue(queue_buffer);
+    size_t before = heapUsed();
+    size_t max_used = 0;
+    for (size_t i = 0; i < cycles; i++) {
+      queue.push(logs[i % logs.size()].c_str());
+      if (queue.getCount() > backlog) queue.pop();
+      if (queue.getBytesUsed() > max_used) max_used = queue.getBytesUsed();
+    }
+    printf("  ring queue:   heap %+ld bytes after %zu cycles (%zu logs waiting, max %zu of %zu bytes used, %lu dropped)\n",
+      (long) heapUsed() - (long) before, cycles, queue.getCount(), max_used, queue.getSize(), queue.getDropped());
+    micro::check(heapUsed() == before && queue.getDropped() == 0, "queue: no heap growth, nothing dropped");
+  }
+
+  // cost of queueing and publishing (removing) one log
+  std::vector<std::string> stack;
+  size_t i = 0;
+  micro::measure("push + pop (std::vector<std::string>)", [&] {
+    stack.push_back(logs[i++ % logs.size()].c_str());
+    if (stack.size() > backlog) stack.pop_back();
+    micro::keep(stack.back()[0]);
+  });
+  LoggerQueue queue(queue_buffer);
+  micro::measure("push + pop (LoggerQueue)", [&] {
+    queue.push(logs[i++ % logs.size()].c_str());
+    if (queue.getCount() > backlog) queue.pop();
+    micro::keep(queue.front()[0]);
+  });
+});
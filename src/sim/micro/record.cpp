@@ -0,0 +1,132 @@
+// binary sd data logs: round trip of random data logs through LoggerRecord frames and the sd-decode decoder
+// (decoded JSON must be the same text as the logger's JSON data log) plus bytes and cost per log
+
+#include "micro.h"
+#include "sim.h"
+#include "LoggerController.h"
+#include "LoggerRecordDecoder.h"
+#include <random>
+
+#define LOGS 20000
+
+static std::mt19937 rng(12);
+
+// random value of a random magnitude (incl. ones that round to -0 and ones too large for exact digits)
+static double randomValue() {
+  std::uniform_real_distribution<double> mantissa(-10, 10);
+  std::uniform_int_distribution<int> exponent(-6, 17);
+  return(mantissa(rng) * pow(10.0, exponent(rng)));
+}
+
+// data of a logger (decimals incl. ones outside the fast print range)
+static std::vector<LoggerData> setupData() {
+  std::vector<LoggerData> data;
+  data.push_back(LoggerData(1, "temp", "C", 2));
+  data.push_back(LoggerData(2, "pressure", "hPa", 1));
+  data.push_back(LoggerData(3, "flow", "mL/min", 4));
+  data.push_back(LoggerData(4, "counts", "#", -2));
+  data.push_back(LoggerData(5, "weight", "g", 12));
+  data.push_back(LoggerData(6, "valve", "pos", 0));
+  return(data);
+}
+
+// random readings since the last log
+static void collect(std::vector<LoggerData>& data) {
+  std::uniform_int_distribution<int> readings(0, 20);
+  for (LoggerData& d : data) {
+    d.clear(true);
+    int n = readings(rng);
+    double center = randomValue();
+    for (int i = 0; i < n; i++) {
+      d.setNewestValue(center * (1 + 0.01 * (rng() % 100) / 100.));
+      d.setNewestDataTime(millis());
+      d.saveNewestValue(true);
+      sim::advance(rng() % 2000);
+    }
+  }
+}
+
+// data log as the controller assembles it (JSON + binary record)
+// @return frame length
+static size_t assemble(std::vector<LoggerData>& data, bool common, LoggerTime* timestamp, std::string* json, LoggerRecord* items = 0, char* frame = 0, size_t frame_size = 0) {
+  std::string d;
+  if (items) items->reset();
+  int first = -1;
+  for (size_t i = 0; i < data.size(); i++) {
+    if (!data[i].assembleLog(!common)) continue;
+    if (first < 0) first = i;
+    if (!d.empty()) d += ",";
+    d += data[i].json;
+    if (items) items->addData(data[i].idx, data[i].getN(), data[i].getDecimals(), data[i].getValue(), data[i].getStdDev(), !common, millis() - data[i].getDataTime());
+  }
+  char log[DATA_LOG_MAX_CHAR];
+  unsigned long common_time = (first >= 0) ? millis() - data[first].getDataTime() : 0;
+  common ?
+    snprintf(log, sizeof(log), PATTERN_DATA_LOG_TO_JSON, "swiss", timestamp->getDateTime(), common_time, d.c_str()) :
+    snprintf(log, sizeof(log), PATTERN_DATA_LOG_JSON, "swiss", timestamp->getDateTime(), d.c_str());
+  *json = log;
+  if (!items) return(0);
+  uint8_t fields_buffer[24];
+  LoggerRecord fields{fields_buffer};
+  fields.add(RECORD_DATA_LOG);
+  fields.addVarint(timestamp->getEpoch());
+  fields.addVarint(common ? common_time + 1ULL : 0);
+  return(LoggerRecord::encodeFrame(frame, frame_size, fields, *items));
+}
+
+static micro::Benchmark record("record", [] {
+
+  std::vector<LoggerData> data = setupData();
+  LoggerTime timestamp;
+  LoggerRecordDecoder decoder;
+
+  // header
+  uint8_t record_buffer[RECORD_MAX_SIZE];
+  LoggerRecord items{record_buffer};
+  char frame[RECORD_FRAME_SIZE];
+  items.add(RECORD_HEADER);
+  items.addVarint(RECORD_VERSION);
+  items.addString("swiss");
+  for (LoggerData& d : data) {
+    items.addSigned(d.idx);
+    items.addString(d.variable);
+    items.addString(d.units);
+  }
+  size_t header_bytes = LoggerRecord::encodeFrame(frame, sizeof(frame), items);
+  uint8_t decoded[RECORD_MAX_SIZE + 32];
+  size_t decoded_length = 0;
+  LoggerRecordReader::decodeFrame((uint8_t*) frame, header_bytes, decoded, sizeof(decoded), &decoded_length);
+  std::string json, decoded_json;
+  decoder.decode(decoded, decoded_length, &decoded_json);
+
+  // round trip
+  unsigned long mismatches = 0, zero_bytes = 0;
+  size_t json_bytes = 0, binary_bytes = header_bytes;
+  for (int i = 0; i < LOGS; i++) {
+    collect(data);
+    bool common = i % 2;
+    size_t frame_length = assemble(data, common, &timestamp, &json, &items, frame, sizeof(frame));
+    if (frame_length == 0 || strlen(frame) != frame_length) zero_bytes++;
+    json_bytes += json.length() + 2; // + CRLF
+    binary_bytes += frame_length;
+    size_t read = LoggerRecordReader::decodeFrame((uint8_t*) frame, frame_length, decoded, sizeof(decoded), &decoded_length);
+    if (read != frame_length || !decoder.decode(decoded, decoded_length, &decoded_json) || decoded_json != json) {
+      if (mismatches++ < 3) printf("  mismatch:\n    %s\n    %s\n", json.c_str(), decoded_json.c_str());
+    }
+  }
+  printf("  round trip: %d data logs, %lu mismatches, %lu frames with 0 bytes\n", LOGS, mismatches, zero_bytes);
+  micro::check(mismatches == 0 && zero_bytes == 0, "record: binary round trip");
+  printf("  JSON lines %zu bytes, binary records %zu bytes (%.1f vs. %.1f bytes per log): %.1fx smaller\n",
+    json_bytes, binary_bytes, (double) json_bytes / LOGS, (double) binary_bytes / LOGS, (double) json_bytes / binary_bytes);
+
+  // cost of the binary record on top of the JSON log
+  collect(data);
+  micro::measure("JSON data log", [&] {
+    assemble(data, false, &timestamp, &json);
+    micro::keep(json);
+  });
+  micro::measure("JSON data log + binary record", [&] {
+    assemble(data, false, &timestamp, &json, &items, frame, sizeof(frame));
+    micro::keep(frame[0]);
+  });
+});
@@ -0,0 +1,111 @@
+// sd log file rotation: data logs over several days go into day files split at the size cap,
+// the day's index finds the log file and offset for a point in time without scanning the logs
+
+#include "micro.h"
+#include "sim.h"
+#include "LoggerSD.h"
+#include "LoggerTime.h"
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+#define DAYS 3
+#define LOGS_PER_DAY 12000
+
+static std::string readFile(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  std::stringstream content;
+  content << file.rdbuf();
+  return(content.str());
+}
+
+// index entries of a day
+struct Entry {
+  std::string file;
+  unsigned long time;
+  long offset;
+};
+
+static std::vector<Entry> readIndex(LoggerSD* card, time_t day) {
+  char index_file[13];
+  card->getIndexFileName(day, index_file, sizeof(index_file));
+  std::vector<Entry> entries;
+  std::istringstream index(readFile(sim::sdDirectory() + "/" + index_file));
+  Entry entry;
+  while (index >> entry.file >> entry.time >> entry.offset) entries.push_back(entry);
+  return(entries);
+}
+
+static micro::Benchmark rotation("rotation", [] {
+
+  // fresh card
+  char dir[] = "/tmp/sim-XXXXXX";
+  if (mkdtemp(dir) == 0) return;
+  sim::setStorage(dir);
+  LoggerSD* card = new LoggerSD();
+  card->init();
+  LoggerTime timestamp;
+
+  // start at midnight, spread the logs over the days
+  sim::advance((86400 - Time.now() % 86400) * 1000UL);
+  time_t start = Time.now();
+  std::string item = ",{\"i\":2,\"k\":\"relay\",\"v\":0,\"u\":\"power\",\"n\":1,\"to\":0}";
+  char line[200];
+  for (int i = 0; i < DAYS * LOGS_PER_DAY; i++) {
+    snprintf(line, sizeof(line), "{\"id\":\"swiss\",\"dt\":\"%s\",\"d\":[%s]}", timestamp.getDateTime(), item.c_str() + 1);
+    card->appendLine(SD_DATA_LOG, line);
+    sim::advance(86400000UL / LOGS_PER_DAY);
+    card->update();
+  }
+  card->flush();
+
+  // files and index entries per day
+  unsigned long errors = 0;
+  for (int d = 0; d < DAYS; d++) {
+    time_t day = start + d * 86400;
+    std::vector<Entry> entries = readIndex(card, day);
+    printf("  %s: ", Time.format(day, "%Y-%m-%d").c_str());
+    for (uint8_t part = 0; part < strlen(SD_LOG_FILE_PARTS); part++) {
+      char file_name[13];
+      card->getLogFileName(SD_DATA_LOG, day, part, file_name, sizeof(file_name));
+      struct stat info;
+      if (stat((sim::sdDirectory() + "/" + file_name).c_str(), &info) != 0) break;
+      printf("%s (%ld bytes) ", file_name, (long) info.st_size);
+      if (info.st_size > SD_LOG_FILE_MAX_SIZE) errors++;
+    }
+    printf("- %zu index entries\n", entries.size());
+    // every entry points at the start of the log line of its time
+    for (Entry& entry : entries) {
+      std::string logs = readFile(sim::sdDirectory() + "/" + entry.file);
+      std::string expected = "{\"id\":\"swiss\",\"dt\":\"" + std::string(Time.format(entry.time, DATE_TIME_FORMAT).c_str());
+      if (logs.compare(entry.offset, expected.length(), expected) != 0) errors++;
+    }
+  }
+  printf("  index check: %lu errors\n", errors);
+  micro::check(errors == 0, "rotation: file sizes and index entries");
+
+  // find the logs of a point in time in the afternoon of the second day: index vs. scanning the day's files
+  time_t wanted = start + 86400 + 15 * 3600;
+  std::string wanted_dt = "\"dt\":\"" + std::string(Time.format(wanted, "%Y-%m-%d %H").c_str());
+  std::vector<Entry> entries = readIndex(card, wanted);
+  Entry from = entries[0];
+  for (Entry& entry : entries) if (entry.time <= (unsigned long) wanted) from = entry;
+  std::string logs = readFile(sim::sdDirectory() + "/" + from.file);
+  size_t found = logs.find(wanted_dt, from.offset);
+  size_t scanned = 0;
+  for (uint8_t part = 0; part < strlen(SD_LOG_FILE_PARTS); part++) {
+    char file_name[13];
+    card->getLogFileName(SD_DATA_LOG, wanted, part, file_name, sizeof(file_name));
+    std::string part_logs = readFile(sim::sdDirectory() + "/" + file_name);
+    size_t pos = part_logs.find(wanted_dt);
+    if (pos != std::string::npos) {
+      scanned += pos;
+      break;
+    }
+    scanned += part_logs.length();
+  }
+  printf("  logs of %s:00 found in %s after reading %zu bytes with the index vs. %zu bytes scanning the day's files\n",
+    Time.format(wanted, "%Y-%m-%d %H").c_str(), from.file.c_str(), found - from.offset, scanned);
+  micro::check(found != std::string::npos, "rotation: logs found with the index");
+  delete card;
+});
@@ -0,0 +1,54 @@
+// sd card log lines: append + println + syncFile per line (previous saveDataLogToSD) vs. LoggerSD write-behind buffer
+// reports the i2c traffic to the OpenLog stand-in per logged line (the bus time blocks the loop on the device)
+
+#include "micro.h"
+#include "sim.h"
+#include "LoggerSD.h"
+
+#define LINES 1000
+
+// typical data log line
+static const char* line = "{\"id\":\"swiss\",\"dt\":\"2022-07-01 00:00:00 UTC\",\"d\":[{\"i\":2,\"k\":\"relay\",\"v\":0,\"u\":\"power\",\"n\":1,\"to\":0},{\"i\":3,\"k\":\"relay\",\"v\":1,\"u\":\"bypass\",\"n\":1,\"to\":0}]}";
+
+struct Traffic {
+  unsigned long transactions;
+  unsigned long bytes;
+  unsigned long long bus_us;
+};
+
+// i2c traffic of writing the lines
+static Traffic traffic(std::function<void()> write) {
+  unsigned long transactions = sim::stats.i2c_transactions, bytes = sim::stats.i2c_bytes;
+  unsigned long long start = sim::now_us();
+  write();
+  Traffic t = {sim::stats.i2c_transactions - transactions, sim::stats.i2c_bytes - bytes, sim::now_us() - start};
+  return(t);
+}
+
+static void report(const char* label, Traffic t) {
+  printf("  %-40s %8.1f i2c tx %8.1f bytes %8.2f ms bus time per line\n", label,
+    (double) t.transactions / LINES, (double) t.bytes / LINES, t.bus_us / 1000. / LINES);
+}
+
+static micro::Benchmark sd("sd", [] {
+  LoggerSD* card = new LoggerSD();
+  card->init();
+  Traffic before = traffic([card] {
+    for (int i = 0; i < LINES; i++) {
+      card->append("data.log");
+      card->println(line);
+      card->syncFile();
+    }
+  });
+  Traffic after = traffic([card] {
+    for (int i = 0; i < LINES; i++) card->appendLine(SD_DATA_LOG, line);
+    card->flush();
+  });
+  printf("  %d data log lines of %zu bytes\n", LINES, strlen(line));
+  report("append + println + syncFile", before);
+  report("LoggerSD::appendLine (write-behind)", after);
+  printf("  i2c transactions: %.1fx fewer, bus time: %.1fx less\n",
+    (double) before.transactions / after.transactions, (double) before.bus_us / after.bus_us);
+  micro::check(after.transactions < before.transactions, "sd: fewer i2c transactions");
+  delete card;
+});
@@ -0,0 +1,111 @@
+// sd card log spool: i2c traffic per spooled log, and the position restored after a power loss (logs spooled after
+// the last index save, an index save cut off by the power loss, a log line cut off by the power loss)
+
+#include "micro.h"
+#include "sim.h"
+#include "LoggerSpool.h"
+
+#define LOGS 100
+
+static const char* log_text = "{\"id\":\"swiss\",\"dt\":\"2022-07-01 00:00:00 UTC\",\"d\":[{\"i\":2,\"k\":\"relay\",\"v\":0,\"u\":\"power\",\"n\":1,\"to\":0}],\"nr\":%d}";
+
+// number of the log (n) at the front of the spool, -1 if there is none
+static int frontNumber(LoggerSpool* spool) {
+  char type;
+  const char* log = spool->front(&type);
+  const char* n = (log != 0) ? strstr(log, "\"nr\":") : 0;
+  return((n != 0) ? atoi(n + 5) : -1);
+}
+
+static bool pushLog(LoggerSpool* spool, int i) {
+  char text[200];
+  snprintf(text, sizeof(text), log_text, i);
+  return(spool->push(SPOOL_TYPE_DATA, text));
+}
+
+static micro::Benchmark spool("spool", [] {
+
+  // empty card
+  LoggerSD* card = new LoggerSD();
+  card->init();
+  char file_name[20];
+  for (int i = 0; i < 2; i++) {
+    snprintf(file_name, sizeof(file_name), SPOOL_INDEX_FILE, i);
+    card->removeFile(file_name);
+  }
+  for (int i = 1; i < 100; i++) {
+    snprintf(file_name, sizeof(file_name), "SP%06d.LOG", i);
+    if (card->size(file_name) < 0) break;
+    card->removeFile(file_name);
+  }
+
+  // spooled logs
+  LoggerSpool* spool = new LoggerSpool(card);
+  spool->init();
+  unsigned long transactions = sim::stats.i2c_transactions;
+  int pushed = 0;
+  for (int i = 0; i < LOGS; i++) if (pushLog(spool, i)) pushed++;
+  printf("  %d/%d logs spooled, %.1f i2c tx per log\n", pushed, LOGS, (double) (sim::stats.i2c_transactions - transactions) / LOGS);
+
+  // power loss before any index save
+  delete spool;
+  spool = new LoggerSpool(card);
+  spool->init();
+  printf("  power loss before the first index save: %lu logs restored, front #%d\n", spool->getCount(), frontNumber(spool));
+  micro::check(spool->getCount() == LOGS && frontNumber(spool) == 0, "spool: logs counted from the segment files");
+
+  // logs taken from the spool (index saved) and more spooled (not saved)
+  for (int i = 0; i < 30; i++) {
+    frontNumber(spool);
+    spool->pop();
+  }
+  for (int i = LOGS; i < LOGS + 10; i++) pushLog(spool, i);
+  delete spool;
+  spool = new LoggerSpool(card);
+  spool->init();
+  printf("  power loss after 30 logs were taken and 10 more spooled: %lu logs restored, front #%d\n", spool->getCount(), frontNumber(spool));
+  micro::check(spool->getCount() == LOGS - 20 && frontNumber(spool) == 30, "spool: position restored");
+
+  // power loss in the middle of the next index save (the newer copy is cut off)
+  spool->pop();
+  char index[2][80] = {{0}};
+  for (int i = 0; i < 2; i++) {
+    snprintf(file_name, sizeof(file_name), SPOOL_INDEX_FILE, i);
+    card->read((uint8_t*) index[i], card->size(file_name), file_name);
+  }
+  int newest = (atol(index[1]) > atol(index[0])) ? 1 : 0;
+  snprintf(file_name, sizeof(file_name), SPOOL_INDEX_FILE, newest);
+  card->removeFile(file_name);
+  card->append(file_name);
+  index[newest][strlen(index[newest]) / 2] = 0;
+  card->writeString(index[newest]);
+  card->syncFile();
+  delete spool;
+  spool = new LoggerSpool(card);
+  spool->init();
+  printf("  power loss during an index save: %lu logs restored, front #%d (the log before is published again)\n", spool->getCount(), frontNumber(spool));
+  micro::check(spool->getCount() == LOGS - 20 && frontNumber(spool) == 30, "spool: older index copy used");
+
+  // power loss in the middle of a log line (appended to the last segment)
+  int segment = 1;
+  while (snprintf(file_name, sizeof(file_name), "SP%06d.LOG", segment + 1) > 0 && card->size(file_name) >= 0) segment++;
+  snprintf(file_name, sizeof(file_name), "SP%06d.LOG", segment);
+  card->append(file_name);
+  card->writeString("D {\"id\":\"swi");
+  card->syncFile();
+  delete spool;
+  spool = new LoggerSpool(card);
+  spool->init();
+  pushLog(spool, LOGS + 10);
+  int last = -1;
+  while (!spool->isEmpty()) {
+    last = frontNumber(spool);
+    spool->pop();
+  }
+  printf("  power loss during a log line: last log #%d\n", last);
+  micro::check(last == LOGS + 10, "spool: log line cut off by a power loss skipped");
+
+  micro::measure("spool a data log", [&] { pushLog(spool, 0); });
+  delete spool;
+  delete card;
+});
@@ -0,0 +1,129 @@
+// schedules loaded at runtime: a schedule read from the sd card and one uploaded event by event with commands (same
+// events as compiled in), restored after a reboot, invalid lines and event codes rejected, a switch requested during a
+// run applied once the run is finished, and the cost of parsing a schedule
+
+#include "micro.h"
+#include "fixture.h"
+#include <fstream>
+#include <sstream>
+
+// the same schedule as a file (with a comment and an empty line)
+static const char* schedule_file =
+  "# swiss sampling\n"
+  "10 s 1 start\n10 s 3 flush internal\n15 m 4 flush probe\n10 m 5 flush flask\n45 m 6 END! 25cm\n"
+  "1 m 7 flush probe\n10 m 8 flush flask\n45 m 9 END! 50cm\n1 m 10 flush probe\n10 m 11 flush flask\n"
+  "\n45 m 12 END! 75 cm\n1 m 13 final clean\n1 m 2 complete\n";
+
+// short schedule for the switch during a run
+static const char* short_schedule[] = {"2 s 1 start", "3 s 2 complete"};
+
+// scheduler that knows event codes 1-13 and records the ones it runs
+class TableScheduler : public SchedulerLoggerComponent {
+
+  public:
+
+    std::vector<uint8_t> ran;
+
+    TableScheduler(const char* id, LoggerController* ctrl) : SchedulerLoggerComponent(id, ctrl, new SchedulerState(), SCHEDULER_DT_PATTERN_YMD_24HM, swiss_schedule, SWISS_EVENTS) {}
+
+    void runEvent(uint8_t event) { ran.push_back(event); }
+    bool isValidEvent(uint8_t event) { return(event >= 1 && event <= 13); }
+
+    // test run with 1 second waits
+    void run() {
+      testSchedule(1);
+      startSchedule();
+      for (int i = 0; i < 1000 && testing; i++) {
+        sim::advance(100);
+        runSchedule();
+      }
+    }
+
+};
+
+typedef SchedulerUnit<TableScheduler, true> TableUnit;
+
+// same events (code, wait, label) as compiled in
+static bool same(TableScheduler* scheduler) {
+  if (scheduler->getScheduleLength() != SWISS_EVENTS || scheduler->getSchedule() == swiss_schedule) return(false);
+  for (uint8_t i = 0; i < SWISS_EVENTS; i++) {
+    const SchedulerEvent* event = scheduler->getSchedule() + i;
+    if (event->event != swiss_schedule[i].event || event->wait != swiss_schedule[i].wait || strcmp(event->label, swiss_schedule[i].label) != 0) return(false);
+  }
+  return(true);
+}
+
+static micro::Benchmark table("table", [] {
+
+  // fresh card and EEPROM
+  char dir[] = "/tmp/sim-XXXXXX";
+  if (mkdtemp(dir) == 0) return;
+  sim::setStorage(dir);
+  sim::loadEEPROM(0);
+  std::ofstream(sim::sdDirectory() + "/SWISS.SCH") << schedule_file;
+
+  // from a file
+  TableUnit unit;
+  int load_ret = unit.controller->receiveCommand("s1 load SWISS.SCH");
+  printf("  's1 load SWISS.SCH': return code %d, %d events, same as compiled: %s\n",
+    load_ret, unit.scheduler->getScheduleLength(), same(unit.scheduler) ? "yes" : "NO");
+  micro::check(load_ret == CMD_RET_SUCCESS && same(unit.scheduler), "table: loaded from a file");
+
+  // uploaded with commands (one event per command)
+  int add_errors = 0;
+  std::istringstream lines(schedule_file);
+  std::string line;
+  while (std::getline(lines, line)) {
+    if (line.empty() || line[0] == '#') continue;
+    if (unit.controller->receiveCommand(("s1 add " + line).c_str()) != CMD_RET_SUCCESS) add_errors++;
+  }
+  int use_ret = unit.controller->receiveCommand("s1 use");
+  printf("  %d x 's1 add ...' (%d errors) + 's1 use': return code %d, same as compiled: %s\n",
+    (int) SWISS_EVENTS, add_errors, use_ret, same(unit.scheduler) ? "yes" : "NO");
+  micro::check(add_errors == 0 && use_ret == CMD_RET_SUCCESS && same(unit.scheduler), "table: uploaded with commands");
+
+  // restored after a reboot
+  TableUnit rebooted(true);
+  printf("  after a reboot: %s\n", same(rebooted.scheduler) ? "restored from S1.SCH" : "NOT RESTORED");
+  micro::check(same(rebooted.scheduler), "table: restored after a reboot");
+
+  // invalid lines and event codes
+  const char* invalid[] = {"s1 add 10 x 1 start", "s1 add 10 s 99 start", "s1 add 10 s 1", "s1 add 30 d 1 start", "s1 add ten s 1 start"};
+  int rejected = 0;
+  for (const char* text : invalid) if (rebooted.controller->receiveCommand(text) == CMD_RET_ERR_SCHEDULE_INVALID) rejected++;
+  int empty_ret = rebooted.controller->receiveCommand("s1 use");
+  int missing_ret = rebooted.controller->receiveCommand("s1 load NONE.SCH");
+  printf("  %d/%d invalid event lines rejected, 's1 use' without events: %d, 's1 load NONE.SCH': %d (%d)\n",
+    rejected, (int) (sizeof(invalid) / sizeof(invalid[0])), empty_ret, missing_ret, CMD_RET_ERR_SCHEDULE_INVALID);
+  micro::check(rejected == (int) (sizeof(invalid) / sizeof(invalid[0])) && empty_ret == CMD_RET_ERR_SCHEDULE_INVALID &&
+    missing_ret == CMD_RET_ERR_SCHEDULE_INVALID, "table: invalid lines rejected");
+
+  // switch during a run: applied once the run is finished
+  TableScheduler* scheduler = rebooted.scheduler;
+  for (const char* text : short_schedule) scheduler->addScheduleEvent(text);
+  scheduler->testSchedule(1);
+  scheduler->startSchedule();
+  scheduler->useNextSchedule();
+  uint8_t during = scheduler->getScheduleLength();
+  int pending_ret = rebooted.controller->receiveCommand("s1 add 1 s 1 start");
+  for (int i = 0; i < 1000 && scheduler->isScheduleInUse(); i++) {
+    sim::advance(100);
+    scheduler->runSchedule();
+  }
+  size_t full_run = scheduler->ran.size();
+  scheduler->ran.clear();
+  scheduler->run();
+  printf("  switch requested during a run: %d events until the run finished (%zu run, 'add' meanwhile: %d), then %d events (%zu run)\n",
+    during, full_run, pending_ret, scheduler->getScheduleLength(), scheduler->ran.size());
+  micro::check(during == SWISS_EVENTS && full_run == SWISS_EVENTS && pending_ret == CMD_RET_ERR_SCHEDULE_PENDING &&
+    scheduler->getScheduleLength() == 2 && scheduler->ran.size() == 2, "table: switch after the run");
+  int default_ret = rebooted.controller->receiveCommand("s1 default");
+  printf("  's1 default': return code %d, compiled schedule: %s\n", default_ret, scheduler->getSchedule() == swiss_schedule ? "yes" : "NO");
+  micro::check(default_ret == CMD_RET_SUCCESS && scheduler->getSchedule() == swiss_schedule, "table: back to the compiled schedule");
+
+  // cost
+  SchedulerTable parsed;
+  micro::measure("parse a 13 event schedule file", [&] { micro::keep(parsed.parse(schedule_file)); });
+  micro::measure("add an event line", [&] { parsed.clear(); micro::keep(parsed.add("45 m 12 END! 75 cm")); });
+  sim::loadEEPROM(0);
+});
@@ -0,0 +1,122 @@
+// timer wheel: random one-shot and periodic timers (some beyond the span of the wheel, some cancelled or moved) all
+// handed out on the first pass at or after they are due, and the cost of a loop pass with 1, 10 and 50 timed
+// components that check their own clock on every pass vs. register a timer with the controller
+
+#include "micro.h"
+#include "sim.h"
+#include "LoggerController.h"
+#include "LoggerDisplay.h"
+#include "LoggerComponent.h"
+
+#define N_TIMERS    2000
+#define PERIOD_MS   60000 // timed components: something to do once a minute
+
+// component that checks its own clock on every loop pass
+class PolledComponent : public LoggerComponent {
+
+  public:
+
+    unsigned long last = 0;
+    unsigned long runs = 0;
+
+    PolledComponent(const char* id, LoggerController* ctrl) : LoggerComponent(id, ctrl, false, false) {}
+
+    void update() {
+      if (millis() - last >= PERIOD_MS) {
+        last += PERIOD_MS;
+        runs++;
+      }
+    }
+
+};
+
+// component that registers a periodic timer
+class TimedComponent : public LoggerComponent {
+
+  public:
+
+    LoggerTimer timer{this};
+    unsigned long runs = 0;
+
+    TimedComponent(const char* id, LoggerController* ctrl) : LoggerComponent(id, ctrl, false, false) {}
+
+    bool isPolled() { return(false); }
+    void handleTimer(LoggerTimer* timer) { runs++; }
+
+};
+
+static LoggerController* build() {
+  LoggerController* controller = new LoggerController("micro", A0, new LoggerControllerState(false, -6, false, false, false, 60, LOG_BY_TIME, 200, 10000), false);
+  controller->setDisplay(new LoggerDisplay(controller, 16, 2, 2));
+  return(controller);
+}
+
+static uint32_t seed = 4711;
+static uint32_t random_below(uint32_t n) {
+  seed = seed * 1103515245 + 12345;
+  return(((seed >> 8) ^ (seed << 13)) % n);
+}
+
+static micro::Benchmark timers("timers", [] {
+
+  // random timers: handed out when due, never early, never missed
+  LoggerTimers wheel;
+  std::vector<LoggerTimer> timers(N_TIMERS);
+  std::vector<uint32_t> due(N_TIMERS); // when each timer is due (0 = not pending)
+  for (size_t i = 0; i < N_TIMERS; i++) {
+    uint32_t delay = (i % 10 == 0) ? random_below(10 * 3600000) : random_below(600000); // 10% up to 10 hours
+    uint32_t period = (i % 7 == 0) ? 1 + random_below(120000) : 0;
+    wheel.add(&timers[i], millis() + delay, period);
+    due[i] = timers[i].expires;
+  }
+  unsigned long fired = 0, early = 0, late = 0, missed = 0, passes = 0;
+  uint32_t previous = millis(), end = millis() + 12 * 3600000UL;
+  while ((int32_t) (end - millis()) > 0) {
+    sim::advance(1 + random_below(passes % 1000 == 999 ? 5000 : 100));
+    uint32_t now = millis();
+    LoggerTimer* timer;
+    while ((timer = wheel.next(now)) != 0) {
+      size_t i = timer - &timers[0];
+      fired++;
+      if ((int32_t) (due[i] - now) > 0) early++;
+      if ((int32_t) (due[i] - previous) <= 0) late++; // was already due on the previous pass
+      due[i] = timer->isPending() ? timer->expires : 0;
+      // move or cancel a few
+      if (random_below(20) == 0) {
+        uint32_t j = random_below(N_TIMERS);
+        if (random_below(2) == 0) {
+          wheel.cancel(&timers[j]);
+          due[j] = 0;
+        } else {
+          wheel.add(&timers[j], now + random_below(3600000), timers[j].period);
+          due[j] = timers[j].expires;
+        }
+      }
+    }
+    for (size_t i = 0; i < N_TIMERS; i++) if (due[i] != 0 && (int32_t) (due[i] - now) <= 0) missed++;
+    previous = now;
+    passes++;
+  }
+  printf("  %d timers over 12 h (%lu passes): %lu runs, %lu early, %lu late, %lu missed, %zu still pending\n",
+    N_TIMERS, passes, fired, early, late, missed, wheel.getPending());
+  micro::check(early == 0 && late == 0 && missed == 0, "timers: every timer on time");
+
+  // loop pass with timed components
+  for (int n : {1, 10, 50}) {
+    LoggerController* polled = build();
+    LoggerController* timed = build();
+    char id[12];
+    for (int i = 0; i < n; i++) {
+      snprintf(id, sizeof(id), "c%d", i);
+      polled->addComponent(new PolledComponent(strdup(id), polled));
+      TimedComponent* component = new TimedComponent(strdup(id), timed);
+      timed->addComponent(component);
+      timed->timers.addIn(&component->timer, PERIOD_MS, PERIOD_MS);
+    }
+    char label[60];
+    snprintf(label, sizeof(label), "%d components, polled on every pass", n);
+    micro::measure(label, [&] { sim::advanceMicros(1000); polled->updateTimers(); polled->updateComponents(); });
+    snprintf(label, sizeof(label), "%d components, timer wheel", n);
+    micro::measure(label, [&] { sim::advanceMicros(1000); timed->updateTimers(); timed->updateComponents(); });
+  }
+});
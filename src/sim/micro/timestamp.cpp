@@ -0,0 +1,34 @@
+// log date time: Time.format per log (previous log/variable assembly) vs. LoggerTime (formatted once per second)
+
+#include "micro.h"
+#include "sim.h"
+#include "LoggerTime.h"
+
+// virtual time between logs (several logs per second like a data log of all components)
+#define LOG_SPACING_MS 100
+
+static char date_time_buffer[25];
+
+static void formatEveryLog() {
+  sim::advance(LOG_SPACING_MS);
+  Time.format(Time.now(), "%Y-%m-%d %H:%M:%S %Z").toCharArray(date_time_buffer, sizeof(date_time_buffer));
+  micro::keep(date_time_buffer[0]);
+}
+
+static LoggerTime timestamp;
+
+static void formatCached() {
+  sim::advance(LOG_SPACING_MS);
+  const char* date_time = timestamp.getDateTime();
+  micro::keep(date_time);
+}
+
+static micro::Benchmark time_format("timestamp", [] {
+  formatEveryLog();
+  formatCached();
+  printf("  date time: '%s' vs. '%s' (one log every %d ms)\n", date_time_buffer, timestamp.getDateTime(), LOG_SPACING_MS);
+  micro::check(strcmp(date_time_buffer, timestamp.getDateTime()) == 0, "timestamp: same date time");
+  double before = micro::measure("log date time (Time.format)", formatEveryLog);
+  double after = micro::measure("log date time (LoggerTime)", formatCached);
+  printf("  speedup: %.1fx\n", before / after);
+});
@@ -0,0 +1,71 @@
+/**
+ * Controls for the host simulation: virtual clock, simulated cloud and peripheral statistics.
+ */
+
+#pragma once
+#include "application.h"
+
+namespace sim {
+
+  /*** virtual clock ***/
+
+  unsigned long long now_us(); // virtual time since boot (in us)
+  void advanceMicros(unsigned long long us); // move the virtual clock forward
+  void advance(unsigned long ms); // move the virtual clock forward
+  void setEpoch(time_t epoch); // wall-clock time at boot (UTC)
+
+  /*** console ***/
+
+  extern bool echo_serial; // whether USB serial output is printed to stdout
+  extern bool echo_publish; // whether published events are printed to stdout
+  extern bool console_input; // whether USB serial input is read from stdin
+  bool isConsoleDone(); // whether stdin is closed and all of it was read
+
+  /*** cloud ***/
+
+  void setNetwork(bool up); // make the network (un)reachable
+  bool isNetworkUp();
+  extern unsigned long connect_ms; // how long a cloud connection takes to establish
+  extern unsigned long publish_ack_ms; // round trip until a WITH_ACK publish is acknowledged
+  extern const char* device_name; // device name returned by the name handler
+  int callFunction(const char* name, const char* arg); // cloud function call, returns -1 if not registered
+  const char* getVariable(const char* name); // cloud variable, returns 0 if not registered
+
+  /*** serial1 device ***/
+
+  // called for every byte the firmware writes to Serial1, reply with Serial1.inject()
+  extern std::function<void(uint8_t)> serial1_device;
+
+  /*** persistence ***/
+
+  // directory for the SD card contents (DIR/sd) and EEPROM image (DIR/eeprom.bin) to keep them across runs,
+  // a fresh temporary directory is used if none is set
+  void setStorage(const char* dir);
+  std::string sdDirectory();
+
+  // replace the EEPROM contents with an image (e.g. DIR/eeprom.bin of an earlier run), 0 = erased EEPROM
+  bool loadEEPROM(const char* path);
+
+  // EEPROM bytes that can still be written before a simulated power loss (later writes are lost), -1 = no power loss
+  extern long eeprom_write_budget;
+  unsigned long eepromCellWrites(int address); // writes of one EEPROM byte so far (wear)
+
+  /*** memory ***/
+
+  extern uint32_t heap_size; // simulated heap available to the application at boot (in bytes)
+  extern long heap_excluded; // host heap used by simulated peripherals (e.g. SD card contents), not counted as used
+
+  /*** statistics ***/
+
+  struct Stats {
+    unsigned long publishes = 0; // successful publishes
+    unsigned long publishes_failed = 0; // failed publishes
+    unsigned long publish_bytes = 0; // payload bytes of successful publishes
+    unsigned long i2c_transactions = 0; // i2c transactions (all addresses)
+    unsigned long i2c_bytes = 0; // i2c payload bytes (all addresses)
+    unsigned long eeprom_writes = 0; // EEPROM bytes actually written
+    unsigned long resets = 0; // system resets requested
+  };
+  extern Stats stats;
+
+}
@@ -118,117 +118,43 @@ const SchedulerEvent schedule[] = {
 const SchedulerEvent* schedule_pointer = schedule;
 const int schedule_events_number = sizeof(schedule)/sizeof(schedule[0]);
 
-// scheduler class managing thee events
-class SwissScheduler : public SchedulerLoggerComponent {
-
-  uint8_t valco_pos_25cm;
-  uint8_t valco_pos_50cm;
-  uint8_t valco_pos_75cm;
-
-  public:
-
-    SwissScheduler (const char *id, uint8_t valco_pos_25cm, uint8_t valco_pos_50cm, uint8_t valco_pos_75cm) : 
-      SchedulerLoggerComponent(id, controller, SCHEDULER_DT_PATTERN_YMD_24HM, schedule_pointer, schedule_events_number), valco_pos_25cm(valco_pos_25cm), valco_pos_50cm(valco_pos_50cm), valco_pos_75cm(valco_pos_75cm) {}
-
-    virtual void runEvent(uint8_t event) {
-      if(event == EVENT_START) {
-        // make sure evertything is on/off as needed
-        rpower->changeRelay(true);
-        rbypass->changeRelay(false);
-        r25cm->changeRelay(false);
-        r50cm->changeRelay(false);
-        r75cm->changeRelay(false);
-        valco->changeDirection(VALVE_DIR_CW);
-        valco->changePosition(1);
-        // pause state saving after this to always resume at this point if power is out
-        ctrl->pauseStateSaving(); 
-
-      } else if (event == EVENT_CLEAN) {
-        
-        //the valco is at position 1,so just open the bypass relay to start flushing internal lines
-        rbypass ->changeRelay(true);
-
-      } else if(event == EVENT_CLEAN25CM){
-        // close the bypass loop
-        rbypass->changeRelay(false);  
-        // turn relay on
-        r25cm->changeRelay(true);
-      } else if (event == EVENT_START_25CM) {
-        // move valco to sampling  position
-        valco->changeDirection(VALVE_DIR_CC);
-        valco->changePosition(valco_pos_25cm);
-      } else if (event == EVENT_END_25CM) {
-        // move valco to starting position
-        valco->changeDirection(VALVE_DIR_CW);
-        valco->changePosition(1);
-        // turn relay off
-        r25cm->changeRelay(false);
-        // resume state saving so once this event finishes it will resume here in case of power out
-        ctrl->resumeStateSaving();
-      } else if(event == EVENT_CLEAN50CM){
-        // pause state saving so it doesn't resume at a partial sampling point
-        ctrl->pauseStateSaving(); 
-        //double check the valco is HM
-        valco->changePosition(1);
-        //open the 50 cm probe
-        r50cm->changeRelay(true);
-      } else if (event == EVENT_START_50CM) {
-        // move valco sampling position
-        valco->changeDirection(VALVE_DIR_CC);
-        valco->changePosition(valco_pos_50cm);
-      } else if (event == EVENT_END_50CM) {
-        // move valco to starting position
-        valco->changeDirection(VALVE_DIR_CW);
-        valco->changePosition(1);
-        // turn relay off
-        r50cm->changeRelay(false);
-        // resume state saving so once this event finishes it will resume here in case of power out
-        ctrl->resumeStateSaving();
-      } else if (event == EVENT_CLEAN75CM){
-        // pause state saving so it doesn't resume at a partial sampling point
-        ctrl->pauseStateSaving(); 
-        //double check the valco is HM
-        valco->changeDirection(VALVE_DIR_CW);
-        valco->changePosition(1);
-        //open the 75 cm probe
-        r75cm->changeRelay(true);
-      } else if (event == EVENT_START_75CM) {
-        // move valco sampling position
-        valco->changeDirection(VALVE_DIR_CC);
-        valco->changePosition(valco_pos_75cm);
-      } else if (event == EVENT_END_75CM) {
-        // move valco to starting position
-        valco->changeDirection(VALVE_DIR_CW);
-        valco->changePosition(1);
-        // turn relay off
-        r75cm->changeRelay(false);
-        // resume state saving so once this event finishes it will resume here in case of power out
-        ctrl->resumeStateSaving();
-      } else if (event == EVENT_END_CLEAN){
-        // pause state saving so it doesn't resume at a partial sampling point
-        ctrl->pauseStateSaving(); 
-        // move valco to starting position
-        valco->changeDirection(VALVE_DIR_CW);
-        valco->changePosition(1);
-        //open bypass valve
-        rbypass->changeRelay(true);
-      } else if (event == EVENT_END) {
-        //close the bypass valve
-        rbypass->changeRelay(false);
-        // turn power back off
-        rpower->changeRelay(false);
-        // resume state saving so once this event finishes it will resume here in case of power out
-        ctrl->resumeStateSaving();
-      }
-    }
-};
+// event actions (run as one batch per event), the valco sampling positions differ by scheduler
+#define SWISS_ACTIONS(pos_25cm, pos_50cm, pos_75cm) { \
+   /* make sure evertything is on/off as needed, pause state saving after this to always resume at this point if power is out */ \
+   {EVENT_START,      "power on;bypass off;25cm off;50cm off;75cm off;valco dir cw;valco pos 1;save-state pause"}, \
+   /* the valco is at position 1, so just open the bypass relay to start flushing internal lines */ \
+   {EVENT_CLEAN,      "bypass on"}, \
+   /* close the bypass loop and open the 25 cm probe */ \
+   {EVENT_CLEAN25CM,  "bypass off;25cm on"}, \
+   /* move valco to sampling position */ \
+   {EVENT_START_25CM, "valco dir cc;valco pos " #pos_25cm}, \
+   /* move valco to starting position, close the probe and resume state saving so it resumes here in case of power out */ \
+   {EVENT_END_25CM,   "valco dir cw;valco pos 1;25cm off;save-state resume"}, \
+   /* pause state saving so it doesn't resume at a partial sampling point, double check the valco is home, open the 50 cm probe */ \
+   {EVENT_CLEAN50CM,  "save-state pause;valco pos 1;50cm on"}, \
+   {EVENT_START_50CM, "valco dir cc;valco pos " #pos_50cm}, \
+   {EVENT_END_50CM,   "valco dir cw;valco pos 1;50cm off;save-state resume"}, \
+   {EVENT_CLEAN75CM,  "save-state pause;valco dir cw;valco pos 1;75cm on"}, \
+   {EVENT_START_75CM, "valco dir cc;valco pos " #pos_75cm}, \
+   {EVENT_END_75CM,   "valco dir cw;valco pos 1;75cm off;save-state resume"}, \
+   /* pause state saving, move valco to starting position and open the bypass valve */ \
+   {EVENT_END_CLEAN,  "save-state pause;valco dir cw;valco pos 1;bypass on"}, \
+   /* close the bypass valve, turn power back off and resume state saving */ \
+   {EVENT_END,        "bypass off;power off;save-state resume"} \
+}
+const SchedulerAction s1_actions[] = SWISS_ACTIONS(2, 3, 4);
+const SchedulerAction s2_actions[] = SWISS_ACTIONS(5, 6, 7);
+const SchedulerAction s3_actions[] = SWISS_ACTIONS(8, 9, 10);
+const SchedulerAction s4_actions[] = SWISS_ACTIONS(11, 12, 13);
+const SchedulerAction s5_actions[] = SWISS_ACTIONS(14, 15, 16);
+const int actions_number = sizeof(s1_actions)/sizeof(s1_actions[0]);
 
 // schedulers: 1, 2, 3, 4, 5
-SwissScheduler* scheduler1 = new SwissScheduler("s1", 2, 3, 4);
-SwissScheduler* scheduler2 = new SwissScheduler("s2", 5, 6, 7);
-SwissScheduler* scheduler3 = new SwissScheduler("s3", 8, 9, 10);
-SwissScheduler* scheduler4 = new SwissScheduler("s4", 11, 12, 13);
-SwissScheduler* scheduler5 = new SwissScheduler("s5", 14, 15, 16);
+SchedulerLoggerComponent* scheduler1 = new SchedulerLoggerComponent("s1", controller, SCHEDULER_DT_PATTERN_YMD_24HM, schedule_pointer, schedule_events_number, s1_actions, actions_number);
+SchedulerLoggerComponent* scheduler2 = new SchedulerLoggerComponent("s2", controller, SCHEDULER_DT_PATTERN_YMD_24HM, schedule_pointer, schedule_events_number, s2_actions, actions_number);
+SchedulerLoggerComponent* scheduler3 = new SchedulerLoggerComponent("s3", controller, SCHEDULER_DT_PATTERN_YMD_24HM, schedule_pointer, schedule_events_number, s3_actions, actions_number);
+SchedulerLoggerComponent* scheduler4 = new SchedulerLoggerComponent("s4", controller, SCHEDULER_DT_PATTERN_YMD_24HM, schedule_pointer, schedule_events_number, s4_actions, actions_number);
+SchedulerLoggerComponent* scheduler5 = new SchedulerLoggerComponent("s5", controller, SCHEDULER_DT_PATTERN_YMD_24HM, schedule_pointer, schedule_events_number, s5_actions, actions_number);
 
 // lcd update callback function
 void lcd_update_callback() {
@@ -0,0 +1,142 @@
+/**
+ * Decodes the binary data log records of the SD card (LoggerRecord.h) back into the logger's
+ * JSON data logs (same text as published) or CSV rows (one per data).
+ * Host only (used by sd-decode and the record microbenchmark).
+ */
+
+#pragma once
+#include <stdio.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include "LoggerUtils.h"
+#include "LoggerRecord.h"
+
+// date time of the logs (DATE_TIME_FORMAT of the logger, logs are always in UTC)
+#define DECODER_DATE_TIME_FORMAT "%Y-%m-%d %H:%M:%S UTC"
+
+// CSV columns
+#define DECODER_CSV_HEADER "datetime,id,i,k,v,s,u,n,to"
+
+// key and units of a data idx (from the header record)
+struct LoggerRecordKey {
+  int idx;
+  std::string key;
+  std::string units;
+};
+
+class LoggerRecordDecoder {
+
+  private:
+
+    // latest header
+    bool has_header = false;
+    std::string name;
+    std::vector<LoggerRecordKey> keys;
+
+    // key of an idx (empty if not in the header)
+    const LoggerRecordKey* findKey(int idx) {
+      static const LoggerRecordKey unknown = {0, "", ""};
+      for (const LoggerRecordKey& key : keys) if (key.idx == idx) return(&key);
+      return(&unknown);
+    }
+
+    bool decodeHeader(LoggerRecordReader* reader) {
+      if (reader->readVarint() != RECORD_VERSION) return(false);
+      char text[100];
+      reader->readString(text, sizeof(text));
+      name = text;
+      keys.clear();
+      while (reader->isValid() && !reader->isDone()) {
+        LoggerRecordKey key;
+        key.idx = (int) reader->readSigned();
+        reader->readString(text, sizeof(text));
+        key.key = text;
+        reader->readString(text, sizeof(text));
+        key.units = text;
+        keys.push_back(key);
+      }
+      has_header = reader->isValid();
+      return(has_header);
+    }
+
+    // value text exactly as print_to_decimals printed it
+    void readValue(LoggerRecordReader* reader, bool is_steps, int decimals, char* target, int size) {
+      if (is_steps) print_decimal_steps(target, size, (double) reader->readSigned(), decimals);
+      else print_to_decimals(target, size, reader->readDouble(), decimals);
+    }
+
+    bool decodeDataLog(LoggerRecordReader* reader, std::string* json, std::vector<std::string>* csv) {
+
+      // log fields
+      time_t epoch = (time_t) reader->readVarint();
+      unsigned long long common_time = reader->readVarint();
+      char date_time[30];
+      struct tm calendar;
+      gmtime_r(&epoch, &calendar);
+      strftime(date_time, sizeof(date_time), DECODER_DATE_TIME_FORMAT, &calendar);
+
+      // data (same text as LoggerData::assembleLog)
+      std::string data;
+      while (reader->isValid() && !reader->isDone()) {
+        int idx = (int) reader->readSigned();
+        int n = (int) reader->readVarint();
+        int decimals = (int) reader->readSigned();
+        uint8_t flags = reader->read();
+        char value[20], sigma[20];
+        readValue(reader, flags & RECORD_VALUE_STEPS, decimals, value, sizeof(value));
+        sigma[0] = 0;
+        if (n > 1) readValue(reader, flags & RECORD_SIGMA_STEPS, decimals, sigma, sizeof(sigma));
+        unsigned long time_offset = common_time > 0 ? (unsigned long) (common_time - 1) : (unsigned long) reader->readVarint();
+        if (!reader->isValid()) return(false);
+
+        const LoggerRecordKey* key = findKey(idx);
+        char* k = (char*) key->key.c_str();
+        char* u = (char*) key->units.c_str();
+        char item[100];
+        if (n > 1 && common_time > 0)
+          getInfoIdxKeyValueSigmaUnitsNumberTimeOffset(item, sizeof(item), idx, k, value, sigma, u, n, -1, PATTERN_IKVSUN_JSON);
+        else if (n > 1)
+          getInfoIdxKeyValueSigmaUnitsNumberTimeOffset(item, sizeof(item), idx, k, value, sigma, u, n, time_offset, PATTERN_IKVSUNT_JSON);
+        else if (common_time > 0)
+          getInfoIdxKeyValueUnitsNumberTimeOffset(item, sizeof(item), idx, k, value, u, n, -1, PATTERN_IKVUN_JSON);
+        else
+          getInfoIdxKeyValueUnitsNumberTimeOffset(item, sizeof(item), idx, k, value, u, n, time_offset, PATTERN_IKVUNT_JSON);
+        if (!data.empty()) data += ",";
+        data += item;
+
+        if (csv) {
+          char row[300];
+          snprintf(row, sizeof(row), "%s,%s,%d,%s,%s,%s,%s,%d,%lu", date_time, name.c_str(), idx, k, value, sigma, u, n, time_offset);
+          csv->push_back(row);
+        }
+      }
+
+      // log (same text as LoggerController::finalizeDataLog)
+      if (json) {
+        std::vector<char> log(data.length() + name.length() + 100);
+        (common_time > 0) ?
+          snprintf(log.data(), log.size(), PATTERN_DATA_LOG_TO_JSON, name.c_str(), date_time, (unsigned long) (common_time - 1), data.c_str()) :
+          snprintf(log.data(), log.size(), PATTERN_DATA_LOG_JSON, name.c_str(), date_time, data.c_str());
+        *json = log.data();
+      }
+      return(true);
+    }
+
+  public:
+
+    // decode one record
+    // @return whether it was a valid record, json/csv are only filled for data logs
+    bool decode(const uint8_t* record, size_t length, std::string* json, std::vector<std::string>* csv = 0) {
+      if (json) json->clear();
+      LoggerRecordReader reader(record, length);
+      uint8_t type = reader.read();
+      if (type == RECORD_HEADER) return(decodeHeader(&reader));
+      if (type == RECORD_DATA_LOG) return(decodeDataLog(&reader, json, csv));
+      return(false);
+    }
+
+    // whether a header was decoded (data logs before a header have no keys and units)
+    bool hasHeader() const { return(has_header); }
+
+};
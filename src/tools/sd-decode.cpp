@@ -0,0 +1,71 @@
+/**
+ * Decodes binary data log files from the SD card (B<YYMMDD><part>.BIN, sd-format binary) on a computer.
+ * Prints the data logs as JSON lines (same as the D<YYMMDD><part>.LOG files of sd-format json) or as CSV.
+ *
+ * usage: sd-decode [--csv] FILE...
+ *  --csv  one row per data instead of one JSON line per data log
+ */
+
+#include "LoggerRecordDecoder.h"
+#include <string.h>
+
+static bool decodeFile(const char* path, LoggerRecordDecoder* decoder, bool csv) {
+
+  FILE* file = fopen(path, "rb");
+  if (file == 0) {
+    fprintf(stderr, "ERROR: could not open '%s'\n", path);
+    return(false);
+  }
+  std::vector<uint8_t> content;
+  uint8_t chunk[4096];
+  for (size_t n; (n = fread(chunk, 1, sizeof(chunk), file)) > 0;) content.insert(content.end(), chunk, chunk + n);
+  fclose(file);
+
+  // frame by frame (skip bytes that are not the start of a valid frame)
+  uint8_t record[RECORD_MAX_SIZE + 32];
+  std::string json;
+  std::vector<std::string> rows;
+  size_t pos = 0, skipped = 0, logs = 0;
+  while (pos < content.size()) {
+    size_t record_length = 0;
+    size_t frame_length = LoggerRecordReader::decodeFrame(content.data() + pos, content.size() - pos, record, sizeof(record), &record_length);
+    rows.clear();
+    if (frame_length == 0 || !decoder->decode(record, record_length, &json, csv ? &rows : 0)) {
+      pos++;
+      skipped++;
+      continue;
+    }
+    pos += frame_length;
+    if (!json.empty()) {
+      logs++;
+      if (!decoder->hasHeader()) fprintf(stderr, "WARNING: data log in '%s' before any header (keys and units unknown)\n", path);
+      if (csv) for (std::string& row : rows) printf("%s\n", row.c_str());
+      else printf("%s\n", json.c_str());
+    }
+  }
+  if (skipped > 0) fprintf(stderr, "WARNING: skipped %zu bytes that are not valid records in '%s'\n", skipped, path);
+  fprintf(stderr, "INFO: decoded %zu data logs from '%s'\n", logs, path);
+  return(skipped == 0);
+}
+
+int main(int argc, char** argv) {
+  bool csv = false;
+  std::vector<const char*> files;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--csv") == 0) csv = true;
+    else files.push_back(argv[i]);
+  }
+  if (files.empty()) {
+    fprintf(stderr, "usage: %s [--csv] FILE...\n", argv[0]);
+    return(1);
+  }
+
+  // header carries over to the next file (e.g. parts of the same day)
+  LoggerRecordDecoder decoder;
+  bool success = true;
+  if (csv) printf("%s\n", DECODER_CSV_HEADER);
+  for (const char* file : files) {
+    if (!decodeFile(file, &decoder, csv)) success = false;
+  }
+  return(success ? 0 : 2);
+}